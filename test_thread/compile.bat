@@ -2,7 +2,7 @@
 
 REM 编译动态链接库
 echo Compiling dynamic link library...
-g++ -shared -o thread_manager.dll thread_manager.cpp -D DLL_EXPORTS
+g++ -shared -o thread_manager.dll thread_manager.cpp thread_log.cpp timer_service.cpp cpu_topology.cpp shm_thread_manager.cpp thread.cpp task_scheduler.cpp parallel.cpp thread_manager_pthread.cpp -D DLL_EXPORTS
 
 if %errorlevel% neq 0 (
     echo Failed to compile dynamic link library!
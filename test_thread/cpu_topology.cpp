@@ -0,0 +1,216 @@
+#include "cpu_topology.h"
+#include <thread>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+namespace {
+
+// 读取sysfs文件的第一行，失败时返回false
+bool readLine(const std::string& path, std::string& line) {
+    std::ifstream file(path.c_str());
+    if (!file) {
+        return false;
+    }
+    return static_cast<bool>(std::getline(file, line));
+}
+
+// 读取整数文件，失败时返回-1
+int readInt(const std::string& path) {
+    std::string line;
+    if (!readLine(path, line) || line.empty()) {
+        return -1;
+    }
+    return std::atoi(line.c_str());
+}
+
+// 解析CPU列表（例如“0-3,8-11”）
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> result;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::atoi(range.substr(0, dash).c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.substr(dash + 1).c_str());
+        for (int cpu = first; cpu <= last; ++cpu) {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+
+// 读取CPU列表文件中编号最小的CPU，失败时返回-1
+int firstCpuOfList(const std::string& path) {
+    std::string line;
+    if (!readLine(path, line)) {
+        return -1;
+    }
+    std::vector<int> list = parseCpuList(line);
+    return list.empty() ? -1 : list[0];
+}
+
+} // namespace
+
+// 静态实例初始化
+CpuTopology* CpuTopology::instance = new CpuTopology();
+
+// 构造函数
+CpuTopology::CpuTopology() {
+    load();
+}
+
+// 获取单例实例
+CpuTopology* CpuTopology::getInstance() {
+    return instance;
+}
+
+// 从sysfs读取拓扑
+void CpuTopology::load() {
+    // CPU数量：可能存在的最大编号 + 1（包括暂时离线的CPU，它们上线后编号不变）
+    size_t count = 0;
+    std::string possible;
+    if (readLine("/sys/devices/system/cpu/possible", possible)) {
+        std::vector<int> list = parseCpuList(possible);
+        if (!list.empty()) {
+            count = static_cast<size_t>(list.back()) + 1;
+        }
+    }
+    if (count == 0) {
+        count = std::thread::hardware_concurrency();
+        if (count == 0) {
+            count = 1;
+        }
+    }
+    
+    // 默认：同一个节点上互不共享缓存的核
+    cpus.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        cpus[i].cpu = static_cast<int>(i);
+        cpus[i].core = static_cast<int>(i);
+        cpus[i].llc = static_cast<int>(i);
+        cpus[i].node = 0;
+        cpus[i].package = 0;
+    }
+
+#ifdef __linux__
+    for (size_t i = 0; i < count; ++i) {
+        std::ostringstream base;
+        base << "/sys/devices/system/cpu/cpu" << i;
+        const std::string dir = base.str();
+        
+        int package = readInt(dir + "/topology/physical_package_id");
+        if (package >= 0) {
+            cpus[i].package = package;
+        }
+        
+        // 同一物理核上的超线程（新内核为core_cpus_list，旧内核为thread_siblings_list）
+        int core = firstCpuOfList(dir + "/topology/core_cpus_list");
+        if (core < 0) {
+            core = firstCpuOfList(dir + "/topology/thread_siblings_list");
+        }
+        if (core >= 0) {
+            cpus[i].core = core;
+        }
+        
+        // 最后一级缓存：级别最高的统一缓存或数据缓存
+        int bestLevel = 0;
+        for (int index = 0; ; ++index) {
+            std::ostringstream cache;
+            cache << dir << "/cache/index" << index;
+            int level = readInt(cache.str() + "/level");
+            if (level < 0) {
+                break;
+            }
+            std::string type;
+            readLine(cache.str() + "/type", type);
+            if (type == "Instruction" || level <= bestLevel) {
+                continue;
+            }
+            int llc = firstCpuOfList(cache.str() + "/shared_cpu_list");
+            if (llc >= 0) {
+                bestLevel = level;
+                cpus[i].llc = llc;
+            }
+        }
+    }
+    
+    // NUMA节点：遍历/sys/devices/system/node/node*/cpulist
+    DIR* nodes = opendir("/sys/devices/system/node");
+    if (nodes != NULL) {
+        struct dirent* entry;
+        while ((entry = readdir(nodes)) != NULL) {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                continue;
+            }
+            int node = std::atoi(name.c_str() + 4);
+            std::string list;
+            if (!readLine("/sys/devices/system/node/" + name + "/cpulist", list)) {
+                continue;
+            }
+            std::vector<int> members = parseCpuList(list);
+            for (size_t k = 0; k < members.size(); ++k) {
+                if (members[k] >= 0 && static_cast<size_t>(members[k]) < count) {
+                    cpus[members[k]].node = node;
+                }
+            }
+        }
+        closedir(nodes);
+    }
+#endif
+}
+
+// 指定CPU的位置
+CpuLocation CpuTopology::locationOf(int cpu) const {
+    if (cpu < 0 || static_cast<size_t>(cpu) >= cpus.size()) {
+        return CpuLocation();
+    }
+    return cpus[cpu];
+}
+
+// 调用线程当前所在的CPU
+int CpuTopology::currentCpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// 两个位置之间的距离
+CpuDistance CpuTopology::distance(const CpuLocation& a, const CpuLocation& b) {
+    if (a.cpu < 0 || b.cpu < 0) {
+        return kRemote;
+    }
+    if (a.core == b.core) {
+        return kSameCore;
+    }
+    if (a.llc == b.llc) {
+        return kSameLlc;
+    }
+    if (a.node == b.node) {
+        return kSameNode;
+    }
+    return kRemote;
+}
+
+// 指定NUMA节点上的全部CPU
+std::vector<int> CpuTopology::cpusOfNode(int node) const {
+    std::vector<int> result;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        if (cpus[i].node == node) {
+            result.push_back(static_cast<int>(i));
+        }
+    }
+    return result;
+}
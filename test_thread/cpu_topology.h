@@ -0,0 +1,74 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <vector>
+#include <cstddef>
+
+#if defined(_WIN32)
+#ifdef DLL_EXPORTS
+#define DLL_API __declspec(dllexport)
+#else
+#define DLL_API __declspec(dllimport)
+#endif
+#else
+#define DLL_API
+#endif
+
+// 一个CPU在拓扑中的位置，各字段为对应层级的编号，-1表示未知
+// core/llc取共享该层级的CPU中编号最小的一个，在整个系统内唯一（不同插槽上相同的core_id不会混淆）
+struct CpuLocation {
+    int cpu;        // 逻辑CPU编号
+    int core;       // 物理核（超线程共享）
+    int llc;        // 最后一级缓存
+    int node;       // NUMA节点
+    int package;    // 物理插槽
+    
+    CpuLocation() : cpu(-1), core(-1), llc(-1), node(-1), package(-1) {}
+};
+
+// 两个位置之间的距离，数值越小越近
+enum CpuDistance {
+    kSameCore = 0,  // 同一个物理核（包括同一个逻辑CPU）
+    kSameLlc = 1,   // 共享最后一级缓存
+    kSameNode = 2,  // 同一个NUMA节点
+    kRemote = 3     // 其他节点，或位置未知
+};
+
+// CPU拓扑（Linux下启动时从/sys/devices/system读取一次，之后只读）
+// 其他平台或sysfs不可用时，所有CPU视为同一个节点上互不共享缓存的核
+class DLL_API CpuTopology {
+public:
+    static CpuTopology* getInstance();
+    
+    // 逻辑CPU数量（编号范围[0, cpuCount())）
+    size_t cpuCount() const { return cpus.size(); }
+    
+    // 指定CPU的位置，编号超出范围时返回未知位置
+    CpuLocation locationOf(int cpu) const;
+    
+    // 调用线程当前所在的CPU（Linux下为sched_getcpu()），未知时返回-1
+    static int currentCpu();
+    
+    // 调用线程当前所在CPU的位置
+    CpuLocation currentLocation() const { return locationOf(currentCpu()); }
+    
+    // 两个位置之间的距离
+    static CpuDistance distance(const CpuLocation& a, const CpuLocation& b);
+    
+    // 指定NUMA节点上的全部CPU（用于按节点绑定）
+    std::vector<int> cpusOfNode(int node) const;
+    
+private:
+    CpuTopology();
+    CpuTopology(const CpuTopology&) = delete;
+    CpuTopology& operator=(const CpuTopology&) = delete;
+    
+    // 从sysfs读取拓扑，失败的字段保持默认值
+    void load();
+    
+    static CpuTopology* instance;
+    
+    std::vector<CpuLocation> cpus;
+};
+
+#endif // CPU_TOPOLOGY_H
@@ -0,0 +1,112 @@
+#ifndef BENCH_BACKEND_H
+#define BENCH_BACKEND_H
+
+// 基准测试的后端适配层：三个线程管理器的类名/全局函数互相冲突，不能链接进同一个程序，
+// 因此每个基准测试按后端分别编译一次，编译时用宏选择后端：
+//   BENCH_BACKEND_THREAD_MANAGER   上层目录的ThreadManager（按注册句柄唤醒）
+//   BENCH_BACKEND_PTHREAD          上层目录的ThreadManagerPthread（按注册句柄唤醒）
+//   BENCH_BACKEND_LINUX            本目录的ThreadManager（按pthread_t唤醒）
+
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(BENCH_BACKEND_THREAD_MANAGER)
+
+#include "../thread_manager.h"
+
+struct BenchBackend {
+    typedef ParkHandle Target;
+    
+    static const char* name() { return "ThreadManager"; }
+    
+    // 在当前线程内注册，返回唤醒目标
+    static Target registerSelf(const std::string& threadName) {
+        return ThreadManager::getInstance()->registerThread(threadName, std::this_thread::get_id());
+    }
+    
+    static void unregisterSelf() {
+        ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+    }
+    
+    // 自旋模式：每次Sleep()先固定自旋spinNanos纳秒；不支持时返回false
+    static bool setSpin(uint32_t spinNanos) {
+        ThreadManager::getInstance()->setSpinPolicy(SpinPolicy(SpinPolicy::kFixedSpin, spinNanos, 0));
+        return true;
+    }
+    
+    static void sleep() { Sleep(); }
+    static void wakeup(Target target) { Wakeup(target); }
+    static void wakeup(const std::string& threadName) { Wakeup(threadName); }
+};
+
+#elif defined(BENCH_BACKEND_PTHREAD)
+
+#include "../thread_manager_pthread.h"
+
+struct BenchBackend {
+    typedef ParkHandle Target;
+    
+    static const char* name() { return "ThreadManagerPthread"; }
+    
+    static Target registerSelf(const std::string& threadName) {
+        return ThreadManagerPthread::getInstance()->registerThread(threadName, pthread_self());
+    }
+    
+    static void unregisterSelf() {
+        ThreadManagerPthread::getInstance()->unregisterThread(pthread_self());
+    }
+    
+    static bool setSpin(uint32_t spinNanos) {
+        ThreadManagerPthread::getInstance()->setSpinPolicy(SpinPolicy(SpinPolicy::kFixedSpin, spinNanos, 0));
+        return true;
+    }
+    
+    static void sleep() { SleepPthread(); }
+    static void wakeup(Target target) { WakeupPthread(target); }
+    static void wakeup(const std::string& threadName) { WakeupPthread(threadName); }
+};
+
+#elif defined(BENCH_BACKEND_LINUX)
+
+#include "thread_manager.h"
+
+struct BenchBackend {
+    typedef pthread_t Target;
+    
+    static const char* name() { return "linux/ThreadManager"; }
+    
+    static Target registerSelf(const std::string& threadName) {
+        ThreadManager::getInstance()->registerThread(threadName, pthread_self());
+        return pthread_self();
+    }
+    
+    static void unregisterSelf() {
+        ThreadManager::getInstance()->unregisterThread(pthread_self());
+    }
+    
+    // 本目录的ThreadManager没有自旋阶段
+    static bool setSpin(uint32_t) {
+        return false;
+    }
+    
+    static void sleep() { Sleep(); }
+    static void wakeup(Target target) { Wakeup(target); }
+    static void wakeup(const std::string& threadName) { Wakeup(threadName); }
+};
+
+#else
+#error "Define one of BENCH_BACKEND_THREAD_MANAGER, BENCH_BACKEND_PTHREAD, BENCH_BACKEND_LINUX"
+#endif
+
+// 把当前线程绑定到指定CPU，失败返回false
+inline bool benchPinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#endif // BENCH_BACKEND_H
@@ -0,0 +1,415 @@
+// 吞吐量基准测试：在Sleep()/Wakeup()全局函数之上，测量不同场景下每秒完成的唤醒次数随线程数的变化
+//
+// 场景：
+//   pairs     N/2对线程互相唤醒（乒乓）
+//   fanout    1个生产者轮流唤醒N个消费者
+//   fanin     N个生产者唤醒同1个消费者
+//   alltoall  N个线程之间随机传递N/2个令牌，每次传递唤醒接收者
+//
+// 所有场景都用“令牌”描述一次唤醒：发送方把接收方的pending置位后调用Wakeup()，
+// 接收方在pending未置位时调用Sleep()，被唤醒后清除pending并计数。计数即完成的唤醒次数。
+// 不带许可语义的后端在接收方检查pending和进入睡眠之间到达的唤醒会被丢弃，由看门狗线程每毫秒
+// 检查一次长时间未被消费的令牌并补发唤醒，补发次数单独输出（rescues），数值大说明后端在丢失唤醒。
+//
+// 默认按线程名唤醒，测量的是注册表查找加唤醒的总开销；--wake-by=target改为按句柄/线程ID唤醒。
+//
+// 用法：bench_throughput_<backend> [--scenarios=pairs,fanout,fanin,alltoall] [--threads=1,2,4,...]
+//                                  [--duration-ms=N] [--wake-by=name|target] [--format=csv|json]
+
+#include "bench_backend.h"
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+// 运行参数
+struct Options {
+    std::vector<std::string> scenarios;
+    std::vector<int> threadCounts;
+    int durationMillis;
+    bool wakeByName;
+    bool json;
+    
+    Options() : durationMillis(1000), wakeByName(true), json(false) {}
+};
+
+// 看门狗检查间隔
+const int kWatchdogMicros = 1000;
+
+// 每个参与线程的令牌槽，按缓存行对齐，避免测到伪共享
+struct alignas(64) Slot {
+    std::atomic<bool> pending{false};       // 令牌已送达，尚未被消费
+    std::atomic<uint64_t> consumed{0};      // 已消费的令牌数（完成的唤醒次数）
+    std::atomic<bool> registered{false};
+    std::atomic<bool> exited{false};
+    BenchBackend::Target target;
+    std::string name;
+    uint64_t watchdogSeen;                  // 看门狗上一次看到的consumed（只由看门狗读写）
+};
+
+// 一次测量的共享状态
+struct Run {
+    std::vector<Slot> slots;
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> rescues{0};
+    bool wakeByName;
+    
+    Run(size_t count, bool wakeByName) : slots(count), wakeByName(wakeByName) {}
+};
+
+std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* p = text; ; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            item += *p;
+        }
+    }
+    return items;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--scenarios=", 12) == 0) {
+            options.scenarios = splitList(arg + 12);
+        } else if (strncmp(arg, "--threads=", 10) == 0) {
+            std::vector<std::string> counts = splitList(arg + 10);
+            for (size_t j = 0; j < counts.size(); ++j) {
+                options.threadCounts.push_back(atoi(counts[j].c_str()));
+            }
+        } else if (strncmp(arg, "--duration-ms=", 14) == 0) {
+            options.durationMillis = atoi(arg + 14);
+        } else if (strcmp(arg, "--wake-by=name") == 0) {
+            options.wakeByName = true;
+        } else if (strcmp(arg, "--wake-by=target") == 0) {
+            options.wakeByName = false;
+        } else if (strcmp(arg, "--format=csv") == 0) {
+            options.json = false;
+        } else if (strcmp(arg, "--format=json") == 0) {
+            options.json = true;
+        } else {
+            fprintf(stderr, "Error: unknown option: %s\n", arg);
+            return false;
+        }
+    }
+    
+    if (options.scenarios.empty()) {
+        options.scenarios = splitList("pairs,fanout,fanin,alltoall");
+    }
+    for (size_t i = 0; i < options.scenarios.size(); ++i) {
+        const std::string& s = options.scenarios[i];
+        if (s != "pairs" && s != "fanout" && s != "fanin" && s != "alltoall") {
+            fprintf(stderr, "Error: unknown scenario: %s\n", s.c_str());
+            return false;
+        }
+    }
+    
+    // 默认线程数：1、2、4……直到CPU核数的2倍（包含核数本身）
+    if (options.threadCounts.empty()) {
+        int cores = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+        if (cores < 1) {
+            cores = 1;
+        }
+        for (int n = 1; n < cores * 2; n *= 2) {
+            options.threadCounts.push_back(n);
+            if (n < cores && n * 2 > cores) {
+                options.threadCounts.push_back(cores);
+            }
+        }
+        options.threadCounts.push_back(cores * 2);
+    }
+    for (size_t i = 0; i < options.threadCounts.size(); ++i) {
+        if (options.threadCounts[i] < 1) {
+            fprintf(stderr, "Error: thread counts must be positive\n");
+            return false;
+        }
+    }
+    if (options.durationMillis <= 0) {
+        fprintf(stderr, "Error: --duration-ms must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+// 唤醒槽位所属线程
+void wake(Run& run, Slot& slot) {
+    if (run.wakeByName) {
+        BenchBackend::wakeup(slot.name);
+    } else {
+        BenchBackend::wakeup(slot.target);
+    }
+}
+
+// 送达令牌：只有pending从false变为true的一方负责唤醒，返回是否送达
+bool giveToken(Run& run, Slot& slot) {
+    bool expected = false;
+    if (!slot.pending.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        return false;
+    }
+    wake(run, slot);
+    return true;
+}
+
+// 等待并消费自己的令牌，测量结束时返回false
+bool takeToken(Run& run, Slot& slot) {
+    while (!slot.pending.load(std::memory_order_acquire)) {
+        if (run.stop.load(std::memory_order_acquire)) {
+            return false;
+        }
+        BenchBackend::sleep();
+    }
+    slot.pending.store(false, std::memory_order_release);
+    slot.consumed.fetch_add(1, std::memory_order_relaxed);
+    return !run.stop.load(std::memory_order_acquire);
+}
+
+// 所有参与线程的公共入口：注册、等待开始、执行场景、注销
+template <typename Body>
+void participant(Run& run, size_t index, Body body) {
+    Slot& slot = run.slots[index];
+    slot.target = BenchBackend::registerSelf(slot.name);
+    slot.registered.store(true, std::memory_order_release);
+    while (!run.go.load(std::memory_order_acquire)) {
+        sched_yield();
+    }
+    body(slot);
+    BenchBackend::unregisterSelf();
+    slot.exited.store(true, std::memory_order_release);
+}
+
+// 看门狗：补发长时间未被消费的令牌（丢失的唤醒），测量结束后持续唤醒所有线程直到它们退出
+void watchdog(Run& run) {
+    while (!run.stop.load(std::memory_order_acquire)) {
+        usleep(kWatchdogMicros);
+        for (size_t i = 0; i < run.slots.size(); ++i) {
+            Slot& slot = run.slots[i];
+            uint64_t consumed = slot.consumed.load(std::memory_order_relaxed);
+            if (slot.pending.load(std::memory_order_acquire) && consumed == slot.watchdogSeen) {
+                wake(run, slot);
+                run.rescues.fetch_add(1, std::memory_order_relaxed);
+            }
+            slot.watchdogSeen = consumed;
+        }
+    }
+    
+    for (;;) {
+        bool allExited = true;
+        for (size_t i = 0; i < run.slots.size(); ++i) {
+            if (!run.slots[i].exited.load(std::memory_order_acquire)) {
+                allExited = false;
+                BenchBackend::wakeup(run.slots[i].target);
+            }
+        }
+        if (allExited) {
+            break;
+        }
+        usleep(100);
+    }
+}
+
+// 执行一次测量，返回完成的唤醒次数
+struct Result {
+    uint64_t wakeups;
+    uint64_t rescues;
+    double seconds;
+};
+
+Result measure(const std::string& scenario, int threads, const Options& options, int runId) {
+    // 参与线程数：pairs至少一对，fanout/fanin额外一个生产者/消费者，alltoall至少两个
+    size_t count;
+    if (scenario == "pairs") {
+        count = threads < 2 ? 2 : static_cast<size_t>(threads / 2 * 2);
+    } else if (scenario == "alltoall") {
+        count = threads < 2 ? 2 : static_cast<size_t>(threads);
+    } else {
+        count = static_cast<size_t>(threads) + 1;
+    }
+    
+    Run run(count, options.wakeByName);
+    for (size_t i = 0; i < count; ++i) {
+        run.slots[i].name = "bench_" + scenario + "_" + std::to_string(runId) + "_" + std::to_string(i);
+        run.slots[i].watchdogSeen = 0;
+    }
+    
+    std::vector<std::thread> workers;
+    if (scenario == "pairs") {
+        // 偶数号线程持有初始令牌，与下一个线程互相传递
+        for (size_t i = 0; i < count; ++i) {
+            if (i % 2 == 0) {
+                run.slots[i].pending.store(true, std::memory_order_relaxed);
+            }
+            workers.emplace_back([&run, i]() {
+                participant(run, i, [&run, i](Slot& self) {
+                    Slot& peer = run.slots[i ^ 1];
+                    while (takeToken(run, self)) {
+                        giveToken(run, peer);
+                    }
+                });
+            });
+        }
+    } else if (scenario == "fanout") {
+        // 0号线程是生产者，轮流给已消费完令牌的消费者送达新令牌，自己从不睡眠
+        workers.emplace_back([&run, count]() {
+            participant(run, 0, [&run, count](Slot&) {
+                size_t next = 1;
+                while (!run.stop.load(std::memory_order_acquire)) {
+                    bool delivered = false;
+                    for (size_t k = 1; k < count; ++k) {
+                        delivered |= giveToken(run, run.slots[next]);
+                        next = next + 1 < count ? next + 1 : 1;
+                    }
+                    if (!delivered) {
+                        sched_yield();
+                    }
+                }
+            });
+        });
+        for (size_t i = 1; i < count; ++i) {
+            workers.emplace_back([&run, i]() {
+                participant(run, i, [&run](Slot& self) {
+                    while (takeToken(run, self)) {
+                    }
+                });
+            });
+        }
+    } else if (scenario == "fanin") {
+        // 0号线程是消费者，其余生产者竞争给它送达令牌，自己从不睡眠
+        workers.emplace_back([&run]() {
+            participant(run, 0, [&run](Slot& self) {
+                while (takeToken(run, self)) {
+                }
+            });
+        });
+        for (size_t i = 1; i < count; ++i) {
+            workers.emplace_back([&run, i]() {
+                participant(run, i, [&run](Slot&) {
+                    while (!run.stop.load(std::memory_order_acquire)) {
+                        if (!giveToken(run, run.slots[0])) {
+                            sched_yield();
+                        }
+                    }
+                });
+            });
+        }
+    } else {
+        // count/2个令牌在所有线程之间随机传递
+        for (size_t i = 0; i < count; ++i) {
+            if (i < count / 2) {
+                run.slots[i].pending.store(true, std::memory_order_relaxed);
+            }
+            workers.emplace_back([&run, i, count]() {
+                participant(run, i, [&run, i, count](Slot& self) {
+                    std::minstd_rand rng(static_cast<unsigned>(i + 1));
+                    while (takeToken(run, self)) {
+                        // 随机选择一个没有令牌的其他线程，找不到就留给自己
+                        bool delivered = false;
+                        for (size_t attempt = 0; attempt < count && !delivered; ++attempt) {
+                            size_t target = rng() % count;
+                            if (target != i) {
+                                delivered = giveToken(run, run.slots[target]);
+                            }
+                        }
+                        if (!delivered) {
+                            self.pending.store(true, std::memory_order_release);
+                        }
+                    }
+                });
+            });
+        }
+    }
+    
+    // 等待所有线程完成注册后同时开始
+    for (size_t i = 0; i < count; ++i) {
+        while (!run.slots[i].registered.load(std::memory_order_acquire)) {
+            sched_yield();
+        }
+    }
+    std::thread guard(watchdog, std::ref(run));
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    run.go.store(true, std::memory_order_release);
+    usleep(static_cast<useconds_t>(options.durationMillis) * 1000);
+    
+    // 测量窗口结束时的计数（停止过程中的唤醒不计入）
+    uint64_t wakeups = 0;
+    for (size_t i = 0; i < count; ++i) {
+        wakeups += run.slots[i].consumed.load(std::memory_order_relaxed);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t rescues = run.rescues.load(std::memory_order_relaxed);
+    run.stop.store(true, std::memory_order_release);
+    
+    guard.join();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    
+    Result result;
+    result.wakeups = wakeups;
+    result.rescues = rescues;
+    result.seconds = seconds;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    
+    if (options.json) {
+        printf("[\n");
+    } else {
+        printf("backend,scenario,threads,wake_by,wakeups,seconds,wakeups_per_sec,rescues\n");
+    }
+    
+    int runId = 0;
+    bool first = true;
+    for (size_t s = 0; s < options.scenarios.size(); ++s) {
+        for (size_t t = 0; t < options.threadCounts.size(); ++t) {
+            const std::string& scenario = options.scenarios[s];
+            int threads = options.threadCounts[t];
+            Result result = measure(scenario, threads, options, runId++);
+            double rate = result.wakeups / result.seconds;
+            const char* wakeBy = options.wakeByName ? "name" : "target";
+            
+            if (options.json) {
+                printf("%s  {\"backend\": \"%s\", \"scenario\": \"%s\", \"threads\": %d, \"wake_by\": \"%s\", "
+                       "\"wakeups\": %llu, \"seconds\": %.6f, \"wakeups_per_sec\": %.1f, \"rescues\": %llu}",
+                       first ? "" : ",\n", BenchBackend::name(), scenario.c_str(), threads, wakeBy,
+                       static_cast<unsigned long long>(result.wakeups), result.seconds, rate,
+                       static_cast<unsigned long long>(result.rescues));
+            } else {
+                printf("%s,%s,%d,%s,%llu,%.6f,%.1f,%llu\n", BenchBackend::name(), scenario.c_str(), threads, wakeBy,
+                       static_cast<unsigned long long>(result.wakeups), result.seconds, rate,
+                       static_cast<unsigned long long>(result.rescues));
+            }
+            fflush(stdout);
+            first = false;
+        }
+    }
+    
+    if (options.json) {
+        printf("\n]\n");
+    }
+    return 0;
+}
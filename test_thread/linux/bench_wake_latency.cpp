@@ -0,0 +1,243 @@
+// 唤醒延迟基准测试：测量从Wakeup()返回到被唤醒线程恢复运行的时间
+//
+// 一个唤醒线程和一个睡眠线程轮流进行：睡眠线程宣告第i轮后调用Sleep()；唤醒线程等待宣告后，
+// 再等待一段稳定时间（让睡眠线程真正进入阻塞或自旋阶段），记录调用Wakeup()前后的时间戳；
+// 睡眠线程从Sleep()返回后立即记录时间戳并应答。
+// 延迟 = 恢复时间戳 - Wakeup()返回时间戳（睡眠线程先于Wakeup()返回恢复时记为0），
+// 同时单独统计Wakeup()调用本身的耗时。
+//
+// 不带许可语义的后端在目标尚未睡眠时会丢弃唤醒，此时唤醒线程在超时后重发，该轮样本作废并计入lost。
+//
+// 用法：bench_wake_latency_<backend> [--iterations=N] [--warmup=N] [--mode=park|spin]
+//                                    [--spin-us=N] [--settle-us=N] [--pin] [--cpus=A,B]
+
+#include "bench_backend.h"
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// 运行参数
+struct Options {
+    uint64_t iterations;    // 记录的样本数
+    uint64_t warmup;        // 预热轮数（不记录）
+    bool spin;              // 自旋模式（否则直接阻塞）
+    uint32_t spinMicros;    // 自旋模式下每次Sleep()的自旋时长
+    uint32_t settleMicros;  // 每轮唤醒之前的稳定时间
+    bool pin;               // 是否绑定CPU
+    int wakerCpu;
+    int sleeperCpu;
+    
+    Options() : iterations(1000000), warmup(10000), spin(false), spinMicros(200), settleMicros(0),
+                pin(false), wakerCpu(0), sleeperCpu(1) {}
+};
+
+// 等待应答的超时时间，超时后认为唤醒丢失并重发
+const uint64_t kAckTimeoutNanos = 10 * 1000 * 1000;
+
+inline uint64_t nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 两个线程之间共享的状态，分别按缓存行对齐，避免测到伪共享
+struct alignas(64) SharedState {
+    alignas(64) std::atomic<uint64_t> ready{UINT64_MAX};   // 睡眠线程宣告即将睡眠的轮次
+    alignas(64) std::atomic<uint64_t> ack{UINT64_MAX};     // 睡眠线程已恢复的轮次
+    std::atomic<uint64_t> resumeNanos{0};                  // 睡眠线程恢复时的时间戳
+    alignas(64) std::atomic<bool> targetReady{false};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> exited{false};
+    BenchBackend::Target target;
+};
+
+SharedState shared;
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--iterations=", 13) == 0) {
+            options.iterations = strtoull(arg + 13, NULL, 10);
+        } else if (strncmp(arg, "--warmup=", 9) == 0) {
+            options.warmup = strtoull(arg + 9, NULL, 10);
+        } else if (strcmp(arg, "--mode=park") == 0) {
+            options.spin = false;
+        } else if (strcmp(arg, "--mode=spin") == 0) {
+            options.spin = true;
+        } else if (strncmp(arg, "--spin-us=", 10) == 0) {
+            options.spinMicros = static_cast<uint32_t>(strtoul(arg + 10, NULL, 10));
+        } else if (strncmp(arg, "--settle-us=", 12) == 0) {
+            options.settleMicros = static_cast<uint32_t>(strtoul(arg + 12, NULL, 10));
+        } else if (strcmp(arg, "--pin") == 0) {
+            options.pin = true;
+        } else if (strncmp(arg, "--cpus=", 7) == 0) {
+            if (sscanf(arg + 7, "%d,%d", &options.wakerCpu, &options.sleeperCpu) != 2) {
+                fprintf(stderr, "Error: invalid --cpus value: %s\n", arg + 7);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Error: unknown option: %s\n", arg);
+            return false;
+        }
+    }
+    if (options.iterations == 0) {
+        fprintf(stderr, "Error: --iterations must be positive\n");
+        return false;
+    }
+    // 默认稳定时间：阻塞模式下留足时间让睡眠线程真正阻塞；自旋模式下要短于自旋时长，让唤醒落在自旋阶段
+    if (options.settleMicros == 0) {
+        options.settleMicros = options.spin ? 1 : 50;
+    }
+    return true;
+}
+
+// 等待一段时间：让出CPU而不是空转，单CPU时睡眠线程也能运行到阻塞点
+void settle(uint64_t nanos) {
+    const uint64_t deadline = nowNanos() + nanos;
+    while (nowNanos() < deadline) {
+        sched_yield();
+    }
+}
+
+// 睡眠线程
+void sleeperMain(const Options& options) {
+    if (options.pin && !benchPinCurrentThread(options.sleeperCpu)) {
+        fprintf(stderr, "Warning: failed to pin sleeper to CPU %d\n", options.sleeperCpu);
+    }
+    
+    shared.target = BenchBackend::registerSelf("bench_sleeper");
+    shared.targetReady.store(true, std::memory_order_release);
+    
+    for (uint64_t round = 0; ; ++round) {
+        shared.ready.store(round, std::memory_order_release);
+        BenchBackend::sleep();
+        uint64_t resumed = nowNanos();
+        if (shared.stop.load(std::memory_order_acquire)) {
+            break;
+        }
+        shared.resumeNanos.store(resumed, std::memory_order_relaxed);
+        shared.ack.store(round, std::memory_order_release);
+    }
+    
+    BenchBackend::unregisterSelf();
+    shared.exited.store(true, std::memory_order_release);
+}
+
+// 等待睡眠线程应答第round轮，超时返回false
+bool waitAck(uint64_t round) {
+    const uint64_t deadline = nowNanos() + kAckTimeoutNanos;
+    while (shared.ack.load(std::memory_order_acquire) != round) {
+        if (nowNanos() >= deadline) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+// 计算百分位（samples已排序）
+uint64_t percentile(const std::vector<uint64_t>& samples, double p) {
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+void report(const char* label, std::vector<uint64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        sum += static_cast<double>(samples[i]);
+    }
+    printf("  %-8s mean=%.0f p50=%llu p99=%llu p99.9=%llu max=%llu (ns)\n", label,
+           sum / samples.size(),
+           static_cast<unsigned long long>(percentile(samples, 0.50)),
+           static_cast<unsigned long long>(percentile(samples, 0.99)),
+           static_cast<unsigned long long>(percentile(samples, 0.999)),
+           static_cast<unsigned long long>(samples.back()));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    
+    if (options.spin && !BenchBackend::setSpin(options.spinMicros * 1000)) {
+        fprintf(stderr, "Error: backend %s has no spin mode\n", BenchBackend::name());
+        return 1;
+    }
+    
+    if (options.pin && !benchPinCurrentThread(options.wakerCpu)) {
+        fprintf(stderr, "Warning: failed to pin waker to CPU %d\n", options.wakerCpu);
+    }
+    
+    std::thread sleeper(sleeperMain, std::cref(options));
+    while (!shared.targetReady.load(std::memory_order_acquire)) {
+        sched_yield();
+    }
+    
+    std::vector<uint64_t> wakeSamples;
+    std::vector<uint64_t> callSamples;
+    wakeSamples.reserve(options.iterations);
+    callSamples.reserve(options.iterations);
+    uint64_t lost = 0;
+    
+    const uint64_t settleNanos = static_cast<uint64_t>(options.settleMicros) * 1000;
+    const uint64_t rounds = options.warmup + options.iterations;
+    for (uint64_t round = 0; round < rounds; ++round) {
+        while (shared.ready.load(std::memory_order_acquire) != round) {
+            sched_yield();
+        }
+        settle(settleNanos);
+        
+        uint64_t before = nowNanos();
+        BenchBackend::wakeup(shared.target);
+        uint64_t after = nowNanos();
+        
+        // 唤醒丢失（睡眠线程在唤醒到达时还没有进入睡眠）：重发直到应答，该轮样本作废
+        if (!waitAck(round)) {
+            ++lost;
+            do {
+                BenchBackend::wakeup(shared.target);
+            } while (!waitAck(round));
+            continue;
+        }
+        
+        if (round >= options.warmup) {
+            uint64_t resumed = shared.resumeNanos.load(std::memory_order_relaxed);
+            wakeSamples.push_back(resumed > after ? resumed - after : 0);
+            callSamples.push_back(after - before);
+        }
+    }
+    
+    // 通知睡眠线程退出：持续唤醒直到它确认退出
+    shared.stop.store(true, std::memory_order_release);
+    while (!shared.exited.load(std::memory_order_acquire)) {
+        BenchBackend::wakeup(shared.target);
+        sched_yield();
+    }
+    sleeper.join();
+    
+    printf("backend=%s mode=%s pinned=%s samples=%llu lost=%llu settle_us=%u",
+           BenchBackend::name(), options.spin ? "spin" : "park", options.pin ? "yes" : "no",
+           static_cast<unsigned long long>(wakeSamples.size()), static_cast<unsigned long long>(lost),
+           options.settleMicros);
+    if (options.spin) {
+        printf(" spin_us=%u", options.spinMicros);
+    }
+    printf("\n");
+    
+    if (wakeSamples.empty()) {
+        fprintf(stderr, "Error: no samples recorded\n");
+        return 1;
+    }
+    report("wake", wakeSamples);
+    report("call", callSamples);
+    return 0;
+}
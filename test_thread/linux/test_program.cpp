@@ -1,8 +1,21 @@
 #include "thread_manager.h"
 #include <iostream>
+#include <atomic>
+#include <string>
 #include <pthread.h>
 #include <unistd.h>
 
+// 失败的检查数（作为程序的返回值）
+static int failedChecks = 0;
+
+// 检查结果并输出
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "[PASS] " : "[FAIL] ") << description << std::endl;
+    if (!condition) {
+        failedChecks++;
+    }
+}
+
 // 子线程函数
 void* workerThreadFunc(void* arg) {
     std::string threadName = *static_cast<std::string*>(arg);
@@ -26,6 +39,139 @@ void* workerThreadFunc(void* arg) {
     return NULL;
 }
 
+// 槽位增长测试：同时注册的线程数超过一个槽位块（64个）
+static const int kGrowThreads = 200;
+static std::string growNames[kGrowThreads];
+static std::atomic<bool> growWoken[kGrowThreads];
+static std::atomic<int> growRegistered(0);
+
+// 槽位增长测试的子线程：注册后睡眠一次
+void* growWorkerFunc(void* arg) {
+    long index = reinterpret_cast<long>(arg);
+    ThreadManager::getInstance()->registerThread(growNames[index], pthread_self());
+    growRegistered++;
+    Sleep();
+    growWoken[index] = true;
+    ThreadManager::getInstance()->unregisterThread(pthread_self());
+    return NULL;
+}
+
+// 测试4：注册200个线程（需要分配多个槽位块），按线程名全部唤醒
+void testSlotGrowth() {
+    std::cout << "\n=== Test 4: Registering more threads than one slot chunk ===" << std::endl;
+    
+    pthread_t threads[kGrowThreads];
+    int created = 0;
+    for (int i = 0; i < kGrowThreads; ++i) {
+        growNames[i] = "Grow" + std::to_string(i);
+        growWoken[i] = false;
+    }
+    for (; created < kGrowThreads; ++created) {
+        if (pthread_create(&threads[created], NULL, growWorkerFunc, reinterpret_cast<void*>(static_cast<long>(created))) != 0) {
+            break;
+        }
+    }
+    check(created == kGrowThreads, "200 worker threads are created");
+    
+    // 等待全部线程注册（最多10秒）
+    for (int waited = 0; growRegistered < created && waited < 10000; ++waited) {
+        usleep(1000);
+    }
+    check(growRegistered == created, "all worker threads register");
+    
+    // 未睡眠时到达的唤醒会被丢弃，重复唤醒尚未醒来的线程（最多10秒）
+    int woken = 0;
+    for (int round = 0; round < 10000; ++round) {
+        woken = 0;
+        for (int i = 0; i < created; ++i) {
+            if (growWoken[i]) {
+                woken++;
+            } else {
+                Wakeup(growNames[i]);
+            }
+        }
+        if (woken == created) {
+            break;
+        }
+        usleep(1000);
+    }
+    for (int i = 0; i < created; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    check(woken == created, "all worker threads are woken by name");
+}
+
+// 线程名索引测试中一个线程的状态
+struct NamedThreadState {
+    std::atomic<bool> registered{false};
+    std::atomic<bool> woken{false};
+};
+
+// 以"Named"注册后睡眠一次（注册被拒绝时Sleep()立即返回）
+void* namedThreadFunc(void* arg) {
+    NamedThreadState* state = static_cast<NamedThreadState*>(arg);
+    ThreadManager::getInstance()->registerThread("Named", pthread_self());
+    state->registered = true;
+    Sleep();
+    state->woken = true;
+    ThreadManager::getInstance()->unregisterThread(pthread_self());
+    return NULL;
+}
+
+// 等待标志被设置，超时返回false
+bool waitFlag(const std::atomic<bool>& flag, int timeoutMillis) {
+    for (int waited = 0; !flag && waited < timeoutMillis; ++waited) {
+        usleep(1000);
+    }
+    return flag;
+}
+
+// 重复唤醒直到线程醒来（未睡眠时到达的唤醒会被丢弃），超时返回false
+template <typename Name>
+bool wakeUntil(const Name& threadName, const std::atomic<bool>& woken) {
+    for (int round = 0; !woken && round < 5000; ++round) {
+        Wakeup(threadName);
+        usleep(1000);
+    }
+    return woken;
+}
+
+// 测试5：线程名索引：重复的线程名被拒绝，注销后可以用同一个线程名重新注册，按字符串字面量和std::string唤醒
+void testNameIndex() {
+    std::cout << "\n=== Test 5: Thread name index ===" << std::endl;
+    
+    NamedThreadState owner;
+    pthread_t ownerThread;
+    pthread_create(&ownerThread, NULL, namedThreadFunc, &owner);
+    waitFlag(owner.registered, 5000);
+    
+    // 第二个线程使用同一个线程名：注册被拒绝，它的Sleep()立即返回
+    NamedThreadState duplicate;
+    pthread_t duplicateThread;
+    pthread_create(&duplicateThread, NULL, namedThreadFunc, &duplicate);
+    bool rejected = waitFlag(duplicate.woken, 2000);
+    if (!rejected) {
+        Wakeup(duplicateThread);
+    }
+    pthread_join(duplicateThread, NULL);
+    check(rejected, "a duplicate thread name is rejected");
+    
+    // 线程名仍然指向第一个线程
+    std::string name = "Named";
+    bool ownerWoken = wakeUntil(name, owner.woken);
+    pthread_join(ownerThread, NULL);
+    check(ownerWoken, "Wakeup(std::string) wakes the thread that owns the name");
+    
+    // 注销后索引中不再保留旧的键，同一个线程名可以重新注册并被唤醒
+    NamedThreadState successor;
+    pthread_t successorThread;
+    pthread_create(&successorThread, NULL, namedThreadFunc, &successor);
+    waitFlag(successor.registered, 5000);
+    bool successorWoken = wakeUntil("Named", successor.woken);
+    pthread_join(successorThread, NULL);
+    check(successorWoken, "a name registered again after unregistration is woken by a string literal");
+}
+
 int main() {
     std::cout << "Main thread started" << std::endl;
     
@@ -78,6 +224,9 @@ int main() {
     pthread_join(worker3, NULL);
     pthread_join(worker4, NULL);
     
-    std::cout << "\nMain thread exited" << std::endl;
-    return 0;
+    testSlotGrowth();
+    testNameIndex();
+    
+    std::cout << "\nMain thread exited, " << failedChecks << " checks failed" << std::endl;
+    return failedChecks == 0 ? 0 : 1;
 }
\ No newline at end of file
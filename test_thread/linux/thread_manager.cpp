@@ -1,12 +1,50 @@
 #include "thread_manager.h"
 #include <unistd.h>
 #include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <iostream>
-#include <memory>
+#include <new>
 #include <atomic>
+#include <cstdlib>
 #include <pthread.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// 信息日志（注册、注销以及每次睡眠和唤醒）：定义THREAD_LOG_DISABLE时在编译期移除（参数仍做类型检查，但不会求值）；
+// THREAD_INFO_LOG_ENABLED用于跳过只为日志准备的参数（如复制线程名）；
+// 错误日志不受影响，仍然直接写std::cerr
+#ifdef THREAD_LOG_DISABLE
+#define THREAD_INFO_LOG(expr) do { if (false) { std::cout << expr << std::endl; } } while (0)
+#define THREAD_INFO_LOG_ENABLED false
+#else
+#define THREAD_INFO_LOG(expr) do { std::cout << expr << std::endl; } while (0)
+#define THREAD_INFO_LOG_ENABLED true
+#endif
+
+namespace {
+
+// 睡眠字的最低位：1表示睡眠中，等待Wakeup；0表示已唤醒（或从未睡眠）
+// 其余各位为槽位代数，每次注销加一（即睡眠字加2）
+const uint32_t kSleepingBit = 1;
+const uint32_t kGenerationStep = 2;
+
+// 直接在睡眠字上进行futex等待，不需要任何互斥锁
+// 睡眠字的值不等于expected时立即返回；被信号中断（EINTR）或虚假唤醒时由调用者重新检查
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+// 唤醒一个在睡眠字上等待的线程
+void futexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+// 睡眠字中的槽位代数部分
+uint32_t generationBits(uint32_t word) {
+    return word & ~kSleepingBit;
+}
+
+} // namespace
 
 // 静态实例初始化
 ThreadManager* ThreadManager::instance = new ThreadManager();
@@ -14,11 +52,44 @@ ThreadManager* ThreadManager::instance = new ThreadManager();
 // 构造函数
 ThreadManager::ThreadManager() {
     // std::mutex会自动初始化，不需要手动操作
+    
+    // 预先分配第一个槽位块，之后按需增长（这里分配失败时注册会再次尝试）
+    nameIndex.reserve(kSlotChunkSize);
+    growSlots();
 }
 
 // 析构函数
 ThreadManager::~ThreadManager() {
-    // std::mutex和std::condition_variable会自动销毁，不需要手动清理
+    for (size_t chunk = 0; chunk < slotChunks.size(); ++chunk) {
+        for (uint32_t i = 0; i < kSlotChunkSize; ++i) {
+            slotChunks[chunk][i].~ThreadInfo();
+        }
+        free(slotChunks[chunk]);
+    }
+}
+
+// 分配一个新的槽位块
+bool ThreadManager::growSlots() {
+    // 按缓存行对齐分配，已有的槽位块不移动，其中线程的槽位地址保持不变
+    void* memory = NULL;
+    int ret = posix_memalign(&memory, alignof(ThreadInfo), sizeof(ThreadInfo) * kSlotChunkSize);
+    if (ret != 0) {
+        std::cerr << "Error: posix_memalign failed for thread slots: " << ret << std::endl;
+        return false;
+    }
+    ThreadInfo* chunk = static_cast<ThreadInfo*>(memory);
+    for (uint32_t i = 0; i < kSlotChunkSize; ++i) {
+        new (&chunk[i]) ThreadInfo();
+    }
+    
+    uint32_t base = static_cast<uint32_t>(slotChunks.size()) * kSlotChunkSize;
+    slotChunks.push_back(chunk);
+    
+    // 空闲列表按后进先出使用，下标小的槽位先被分配，刚注销的槽位（缓存中较热）优先复用
+    for (uint32_t i = kSlotChunkSize; i > 0; --i) {
+        freeSlots.push_back(base + i - 1);
+    }
+    return true;
 }
 
 // 获取单例实例
@@ -26,18 +97,33 @@ ThreadManager* ThreadManager::getInstance() {
     return instance;
 }
 
-// 辅助方法：通过线程名查找线程ID
-pthread_t ThreadManager::findThreadIdByName(const std::string& threadName) {
-    for (const auto& pair : threadMap) {
-        if (pair.second.name == threadName) {
-            return pair.first;
-        }
+// 辅助方法：通过线程名查找槽位
+bool ThreadManager::findSlotByName(std::string_view threadName, size_t nameHash, uint32_t& index) const {
+    auto it = nameIndex.find(NameKey(threadName, nameHash));
+    if (it == nameIndex.end()) {
+        return false;
+    }
+    index = it->second;
+    return true;
+}
+
+// 唤醒指定代数的线程：一次CAS加一次FUTEX_WAKE，调用者无需持有任何锁
+bool ThreadManager::wakeThreadInfo(ThreadInfo& info, uint32_t generationBits) {
+    // 只有清除睡眠位的一方负责发出唤醒；线程未睡眠或槽位已被注销（代数不同）时不做任何事
+    uint32_t expected = generationBits | kSleepingBit;
+    if (!info.futexWord.compare_exchange_strong(expected, generationBits, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed)) {
+        return false;
     }
-    return 0; // 返回0表示未找到
+    futexWake(&info.futexWord);
+    return true;
 }
 
 // 注册线程
 void ThreadManager::registerThread(const std::string& threadName, pthread_t threadId) {
+    // 散列值在加锁之前计算
+    size_t nameHash = hashName(threadName);
+    
     // 使用std::lock_guard自动管理锁的生命周期
     std::lock_guard<std::mutex> lock(mapMutex);
     
@@ -48,53 +134,78 @@ void ThreadManager::registerThread(const std::string& threadName, pthread_t thre
     }
     
     // 检查线程名是否已存在
-    if (findThreadIdByName(threadName) != 0) {
+    uint32_t existing;
+    if (findSlotByName(threadName, nameHash, existing)) {
         std::cerr << "Error: Thread name already exists: " << threadName << std::endl;
         return;
     }
     
-    // 创建并初始化线程信息结构体
-    ThreadInfo info;
+    // 从空闲列表取出槽位，没有空闲槽位时分配新的槽位块
+    if (freeSlots.empty() && !growSlots()) {
+        std::cerr << "Error: No free thread slot for: " << threadName << std::endl;
+        return;
+    }
+    uint32_t index = freeSlots.back();
+    freeSlots.pop_back();
+    ThreadInfo& info = slotAt(index);
     info.name = threadName;
-    info.mutex = std::make_shared<std::mutex>();
-    info.cond = std::make_shared<std::condition_variable>();
+    info.nameHash = nameHash;
+    info.threadId = threadId;
     
-    // 添加到映射表
-    threadMap[threadId] = info;
+    // 添加到映射表和线程名索引（索引的键指向槽位中的线程名，线程名在注销之前不再修改）
+    threadMap[threadId] = index;
+    nameIndex.emplace(NameKey(info.name, nameHash), index);
     
-    std::cout << "Thread registered: " << threadName << " (ID: " << threadId << ")" << std::endl;
+    THREAD_INFO_LOG("Thread registered: " << threadName << " (ID: " << threadId << ")");
     // std::lock_guard会自动解锁
 }
 
 // 注销线程
 void ThreadManager::unregisterThread(pthread_t threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+    ThreadInfo* info;
+    std::string threadName;
+    uint32_t oldWord;
     
-    auto it = threadMap.find(threadId);
-    if (it != threadMap.end()) {
-        std::string threadName = it->second.name;
+    {
+        // 使用std::lock_guard自动管理锁的生命周期
+        std::lock_guard<std::mutex> lock(mapMutex);
         
-        // 从映射表中删除
-        threadMap.erase(it);
+        auto it = threadMap.find(threadId);
+        if (it == threadMap.end()) {
+            std::cerr << "Error: Thread not found for unregistration: ID " << threadId << std::endl;
+            return;
+        }
+        
+        uint32_t index = it->second;
+        info = &slotAt(index);
+        threadName = info->name;
+        nameIndex.erase(NameKey(info->name, info->nameHash));
         
-        // std::condition_variable和std::mutex会自动销毁
+        // 递增槽位代数并清除睡眠位：睡眠中的线程看到睡眠字变化后退出等待，旧代数的唤醒方CAS失败
+        uint32_t word = info->futexWord.load(std::memory_order_relaxed);
+        oldWord = info->futexWord.exchange(generationBits(word) + kGenerationStep, std::memory_order_acq_rel);
         
-        std::cout << "Thread unregistered: " << threadName << " (ID: " << threadId << ")" << std::endl;
-    } else {
-        std::cerr << "Error: Thread not found for unregistration: ID " << threadId << std::endl;
+        // 从映射表中删除，槽位归还空闲列表
+        threadMap.erase(it);
+        freeSlots.push_back(index);
+    } // 解锁映射表（std::lock_guard离开作用域）
+    
+    // 如果线程仍在睡眠，唤醒它，使其退出等待（槽位已被复用时新线程只会被虚假唤醒，重新检查后继续等待）
+    if (oldWord & kSleepingBit) {
+        futexWake(&info->futexWord);
     }
-    // std::lock_guard会自动解锁
+    
+    THREAD_INFO_LOG("Thread unregistered: " << threadName << " (ID: " << threadId << ")");
 }
 
 // Sleep函数实现，不需要参数
 void ThreadManager::Sleep() {
     pthread_t currentThreadId = pthread_self();
+    ThreadInfo* info;
     std::string threadName;
-    std::shared_ptr<std::mutex> mutex;
-    std::shared_ptr<std::condition_variable> cond;
+    uint32_t sleepingWord;
     
-    // 加锁保护映射表，获取信息并设置睡眠状态
+    // 加锁保护映射表，获取线程信息并设置睡眠状态
     {
         std::lock_guard<std::mutex> mapLock(mapMutex);
         
@@ -105,76 +216,87 @@ void ThreadManager::Sleep() {
             return;
         }
         
-        threadName = it->second.name;
-        mutex = it->second.mutex;
-        cond = it->second.cond;
-        it->second.sleeping = true;
+        info = &slotAt(it->second);
+        if (THREAD_INFO_LOG_ENABLED) {
+            threadName = info->name;
+        }
+        
+        // 槽位代数只在持有mapMutex时修改，这里读到的就是本次注册的代数
+        sleepingWord = generationBits(info->futexWord.load(std::memory_order_relaxed)) | kSleepingBit;
+        info->futexWord.store(sleepingWord, std::memory_order_release);
     } // 解锁映射表（std::lock_guard离开作用域）
     
-    // 加锁线程互斥锁
-    std::unique_lock<std::mutex> threadLock(*mutex);
+    THREAD_INFO_LOG(threadName << " is going to sleep...");
     
-    std::cout << threadName << " is going to sleep..." << std::endl;
-    
-    // 等待条件变量，使用lambda表达式作为谓词
-    // 注意：即使notify_one()在wait()之前被调用，谓词也会检查sleeping状态
-    // 如果sleeping已经是false，wait()会立即返回，不会丢失通知
-    cond->wait(threadLock, [this, currentThreadId]() {
-        std::lock_guard<std::mutex> mapLock(mapMutex);
-        auto it = threadMap.find(currentThreadId);
-        if (it == threadMap.end()) {
-            return true; // 线程已注销，退出等待
-        }
-        return !it->second.sleeping;
-    });
+    // 在睡眠字上等待，不持有任何互斥锁
+    // 注意：即使Wakeup()在futexWait()之前被调用，睡眠位已被清除，futexWait()会立即返回，不会丢失唤醒
+    // 被信号中断（EINTR）或虚假唤醒时，循环重新检查睡眠字；被注销时代数变化，同样退出等待
+    while (info->futexWord.load(std::memory_order_acquire) == sleepingWord) {
+        futexWait(&info->futexWord, sleepingWord);
+    }
     
-    std::cout << threadName << " is woken up!" << std::endl;
-    // std::unique_lock会自动解锁
+    THREAD_INFO_LOG(threadName << " is woken up!");
 }
 
 // 根据线程名唤醒线程
-void ThreadManager::Wakeup(const std::string& threadName) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+void ThreadManager::Wakeup(std::string_view threadName) {
+    pthread_t threadId;
+    ThreadInfo* info;
+    uint32_t generation;
+    uint32_t index;
     
-    // 查找线程ID（遍历map）
-    pthread_t threadId = findThreadIdByName(threadName);
-    if (threadId == 0) {
-        std::cerr << "Error: Thread not found: " << threadName << std::endl;
-        return;
-    }
+    // 散列值在加锁之前计算，持有锁时只做一次散列表查找
+    size_t nameHash = hashName(threadName);
     
-    // 检查线程是否在睡眠
-    auto it = threadMap.find(threadId);
-    if (it != threadMap.end() && it->second.sleeping) {
-        it->second.sleeping = false;
-        it->second.cond->notify_one(); // 通知等待的线程
-        std::cout << "Waking up thread: " << threadName << " (ID: " << threadId << ")" << std::endl;
+    {
+        // 使用std::lock_guard自动管理锁的生命周期
+        std::lock_guard<std::mutex> lock(mapMutex);
+        
+        // 通过线程名索引查找槽位
+        if (!findSlotByName(threadName, nameHash, index)) {
+            std::cerr << "Error: Thread not found: " << threadName << std::endl;
+            return;
+        }
+        
+        info = &slotAt(index);
+        threadId = info->threadId;
+        generation = generationBits(info->futexWord.load(std::memory_order_relaxed));
+    } // 解锁映射表，唤醒本身不持有任何锁（之后线程被注销时代数变化，唤醒被安全地忽略）
+    
+    // 检查线程是否在睡眠，是则唤醒
+    if (wakeThreadInfo(*info, generation)) {
+        THREAD_INFO_LOG("Waking up thread: " << threadName << " (ID: " << threadId << ")");
     }
-    // std::lock_guard会自动解锁
 }
 
 // 根据线程ID唤醒线程
 void ThreadManager::Wakeup(pthread_t threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
-    
-    // 检查线程是否已注册
-    auto it = threadMap.find(threadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not found: ID " << threadId << std::endl;
-        return;
-    }
+    ThreadInfo* info;
+    std::string threadName;
+    uint32_t generation;
     
-    std::string threadName = it->second.name;
+    {
+        // 使用std::lock_guard自动管理锁的生命周期
+        std::lock_guard<std::mutex> lock(mapMutex);
+        
+        // 检查线程是否已注册
+        auto it = threadMap.find(threadId);
+        if (it == threadMap.end()) {
+            std::cerr << "Error: Thread not found: ID " << threadId << std::endl;
+            return;
+        }
+        
+        info = &slotAt(it->second);
+        if (THREAD_INFO_LOG_ENABLED) {
+            threadName = info->name;
+        }
+        generation = generationBits(info->futexWord.load(std::memory_order_relaxed));
+    } // 解锁映射表，唤醒本身不持有任何锁（之后线程被注销时代数变化，唤醒被安全地忽略）
     
-    // 检查线程是否在睡眠
-    if (it->second.sleeping) {
-        it->second.sleeping = false;
-        it->second.cond->notify_one(); // 通知等待的线程
-        std::cout << "Waking up thread: " << threadName << " (ID: " << threadId << ")" << std::endl;
+    // 检查线程是否在睡眠，是则唤醒
+    if (wakeThreadInfo(*info, generation)) {
+        THREAD_INFO_LOG("Waking up thread: " << threadName << " (ID: " << threadId << ")");
     }
-    // std::lock_guard会自动解锁
 }
 
 // 全局Sleep函数
@@ -183,7 +305,7 @@ void Sleep() {
 }
 
 // 全局Wakeup函数（线程名）
-void Wakeup(const std::string& threadName) {
+void Wakeup(std::string_view threadName) {
     ThreadManager::getInstance()->Wakeup(threadName);
 }
 
@@ -2,19 +2,26 @@
 #define THREAD_MANAGER_H
 
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstddef>
 #include <map>
 #include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <iostream>
-#include <cerrno>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
 
 // 线程信息结构体，包含所有线程相关信息
-struct ThreadInfo {
-    std::string name;                                  // 线程名
-    std::shared_ptr<std::mutex> mutex;                // 互斥锁
-    std::shared_ptr<std::condition_variable> cond;    // 条件变量
-    bool sleeping{false};                              // 睡眠状态
+// 存放在管理器按块分配的槽位表中：每个槽位按缓存行对齐并填充，相邻线程的睡眠字不会共享缓存行；
+// 槽位块分配后不再移动，槽位地址在管理器生命周期内不变，注销后槽位被复用
+struct alignas(64) ThreadInfo {
+    std::atomic<uint32_t> futexWord{0};                // 睡眠字：高31位为槽位代数，最低位为1表示睡眠中，直接作为futex等待地址
+    std::string name;                                  // 线程名（持有mapMutex时读写），线程名索引的键直接指向它
+    size_t nameHash{0};                                // 线程名的散列值（注册时计算一次）
+    pthread_t threadId{};                              // 线程ID（持有mapMutex时读写）
 };
 
 class ThreadManager {
@@ -25,7 +32,8 @@ public:
     void Sleep();
     
     // 用户线程调用的Wakeup函数，可以传入线程名或线程id
-    void Wakeup(const std::string& threadName);
+    // 按线程名唤醒时通过散列索引查找（常数时间），传入字符串字面量或std::string都不会复制线程名
+    void Wakeup(std::string_view threadName);
     void Wakeup(pthread_t threadId);
     
     // 内部使用的方法，用于注册和注销线程
@@ -38,21 +46,65 @@ private:
     ThreadManager(const ThreadManager&) = delete;
     ThreadManager& operator=(const ThreadManager&) = delete;
     
+    // 每个槽位块的槽位数：空闲槽位用完时再分配一块，注册的线程数不设上限
+    static const uint32_t kSlotChunkSize = 64;
+    
+    // 唤醒指定代数的线程：一次CAS加一次FUTEX_WAKE，返回线程此前是否在睡眠
+    static bool wakeThreadInfo(ThreadInfo& info, uint32_t generationBits);
+    
     static ThreadManager* instance;
     
-    // 唯一的线程信息映射（主键：线程ID）
-    std::map<pthread_t, ThreadInfo> threadMap;
+    // 按块分配的槽位表（按缓存行对齐），注册时通常只从空闲列表取出槽位，不再为线程信息单独分配内存
+    // 注销时递增槽位代数：睡眠中的线程在被其他线程注销后看到睡眠字变化而返回，持有旧代数的唤醒方不会误唤醒复用槽位的新线程
+    std::vector<ThreadInfo*> slotChunks;
+    std::vector<uint32_t> freeSlots;
+    
+    // 按下标取槽位（持有mapMutex时调用）
+    ThreadInfo& slotAt(uint32_t index) {
+        return slotChunks[index / kSlotChunkSize][index % kSlotChunkSize];
+    }
+    
+    // 分配一个新的槽位块并把其中的槽位放入空闲列表（持有mapMutex时调用），分配失败时返回false
+    bool growSlots();
+    
+    // 唯一的线程信息映射（主键：线程ID，值：槽位下标）
+    std::map<pthread_t, uint32_t> threadMap;
     
-    // 保护映射表的互斥锁
+    // 保护映射表和空闲槽位列表的互斥锁（只保护查找，不参与睡眠和唤醒本身）
     std::mutex mapMutex;
     
-    // 辅助方法：通过线程名查找线程ID
-    pthread_t findThreadIdByName(const std::string& threadName);
+    // 线程名索引的键：指向槽位中线程名的视图和预先计算的散列值
+    // 线程名只在槽位中保存一份（驻留），索引不复制字符串；比较时先比较散列值，不同名字很少需要逐字节比较
+    struct NameKey {
+        std::string_view name;
+        size_t hash;
+        
+        NameKey(std::string_view name, size_t hash) : name(name), hash(hash) {}
+        
+        bool operator==(const NameKey& other) const {
+            return hash == other.hash && name == other.name;
+        }
+    };
+    
+    struct NameKeyHash {
+        size_t operator()(const NameKey& key) const { return key.hash; }
+    };
+    
+    // 线程名索引（主键：线程名，值：槽位下标），与threadMap同时维护
+    std::unordered_map<NameKey, uint32_t, NameKeyHash> nameIndex;
+    
+    // 线程名的散列值
+    static size_t hashName(std::string_view threadName) {
+        return std::hash<std::string_view>()(threadName);
+    }
+    
+    // 辅助方法：通过线程名查找槽位（持有mapMutex时调用），不存在时返回false
+    bool findSlotByName(std::string_view threadName, size_t nameHash, uint32_t& index) const;
 };
 
 // 方便用户使用的全局函数
 void Sleep();
-void Wakeup(const std::string& threadName);
+void Wakeup(std::string_view threadName);
 void Wakeup(pthread_t threadId);
 
 #endif // THREAD_MANAGER_H
\ No newline at end of file
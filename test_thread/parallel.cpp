@@ -0,0 +1,102 @@
+#include "parallel.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+// 一次并行执行的共享状态：辅助任务可能在全部块完成之后才开始运行，因此由shared_ptr持有
+struct ParallelJob {
+    std::atomic<size_t> next;           // 下一个待领取的块
+    std::atomic<size_t> remaining;      // 尚未完成的块数
+    size_t chunkCount;
+    const std::function<void(size_t)>* body;    // 只在还有块未完成时访问
+    
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done;
+    std::exception_ptr error;           // 第一个异常（由mutex保护）
+    
+    ParallelJob(size_t chunkCount, const std::function<void(size_t)>* body)
+        : next(0), remaining(chunkCount), chunkCount(chunkCount), body(body), done(false) {}
+};
+
+// 领取并执行块，直到没有剩余的块；完成最后一个块的线程通知调用线程
+static void runChunks(ParallelJob& job) {
+    size_t finished = 0;
+    for (;;) {
+        size_t chunk = job.next.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job.chunkCount) {
+            break;
+        }
+        try {
+            (*job.body)(chunk);
+        } catch (...) {
+            // 出错的块也计为完成，否则调用线程会一直等待
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+        }
+        finished++;
+    }
+    
+    if (finished != 0 && job.remaining.fetch_sub(finished, std::memory_order_acq_rel) == finished) {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.done = true;
+        job.cond.notify_all();
+    }
+}
+
+size_t parallel_chunk_count(TaskScheduler& scheduler, size_t length, size_t grain, ParallelChunking chunking) {
+    if (grain == 0) {
+        grain = 1;
+    }
+    size_t maxChunks = (length + grain - 1) / grain;
+    if (chunking == kChunkDynamic) {
+        return maxChunks;
+    }
+    
+    // 静态分块：每个参与线程（工作线程 + 调用线程）一块
+    size_t participants = scheduler.workerCount() + 1;
+    return participants < maxChunks ? participants : maxChunks;
+}
+
+void parallel_run(TaskScheduler& scheduler, size_t chunkCount, const std::function<void(size_t)>& body) {
+    if (chunkCount == 0) {
+        return;
+    }
+    
+    // 只有一块或没有工作线程时直接在调用线程执行，不产生任何唤醒
+    size_t helpers = scheduler.workerCount();
+    if (helpers > chunkCount - 1) {
+        helpers = chunkCount - 1;
+    }
+    if (helpers == 0) {
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            body(chunk);
+        }
+        return;
+    }
+    
+    std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>(chunkCount, &body);
+    
+    // 所需的辅助任务一次提交，空闲工作线程通过一次WakeupMany()唤醒
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(helpers);
+    for (size_t i = 0; i < helpers; ++i) {
+        tasks.push_back([job]() { runChunks(*job); });
+    }
+    scheduler.submitBatch(std::move(tasks));
+    
+    // 调用线程也参与执行，然后等待其他线程已领取的块完成
+    runChunks(*job);
+    
+    std::unique_lock<std::mutex> lock(job->mutex);
+    while (!job->done) {
+        job->cond.wait(lock);
+    }
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
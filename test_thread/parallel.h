@@ -0,0 +1,70 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include "task_scheduler.h"
+
+// 分块方式
+enum ParallelChunking {
+    kChunkStatic,   // 按参与线程数（工作线程 + 调用线程）均分，每块至少grain个元素；适合每个元素耗时相近的循环
+    kChunkDynamic   // 每块grain个元素，各线程执行完一块再领取下一块；适合耗时不均匀的循环
+};
+
+// 在调度器的工作线程上执行chunkCount个块：批量提交辅助任务并一次唤醒所需的空闲工作线程，
+// 调用线程也领取块执行，全部块完成后返回；块中抛出的第一个异常在返回前重新抛出
+// 在工作线程内调用（嵌套并行）时不会死锁：调用线程会自己执行所有尚未被领取的块
+DLL_API void parallel_run(TaskScheduler& scheduler, size_t chunkCount, const std::function<void(size_t)>& body);
+
+// 计算区间[begin, end)的分块数
+DLL_API size_t parallel_chunk_count(TaskScheduler& scheduler, size_t length, size_t grain, ParallelChunking chunking);
+
+// 并行执行fn(chunkBegin, chunkEnd)，各块覆盖区间[begin, end)且互不重叠
+template <typename Index, typename Fn>
+void parallel_for(TaskScheduler& scheduler, Index begin, Index end, size_t grain, Fn&& fn,
+                  ParallelChunking chunking = kChunkDynamic) {
+    if (!(begin < end)) {
+        return;
+    }
+    
+    size_t length = static_cast<size_t>(end - begin);
+    size_t chunkCount = parallel_chunk_count(scheduler, length, grain, chunking);
+    size_t chunkSize = (length + chunkCount - 1) / chunkCount;
+    chunkCount = (length + chunkSize - 1) / chunkSize;
+    
+    parallel_run(scheduler, chunkCount, [&](size_t chunk) {
+        size_t first = chunk * chunkSize;
+        size_t last = first + chunkSize < length ? first + chunkSize : length;
+        fn(begin + static_cast<Index>(first), begin + static_cast<Index>(last));
+    });
+}
+
+// 并行归约：每块计算map(chunkBegin, chunkEnd)，再由调用线程按块的顺序用reduce合并（结果与分块后的顺序执行一致）
+template <typename T, typename Index, typename Map, typename Reduce>
+T parallel_reduce(TaskScheduler& scheduler, Index begin, Index end, size_t grain, T identity, Map&& map,
+                  Reduce&& reduce, ParallelChunking chunking = kChunkDynamic) {
+    if (!(begin < end)) {
+        return identity;
+    }
+    
+    size_t length = static_cast<size_t>(end - begin);
+    size_t chunkCount = parallel_chunk_count(scheduler, length, grain, chunking);
+    size_t chunkSize = (length + chunkCount - 1) / chunkCount;
+    chunkCount = (length + chunkSize - 1) / chunkSize;
+    std::vector<T> partials(chunkCount, identity);
+    
+    parallel_run(scheduler, chunkCount, [&](size_t chunk) {
+        size_t first = chunk * chunkSize;
+        size_t last = first + chunkSize < length ? first + chunkSize : length;
+        partials[chunk] = map(begin + static_cast<Index>(first), begin + static_cast<Index>(last));
+    });
+    
+    T result = identity;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        result = reduce(result, partials[i]);
+    }
+    return result;
+}
+
+#endif // PARALLEL_H
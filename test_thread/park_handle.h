@@ -0,0 +1,33 @@
+#ifndef PARK_HANDLE_H
+#define PARK_HANDLE_H
+
+#include <cstdint>
+
+// 线程注册句柄：槽位下标 + 槽位代数
+// registerThread()返回该句柄，之后Sleep/Wakeup/注销可以直接通过句柄定位线程信息，不再查找注册表
+// 线程注销时槽位代数递增，旧句柄（例如pthread_t被复用后残留的句柄）会因代数不匹配而被安全拒绝
+struct ParkHandle {
+    uint32_t index;         // 槽位下标
+    uint32_t generation;    // 槽位代数，0表示无效句柄
+    
+    ParkHandle() : index(0), generation(0) {}
+    ParkHandle(uint32_t index, uint32_t generation) : index(index), generation(generation) {}
+    
+    bool valid() const { return generation != 0; }
+    
+    bool operator==(const ParkHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const ParkHandle& other) const {
+        return !(*this == other);
+    }
+};
+
+// 限时睡眠（SleepFor()/SleepUntil()）的醒来原因
+enum WakeReason {
+    kWakeNotified = 0,      // 被Wakeup()唤醒（包括消费了提前到达的许可）
+    kWakeTimeout = 1,       // 到达截止时间
+    kWakeUnregistered = 2   // 线程未注册或在睡眠期间被注销
+};
+
+#endif // PARK_HANDLE_H
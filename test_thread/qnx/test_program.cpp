@@ -1,7 +1,23 @@
 #include "thread_manager.h"
 #include <iostream>
+#include <atomic>
+#include <string>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// 失败的检查数（作为程序的返回值）
+static int failedChecks = 0;
+
+// 检查结果并输出
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "[PASS] " : "[FAIL] ") << description << std::endl;
+    if (!condition) {
+        failedChecks++;
+    }
+}
 
 // 子线程函数
 void* workerThreadFunc(void* arg) {
@@ -26,6 +42,233 @@ void* workerThreadFunc(void* arg) {
     return NULL;
 }
 
+// 槽位增长测试：同时注册的线程数超过一个槽位块（64个）
+static const int kGrowThreads = 200;
+static std::string growNames[kGrowThreads];
+static std::atomic<bool> growWoken[kGrowThreads];
+static std::atomic<int> growRegistered(0);
+
+// 槽位增长测试的子线程：注册后睡眠一次
+void* growWorkerFunc(void* arg) {
+    long index = reinterpret_cast<long>(arg);
+    ThreadManager::getInstance()->registerThread(growNames[index], pthread_self());
+    growRegistered++;
+    Sleep();
+    growWoken[index] = true;
+    ThreadManager::getInstance()->unregisterThread(pthread_self());
+    return NULL;
+}
+
+// 测试4：注册200个线程（需要分配多个槽位块），按线程名全部唤醒
+void testSlotGrowth() {
+    std::cout << "\n=== Test 4: Registering more threads than one slot chunk ===" << std::endl;
+    
+    pthread_t threads[kGrowThreads];
+    int created = 0;
+    for (int i = 0; i < kGrowThreads; ++i) {
+        growNames[i] = "Grow" + std::to_string(i);
+        growWoken[i] = false;
+    }
+    for (; created < kGrowThreads; ++created) {
+        if (pthread_create(&threads[created], NULL, growWorkerFunc, reinterpret_cast<void*>(static_cast<long>(created))) != 0) {
+            break;
+        }
+    }
+    check(created == kGrowThreads, "200 worker threads are created");
+    
+    // 等待全部线程注册（最多10秒）
+    for (int waited = 0; growRegistered < created && waited < 10000; ++waited) {
+        usleep(1000);
+    }
+    check(growRegistered == created, "all worker threads register");
+    
+    // 未睡眠时到达的唤醒会被丢弃，重复唤醒尚未醒来的线程（最多10秒）
+    int woken = 0;
+    for (int round = 0; round < 10000; ++round) {
+        woken = 0;
+        for (int i = 0; i < created; ++i) {
+            if (growWoken[i]) {
+                woken++;
+            } else {
+                Wakeup(growNames[i]);
+            }
+        }
+        if (woken == created) {
+            break;
+        }
+        usleep(1000);
+    }
+    for (int i = 0; i < created; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    check(woken == created, "all worker threads are woken by name");
+}
+
+// 线程名索引测试中一个线程的状态
+struct NamedThreadState {
+    std::atomic<bool> registered{false};
+    std::atomic<bool> woken{false};
+};
+
+// 以"Named"注册后睡眠一次（注册被拒绝时Sleep()立即返回）
+void* namedThreadFunc(void* arg) {
+    NamedThreadState* state = static_cast<NamedThreadState*>(arg);
+    ThreadManager::getInstance()->registerThread("Named", pthread_self());
+    state->registered = true;
+    Sleep();
+    state->woken = true;
+    ThreadManager::getInstance()->unregisterThread(pthread_self());
+    return NULL;
+}
+
+// 等待标志被设置，超时返回false
+bool waitFlag(const std::atomic<bool>& flag, int timeoutMillis) {
+    for (int waited = 0; !flag && waited < timeoutMillis; ++waited) {
+        usleep(1000);
+    }
+    return flag;
+}
+
+// 重复唤醒直到线程醒来（未睡眠时到达的唤醒会被丢弃），超时返回false
+template <typename Name>
+bool wakeUntil(const Name& threadName, const std::atomic<bool>& woken) {
+    for (int round = 0; !woken && round < 5000; ++round) {
+        Wakeup(threadName);
+        usleep(1000);
+    }
+    return woken;
+}
+
+// 测试5：线程名索引：重复的线程名被拒绝，注销后可以用同一个线程名重新注册，按字符串字面量和std::string唤醒
+void testNameIndex() {
+    std::cout << "\n=== Test 5: Thread name index ===" << std::endl;
+    
+    NamedThreadState owner;
+    pthread_t ownerThread;
+    pthread_create(&ownerThread, NULL, namedThreadFunc, &owner);
+    waitFlag(owner.registered, 5000);
+    
+    // 第二个线程使用同一个线程名：注册被拒绝，它的Sleep()立即返回
+    NamedThreadState duplicate;
+    pthread_t duplicateThread;
+    pthread_create(&duplicateThread, NULL, namedThreadFunc, &duplicate);
+    bool rejected = waitFlag(duplicate.woken, 2000);
+    if (!rejected) {
+        Wakeup(duplicateThread);
+    }
+    pthread_join(duplicateThread, NULL);
+    check(rejected, "a duplicate thread name is rejected");
+    
+    // 线程名仍然指向第一个线程
+    std::string name = "Named";
+    bool ownerWoken = wakeUntil(name, owner.woken);
+    pthread_join(ownerThread, NULL);
+    check(ownerWoken, "Wakeup(std::string) wakes the thread that owns the name");
+    
+    // 注销后索引中不再保留旧的键，同一个线程名可以重新注册并被唤醒
+    NamedThreadState successor;
+    pthread_t successorThread;
+    pthread_create(&successorThread, NULL, namedThreadFunc, &successor);
+    waitFlag(successor.registered, 5000);
+    bool successorWoken = wakeUntil("Named", successor.woken);
+    pthread_join(successorThread, NULL);
+    check(successorWoken, "a name registered again after unregistration is woken by a string literal");
+}
+
+// 实时调度测试中一个线程的注册选项和结果
+struct SchedThreadState {
+    const char* name;
+    RegisterOptions options;
+    std::atomic<bool> registered{false};
+    std::atomic<bool> woken{false};
+    int policy;
+    int priority;
+    
+    explicit SchedThreadState(const char* name) : name(name), policy(-1), priority(-1) {}
+};
+
+// 按注册选项注册，读取注册后自己的调度参数，再睡眠一次（注册被拒绝时Sleep()立即返回）
+void* schedThreadFunc(void* arg) {
+    SchedThreadState* state = static_cast<SchedThreadState*>(arg);
+    ThreadManager::getInstance()->registerThread(state->name, pthread_self(), state->options);
+    struct sched_param param;
+    pthread_getschedparam(pthread_self(), &state->policy, &param);
+    state->priority = param.sched_priority;
+    state->registered = true;
+    Sleep();
+    state->woken = true;
+    ThreadManager::getInstance()->unregisterThread(pthread_self());
+    return NULL;
+}
+
+// 运行一个按选项注册的线程，返回注册是否成功（线程睡眠后能按线程名被唤醒）
+bool runSchedThread(SchedThreadState& state) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, schedThreadFunc, &state) != 0) {
+        return false;
+    }
+    waitFlag(state.registered, 5000);
+    bool rejected = waitFlag(state.woken, 200);
+    bool woken = rejected || wakeUntil(state.name, state.woken);
+    pthread_join(thread, NULL);
+    return !rejected && woken;
+}
+
+// 测试6：实时调度：有权限时应用SCHED_FIFO，权限不足（EPERM）时保持原有调度参数，超出范围的优先级被拒绝
+void testScheduling() {
+    std::cout << "\n=== Test 6: Real-time scheduling ===" << std::endl;
+    
+    // 子线程默认继承主线程的调度参数
+    int defaultPolicy;
+    struct sched_param defaultParam;
+    pthread_getschedparam(pthread_self(), &defaultPolicy, &defaultParam);
+    const int minPriority = sched_get_priority_min(SCHED_FIFO);
+    const int maxPriority = sched_get_priority_max(SCHED_FIFO);
+    
+    // 当前进程：有权限时切换到SCHED_FIFO，没有权限时保持原有调度参数，注册都成功
+    SchedThreadState fifo("SchedFifo");
+    fifo.options.schedPolicy = SCHED_FIFO;
+    fifo.options.schedPriority = minPriority;
+    bool registered = runSchedThread(fifo);
+    bool applied = fifo.policy == SCHED_FIFO && fifo.priority == minPriority;
+    bool unchanged = fifo.policy == defaultPolicy && fifo.priority == defaultParam.sched_priority;
+    check(registered, "a thread registers with SCHED_FIFO");
+    check(applied || unchanged, applied ? "SCHED_FIFO is applied when permitted"
+                                        : "the policy is unchanged when SCHED_FIFO is not permitted");
+    
+    // 超出范围的优先级：注册被拒绝，调度参数不变
+    SchedThreadState invalid("SchedInvalid");
+    invalid.options.schedPolicy = SCHED_FIFO;
+    invalid.options.schedPriority = maxPriority + 1;
+    bool invalidRegistered = runSchedThread(invalid);
+    check(!invalidRegistered && invalid.policy == defaultPolicy && invalid.priority == defaultParam.sched_priority,
+          "an out-of-range real-time priority is rejected");
+    
+    // 放弃实时调度权限的子进程：pthread_setschedparam()返回EPERM，注册仍然成功，调度参数不变
+    // 此时只有主线程在运行，子进程中可以继续使用ThreadManager
+    pid_t pid = fork();
+    if (pid == 0) {
+#ifdef RLIMIT_RTPRIO
+        struct rlimit limit;
+        limit.rlim_cur = 0;
+        limit.rlim_max = 0;
+        setrlimit(RLIMIT_RTPRIO, &limit);
+#endif
+        if (geteuid() == 0 && setuid(65534) != 0) {
+            _exit(2);
+        }
+        SchedThreadState denied("SchedDenied");
+        denied.options.schedPolicy = SCHED_FIFO;
+        denied.options.schedPriority = minPriority;
+        bool ok = runSchedThread(denied) && denied.policy == defaultPolicy &&
+                  denied.priority == defaultParam.sched_priority;
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    bool deniedOk = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    check(deniedOk, "EPERM keeps the original policy and the registration still succeeds");
+}
+
 int main() {
     std::cout << "Main thread started" << std::endl;
     
@@ -78,6 +321,10 @@ int main() {
     pthread_join(worker3, NULL);
     pthread_join(worker4, NULL);
     
-    std::cout << "\nMain thread exited" << std::endl;
-    return 0;
+    testSlotGrowth();
+    testNameIndex();
+    testScheduling();
+    
+    std::cout << "\nMain thread exited, " << failedChecks << " checks failed" << std::endl;
+    return failedChecks == 0 ? 0 : 1;
 }
\ No newline at end of file
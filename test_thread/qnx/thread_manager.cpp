@@ -1,24 +1,169 @@
 #include "thread_manager.h"
 #include <unistd.h>
-#include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <iostream>
-#include <memory>
-#include <atomic>
+#include <new>
+#include <cstdlib>
 #include <pthread.h>
+#include <sched.h>
+
+// 信息日志（注册、注销以及每次睡眠和唤醒）：定义THREAD_LOG_DISABLE时在编译期移除（参数仍做类型检查，但不会求值）；
+// THREAD_INFO_LOG_ENABLED用于跳过只为日志准备的参数（如复制线程名）；
+// 错误日志不受影响，仍然直接写std::cerr
+#ifdef THREAD_LOG_DISABLE
+#define THREAD_INFO_LOG(expr) do { if (false) { std::cout << expr << std::endl; } } while (0)
+#define THREAD_INFO_LOG_ENABLED false
+#else
+#define THREAD_INFO_LOG(expr) do { std::cout << expr << std::endl; } while (0)
+#define THREAD_INFO_LOG_ENABLED true
+#endif
+
+namespace {
+
+// 初始化互斥锁：实时构建下使用优先级继承协议
+int initMutex(pthread_mutex_t* mutex) {
+    pthread_mutexattr_t attr;
+    int ret = pthread_mutexattr_init(&attr);
+    if (ret != 0) {
+        return ret;
+    }
+#ifdef THREAD_MANAGER_RT
+    ret = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+#endif
+    if (ret == 0) {
+        ret = pthread_mutex_init(mutex, &attr);
+    }
+    pthread_mutexattr_destroy(&attr);
+    return ret;
+}
+
+// 作用域内持有互斥锁（同std::lock_guard，用于pthread互斥锁）
+// 加锁失败时记录错误，调用者必须检查isLocked()并放弃本次操作，不能在未持有锁时进入临界区
+class MutexGuard {
+public:
+    explicit MutexGuard(pthread_mutex_t& mutex) : mutex(mutex), locked(false) {
+        int ret = pthread_mutex_lock(&mutex);
+        if (ret != 0) {
+            std::cerr << "Error: pthread_mutex_lock failed: " << ret << std::endl;
+            return;
+        }
+        locked = true;
+    }
+    
+    ~MutexGuard() {
+        if (!locked) {
+            return;
+        }
+        int ret = pthread_mutex_unlock(&mutex);
+        if (ret != 0) {
+            std::cerr << "Error: pthread_mutex_unlock failed: " << ret << std::endl;
+        }
+    }
+    
+    bool isLocked() const { return locked; }
+    
+private:
+    MutexGuard(const MutexGuard&);
+    MutexGuard& operator=(const MutexGuard&);
+    
+    pthread_mutex_t& mutex;
+    bool locked;
+};
+
+} // namespace
 
 // 静态实例初始化
 ThreadManager* ThreadManager::instance = new ThreadManager();
 
 // 构造函数
-ThreadManager::ThreadManager() {
-    // std::mutex会自动初始化，不需要手动操作
+ThreadManager::ThreadManager() : mapMutexInitialized(false) {
+    int ret = initMutex(&mapMutex);
+    if (ret != 0) {
+        std::cerr << "Error: pthread_mutex_init failed for mapMutex: " << ret << std::endl;
+        return;
+    }
+    mapMutexInitialized = true;
+    
+    // 预先分配第一个槽位块，之后按需增长（这里分配失败时注册会再次尝试）
+    nameIndex.reserve(kSlotChunkSize);
+    growSlots();
 }
 
 // 析构函数
 ThreadManager::~ThreadManager() {
-    // std::mutex和std::condition_variable会自动销毁，不需要手动清理
+    int ret;
+    
+    for (size_t chunk = 0; chunk < slotChunks.size(); ++chunk) {
+        ThreadInfo* table = slotChunks[chunk];
+        for (uint32_t i = 0; i < kSlotChunkSize; ++i) {
+            uint32_t index = static_cast<uint32_t>(chunk) * kSlotChunkSize + i;
+            ret = pthread_cond_destroy(&table[i].cond);
+            if (ret != 0) {
+                std::cerr << "Error: pthread_cond_destroy failed for slot " << index << ": " << ret << std::endl;
+            }
+            ret = pthread_mutex_destroy(&table[i].mutex);
+            if (ret != 0) {
+                std::cerr << "Error: pthread_mutex_destroy failed for slot " << index << ": " << ret << std::endl;
+            }
+            table[i].~ThreadInfo();
+        }
+        free(table);
+    }
+    
+    if (mapMutexInitialized) {
+        ret = pthread_mutex_destroy(&mapMutex);
+        if (ret != 0) {
+            std::cerr << "Error: pthread_mutex_destroy failed for mapMutex: " << ret << std::endl;
+        }
+    }
+}
+
+// 分配一个新的槽位块
+bool ThreadManager::growSlots() {
+    // 按缓存行对齐分配（C++11的new不保证超过默认对齐的对齐要求），已有的槽位块不移动
+    void* memory = NULL;
+    int ret = posix_memalign(&memory, alignof(ThreadInfo), sizeof(ThreadInfo) * kSlotChunkSize);
+    if (ret != 0) {
+        std::cerr << "Error: posix_memalign failed for thread slots: " << ret << std::endl;
+        return false;
+    }
+    ThreadInfo* table = static_cast<ThreadInfo*>(memory);
+    uint32_t base = static_cast<uint32_t>(slotChunks.size()) * kSlotChunkSize;
+    
+    // 初始化每个槽位的互斥锁和条件变量，失败时清理本块已初始化的槽位
+    uint32_t initialized = 0;
+    for (; initialized < kSlotChunkSize; ++initialized) {
+        ThreadInfo* info = new (&table[initialized]) ThreadInfo();
+        ret = initMutex(&info->mutex);
+        if (ret != 0) {
+            std::cerr << "Error: pthread_mutex_init failed for slot " << base + initialized << ": " << ret << std::endl;
+            info->~ThreadInfo();
+            break;
+        }
+        ret = pthread_cond_init(&info->cond, NULL);
+        if (ret != 0) {
+            std::cerr << "Error: pthread_cond_init failed for slot " << base + initialized << ": " << ret << std::endl;
+            pthread_mutex_destroy(&info->mutex);
+            info->~ThreadInfo();
+            break;
+        }
+    }
+    if (initialized < kSlotChunkSize) {
+        for (uint32_t i = 0; i < initialized; ++i) {
+            pthread_cond_destroy(&table[i].cond);
+            pthread_mutex_destroy(&table[i].mutex);
+            table[i].~ThreadInfo();
+        }
+        free(table);
+        return false;
+    }
+    slotChunks.push_back(table);
+    
+    // 空闲列表按后进先出使用，下标小的槽位先被分配，刚注销的槽位（缓存中较热）优先复用
+    for (uint32_t i = kSlotChunkSize; i > 0; --i) {
+        freeSlots.push_back(base + i - 1);
+    }
+    return true;
 }
 
 // 获取单例实例
@@ -26,77 +171,174 @@ ThreadManager* ThreadManager::getInstance() {
     return instance;
 }
 
-// 辅助方法：通过线程名查找线程ID
-pthread_t ThreadManager::findThreadIdByName(const std::string& threadName) {
-    for (const auto& pair : threadMap) {
-        if (pair.second.name == threadName) {
-            return pair.first;
-        }
+// 构造时映射表互斥锁是否初始化成功（失败时记录错误）
+bool ThreadManager::checkInitialized() const {
+    if (!mapMutexInitialized) {
+        std::cerr << "Error: ThreadManager is not initialized" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 辅助方法：通过线程名查找槽位
+bool ThreadManager::findSlotByName(std::string_view threadName, size_t nameHash, uint32_t& index) const {
+    auto it = nameIndex.find(NameKey(threadName, nameHash));
+    if (it == nameIndex.end()) {
+        return false;
+    }
+    index = it->second;
+    return true;
+}
+
+// 辅助方法：设置线程的调度策略和优先级
+void ThreadManager::applySchedParams(const std::string& threadName, pthread_t threadId,
+                                     const RegisterOptions& options) {
+    struct sched_param param;
+    param.sched_priority = options.schedPriority;
+    int ret = pthread_setschedparam(threadId, options.schedPolicy, &param);
+    if (ret == EPERM) {
+        // 没有实时调度权限（例如Linux下缺少CAP_SYS_NICE）：保持原有调度参数继续运行
+        std::cerr << "Warning: No permission for real-time scheduling, keeping default policy for: "
+                  << threadName << std::endl;
+    } else if (ret != 0) {
+        std::cerr << "Error: pthread_setschedparam failed for " << threadName << ": " << ret << std::endl;
     }
-    return 0; // 返回0表示未找到
 }
 
 // 注册线程
 void ThreadManager::registerThread(const std::string& threadName, pthread_t threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
-    
-    // 检查线程是否已存在（通过线程ID）
-    if (threadMap.find(threadId) != threadMap.end()) {
-        std::cerr << "Error: Thread already registered: ID " << threadId << std::endl;
+    registerThread(threadName, threadId, RegisterOptions());
+}
+
+// 注册线程（带注册选项）
+void ThreadManager::registerThread(const std::string& threadName, pthread_t threadId,
+                                   const RegisterOptions& options) {
+    // 实时策略先检查优先级范围，注册成功后再设置，避免注册失败时留下修改过的调度参数
+    bool realtime = options.schedPolicy == SCHED_FIFO || options.schedPolicy == SCHED_RR;
+    if (realtime && (options.schedPriority < sched_get_priority_min(options.schedPolicy) ||
+                     options.schedPriority > sched_get_priority_max(options.schedPolicy))) {
+        std::cerr << "Error: Invalid real-time priority " << options.schedPriority << " for: " << threadName << std::endl;
         return;
     }
     
-    // 检查线程名是否已存在
-    if (findThreadIdByName(threadName) != 0) {
-        std::cerr << "Error: Thread name already exists: " << threadName << std::endl;
+    if (!checkInitialized()) {
         return;
     }
     
-    // 创建并初始化线程信息结构体
-    ThreadInfo info;
-    info.name = threadName;
-    info.mutex = std::make_shared<std::mutex>();
-    info.cond = std::make_shared<std::condition_variable>();
+    // 散列值在加锁之前计算
+    size_t nameHash = hashName(threadName);
+    
+    {
+        // 使用MutexGuard自动管理锁的生命周期，加锁失败时放弃注册
+        MutexGuard lock(mapMutex);
+        if (!lock.isLocked()) {
+            return;
+        }
+        
+        // 检查线程是否已存在（通过线程ID）
+        if (threadMap.find(threadId) != threadMap.end()) {
+            std::cerr << "Error: Thread already registered: ID " << threadId << std::endl;
+            return;
+        }
+        
+        // 检查线程名是否已存在
+        uint32_t existing;
+        if (findSlotByName(threadName, nameHash, existing)) {
+            std::cerr << "Error: Thread name already exists: " << threadName << std::endl;
+            return;
+        }
+        
+        // 从空闲列表取出槽位，互斥锁和条件变量随槽位复用；没有空闲槽位时分配新的槽位块
+        if (freeSlots.empty() && !growSlots()) {
+            std::cerr << "Error: No free thread slot for: " << threadName << std::endl;
+            return;
+        }
+        uint32_t index = freeSlots.back();
+        freeSlots.pop_back();
+        ThreadInfo& info = slotAt(index);
+        info.name = threadName;
+        info.nameHash = nameHash;
+        info.threadId = threadId;
+        
+        // 添加到映射表和线程名索引（索引的键指向槽位中的线程名，线程名在注销之前不再修改）
+        threadMap[threadId] = index;
+        nameIndex.emplace(NameKey(info.name, nameHash), index);
+    } // 解锁映射表，设置调度参数和输出日志都不持有注册表锁
     
-    // 添加到映射表
-    threadMap[threadId] = info;
+    if (realtime) {
+        applySchedParams(threadName, threadId, options);
+    }
     
-    std::cout << "Thread registered: " << threadName << " (ID: " << threadId << ")" << std::endl;
-    // std::lock_guard会自动解锁
+    THREAD_INFO_LOG("Thread registered: " << threadName << " (ID: " << threadId << ")");
 }
 
 // 注销线程
 void ThreadManager::unregisterThread(pthread_t threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+    std::string threadName;
+    
+    if (!checkInitialized()) {
+        return;
+    }
     
-    auto it = threadMap.find(threadId);
-    if (it != threadMap.end()) {
-        std::string threadName = it->second.name;
+    {
+        // 使用MutexGuard自动管理锁的生命周期，加锁失败时放弃注销
+        MutexGuard lock(mapMutex);
+        if (!lock.isLocked()) {
+            return;
+        }
         
-        // 从映射表中删除
-        threadMap.erase(it);
+        auto it = threadMap.find(threadId);
+        if (it == threadMap.end()) {
+            std::cerr << "Error: Thread not found for unregistration: ID " << threadId << std::endl;
+            return;
+        }
         
-        // std::condition_variable和std::mutex会自动销毁
+        uint32_t index = it->second;
+        ThreadInfo& info = slotAt(index);
+        threadName = info.name;
         
-        std::cout << "Thread unregistered: " << threadName << " (ID: " << threadId << ")" << std::endl;
-    } else {
-        std::cerr << "Error: Thread not found for unregistration: ID " << threadId << std::endl;
-    }
-    // std::lock_guard会自动解锁
+        // 递增槽位代数，仍在睡眠的线程被唤醒后看到代数变化而退出等待
+        // 槽位互斥锁加锁失败时放弃注销，映射表和线程名索引保持不变
+        {
+            MutexGuard threadLock(info.mutex);
+            if (!threadLock.isLocked()) {
+                return;
+            }
+            nameIndex.erase(NameKey(info.name, info.nameHash));
+            info.generation++;
+            info.sleeping = false;
+            int ret = pthread_cond_broadcast(&info.cond);
+            if (ret != 0) {
+                std::cerr << "Error: pthread_cond_broadcast failed for " << threadName << ": " << ret << std::endl;
+            }
+        }
+        
+        // 从映射表中删除，槽位归还空闲列表
+        threadMap.erase(it);
+        freeSlots.push_back(index);
+    } // 解锁映射表
+    
+    THREAD_INFO_LOG("Thread unregistered: " << threadName << " (ID: " << threadId << ")");
 }
 
 // Sleep函数实现，不需要参数
 void ThreadManager::Sleep() {
     pthread_t currentThreadId = pthread_self();
     std::string threadName;
-    std::shared_ptr<std::mutex> mutex;
-    std::shared_ptr<std::condition_variable> cond;
+    ThreadInfo* info;
+    uint32_t generation;
+    int ret;
+    
+    if (!checkInitialized()) {
+        return;
+    }
     
-    // 加锁保护映射表，获取信息并设置睡眠状态
+    // 加锁保护映射表，获取信息并设置睡眠状态（任何一个锁加锁失败时不睡眠，直接返回）
     {
-        std::lock_guard<std::mutex> mapLock(mapMutex);
+        MutexGuard mapLock(mapMutex);
+        if (!mapLock.isLocked()) {
+            return;
+        }
         
         // 检查线程是否已注册
         auto it = threadMap.find(currentThreadId);
@@ -105,76 +347,133 @@ void ThreadManager::Sleep() {
             return;
         }
         
-        threadName = it->second.name;
-        mutex = it->second.mutex;
-        cond = it->second.cond;
-        it->second.sleeping = true;
-    } // 解锁映射表（std::lock_guard离开作用域）
+        info = &slotAt(it->second);
+        threadName = info->name;
+        
+        MutexGuard threadLock(info->mutex);
+        if (!threadLock.isLocked()) {
+            return;
+        }
+        generation = info->generation;
+        info->sleeping = true;
+    } // 解锁映射表（MutexGuard离开作用域）
     
-    // 加锁线程互斥锁
-    std::unique_lock<std::mutex> threadLock(*mutex);
+    THREAD_INFO_LOG(threadName << " is going to sleep...");
     
-    std::cout << threadName << " is going to sleep..." << std::endl;
+    // 加锁线程互斥锁
+    ret = pthread_mutex_lock(&info->mutex);
+    if (ret != 0) {
+        std::cerr << "Error: pthread_mutex_lock failed for " << threadName << ": " << ret << std::endl;
+        return;
+    }
     
-    // 等待条件变量，使用lambda表达式作为谓词
-    // 注意：即使notify_one()在wait()之前被调用，谓词也会检查sleeping状态
-    // 如果sleeping已经是false，wait()会立即返回，不会丢失通知
-    cond->wait(threadLock, [this, currentThreadId]() {
-        std::lock_guard<std::mutex> mapLock(mapMutex);
-        auto it = threadMap.find(currentThreadId);
-        if (it == threadMap.end()) {
-            return true; // 线程已注销，退出等待
+    // 等待条件变量
+    // 注意：即使Wakeup()在等待之前被调用，循环条件也会检查sleeping状态
+    // 如果sleeping已经是false，不会进入等待，不会丢失通知；槽位代数变化说明线程已被注销，同样退出等待
+    while (info->sleeping && info->generation == generation) {
+        ret = pthread_cond_wait(&info->cond, &info->mutex);
+        if (ret != 0) {
+            std::cerr << "Error: pthread_cond_wait failed for " << threadName << ": " << ret << std::endl;
+            break;
         }
-        return !it->second.sleeping;
-    });
+    }
+    
+    ret = pthread_mutex_unlock(&info->mutex);
+    if (ret != 0) {
+        std::cerr << "Error: pthread_mutex_unlock failed for " << threadName << ": " << ret << std::endl;
+    }
     
-    std::cout << threadName << " is woken up!" << std::endl;
-    // std::unique_lock会自动解锁
+    THREAD_INFO_LOG(threadName << " is woken up!");
 }
 
 // 根据线程名唤醒线程
-void ThreadManager::Wakeup(const std::string& threadName) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
-    
-    // 查找线程ID（遍历map）
-    pthread_t threadId = findThreadIdByName(threadName);
-    if (threadId == 0) {
-        std::cerr << "Error: Thread not found: " << threadName << std::endl;
+void ThreadManager::Wakeup(std::string_view threadName) {
+    pthread_t threadId;
+    bool woken = false;
+    uint32_t index;
+    
+    if (!checkInitialized()) {
         return;
     }
     
-    // 检查线程是否在睡眠
-    auto it = threadMap.find(threadId);
-    if (it != threadMap.end() && it->second.sleeping) {
-        it->second.sleeping = false;
-        it->second.cond->notify_one(); // 通知等待的线程
-        std::cout << "Waking up thread: " << threadName << " (ID: " << threadId << ")" << std::endl;
+    // 散列值在加锁之前计算，持有锁时只做一次散列表查找
+    size_t nameHash = hashName(threadName);
+    
+    {
+        // 使用MutexGuard自动管理锁的生命周期，任何一个锁加锁失败时放弃唤醒
+        MutexGuard lock(mapMutex);
+        if (!lock.isLocked()) {
+            return;
+        }
+        
+        // 通过线程名索引查找槽位
+        if (!findSlotByName(threadName, nameHash, index)) {
+            std::cerr << "Error: Thread not found: " << threadName << std::endl;
+            return;
+        }
+        
+        // 检查线程是否在睡眠
+        ThreadInfo& info = slotAt(index);
+        threadId = info.threadId;
+        MutexGuard threadLock(info.mutex);
+        if (!threadLock.isLocked()) {
+            return;
+        }
+        if (info.sleeping) {
+            info.sleeping = false;
+            pthread_cond_signal(&info.cond); // 通知等待的线程
+            woken = true;
+        }
+    } // 解锁映射表，输出日志不持有注册表锁
+    
+    if (woken) {
+        THREAD_INFO_LOG("Waking up thread: " << threadName << " (ID: " << threadId << ")");
     }
-    // std::lock_guard会自动解锁
 }
 
 // 根据线程ID唤醒线程
 void ThreadManager::Wakeup(pthread_t threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+    std::string threadName;
+    bool woken = false;
     
-    // 检查线程是否已注册
-    auto it = threadMap.find(threadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not found: ID " << threadId << std::endl;
+    if (!checkInitialized()) {
         return;
     }
     
-    std::string threadName = it->second.name;
+    {
+        // 使用MutexGuard自动管理锁的生命周期，任何一个锁加锁失败时放弃唤醒
+        MutexGuard lock(mapMutex);
+        if (!lock.isLocked()) {
+            return;
+        }
+        
+        // 检查线程是否已注册
+        auto it = threadMap.find(threadId);
+        if (it == threadMap.end()) {
+            std::cerr << "Error: Thread not found: ID " << threadId << std::endl;
+            return;
+        }
+        
+        ThreadInfo& info = slotAt(it->second);
+        
+        // 检查线程是否在睡眠
+        MutexGuard threadLock(info.mutex);
+        if (!threadLock.isLocked()) {
+            return;
+        }
+        if (info.sleeping) {
+            info.sleeping = false;
+            pthread_cond_signal(&info.cond); // 通知等待的线程
+            if (THREAD_INFO_LOG_ENABLED) {
+                threadName = info.name;
+            }
+            woken = true;
+        }
+    } // 解锁映射表，输出日志不持有注册表锁
     
-    // 检查线程是否在睡眠
-    if (it->second.sleeping) {
-        it->second.sleeping = false;
-        it->second.cond->notify_one(); // 通知等待的线程
-        std::cout << "Waking up thread: " << threadName << " (ID: " << threadId << ")" << std::endl;
+    if (woken) {
+        THREAD_INFO_LOG("Waking up thread: " << threadName << " (ID: " << threadId << ")");
     }
-    // std::lock_guard会自动解锁
 }
 
 // 全局Sleep函数
@@ -183,7 +482,7 @@ void Sleep() {
 }
 
 // 全局Wakeup函数（线程名）
-void Wakeup(const std::string& threadName) {
+void Wakeup(std::string_view threadName) {
     ThreadManager::getInstance()->Wakeup(threadName);
 }
 
@@ -2,19 +2,43 @@
 #define THREAD_MANAGER_H
 
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstddef>
 #include <map>
-#include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <iostream>
+#include <vector>
+#include <cstdint>
 #include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+
+// 实时构建（定义THREAD_MANAGER_RT，QNX的Makefile默认定义）：注册表互斥锁和每个线程的互斥锁
+// 使用优先级继承协议（PTHREAD_PRIO_INHERIT），低优先级线程持有锁时被临时提升到等待者的优先级，
+// 不会让高优先级的唤醒方因为中等优先级线程的抢占而无限期等待
+
+// 线程注册选项
+struct RegisterOptions {
+    // 调度策略：SCHED_OTHER表示不修改线程的调度参数（默认），SCHED_FIFO/SCHED_RR设置实时优先级
+    // 设置实时策略需要相应权限（Linux下为CAP_SYS_NICE）：权限不足（EPERM）时记录警告并保持原有调度参数，注册仍然成功
+    int schedPolicy;
+    int schedPriority;  // 实时优先级，范围见sched_get_priority_min()/sched_get_priority_max()
+    
+    RegisterOptions() : schedPolicy(SCHED_OTHER), schedPriority(0) {}
+};
 
 // 线程信息结构体，包含所有线程相关信息
-struct ThreadInfo {
-    std::string name;                                  // 线程名
-    std::shared_ptr<std::mutex> mutex;                // 互斥锁
-    std::shared_ptr<std::condition_variable> cond;    // 条件变量
-    bool sleeping{false};                              // 睡眠状态
+// 存放在管理器按块分配的槽位表中：每个槽位按缓存行对齐并填充，相邻线程的睡眠状态不会共享缓存行；
+// 互斥锁和条件变量随槽位创建一次，槽位块分配后不再移动，槽位地址在管理器生命周期内不变，注销后槽位被复用
+struct alignas(64) ThreadInfo {
+    pthread_mutex_t mutex;                             // 互斥锁（实时构建下使用优先级继承协议）
+    pthread_cond_t cond;                               // 条件变量
+    uint32_t generation{0};                            // 槽位代数，注销时递增（持有本槽位互斥锁时读写）
+    bool sleeping{false};                              // 睡眠状态（持有本槽位互斥锁时读写）
+    std::string name;                                  // 线程名（持有mapMutex时读写），线程名索引的键直接指向它
+    size_t nameHash{0};                                // 线程名的散列值（注册时计算一次）
+    pthread_t threadId{};                              // 线程ID（持有mapMutex时读写）
 };
 
 class ThreadManager {
@@ -25,11 +49,13 @@ public:
     void Sleep();
     
     // 用户线程调用的Wakeup函数，可以传入线程名或线程id
-    void Wakeup(const std::string& threadName);
+    // 按线程名唤醒时通过散列索引查找（常数时间），传入字符串字面量或std::string都不会复制线程名
+    void Wakeup(std::string_view threadName);
     void Wakeup(pthread_t threadId);
     
     // 内部使用的方法，用于注册和注销线程
     void registerThread(const std::string& threadName, pthread_t threadId);
+    void registerThread(const std::string& threadName, pthread_t threadId, const RegisterOptions& options);
     void unregisterThread(pthread_t threadId);
     
 private:
@@ -38,21 +64,68 @@ private:
     ThreadManager(const ThreadManager&) = delete;
     ThreadManager& operator=(const ThreadManager&) = delete;
     
+    // 每个槽位块的槽位数：空闲槽位用完时再分配一块，注册的线程数不设上限
+    static const uint32_t kSlotChunkSize = 64;
+    
     static ThreadManager* instance;
     
-    // 唯一的线程信息映射（主键：线程ID）
-    std::map<pthread_t, ThreadInfo> threadMap;
+    // 按块分配的槽位表（按缓存行对齐），注册时通常只从空闲列表取出槽位，不再为互斥锁和条件变量单独分配内存
+    std::vector<ThreadInfo*> slotChunks;
+    std::vector<uint32_t> freeSlots;
+    
+    // 按下标取槽位（持有mapMutex时调用）
+    ThreadInfo& slotAt(uint32_t index) {
+        return slotChunks[index / kSlotChunkSize][index % kSlotChunkSize];
+    }
+    
+    // 分配一个新的槽位块并把其中的槽位放入空闲列表（持有mapMutex时调用），分配或初始化失败时返回false
+    bool growSlots();
+    
+    // 唯一的线程信息映射（主键：线程ID，值：槽位下标）
+    std::map<pthread_t, uint32_t> threadMap;
+    
+    // 保护映射表和空闲槽位列表的互斥锁（加锁顺序：先mapMutex，再槽位互斥锁；实时构建下使用优先级继承协议）
+    pthread_mutex_t mapMutex;
+    bool mapMutexInitialized;
+    
+    // 映射表互斥锁未初始化时记录错误并返回false，注册、注销、睡眠和唤醒之前调用
+    bool checkInitialized() const;
+    
+    // 线程名索引的键：指向槽位中线程名的视图和预先计算的散列值
+    // 线程名只在槽位中保存一份（驻留），索引不复制字符串；比较时先比较散列值，不同名字很少需要逐字节比较
+    struct NameKey {
+        std::string_view name;
+        size_t hash;
+        
+        NameKey(std::string_view name, size_t hash) : name(name), hash(hash) {}
+        
+        bool operator==(const NameKey& other) const {
+            return hash == other.hash && name == other.name;
+        }
+    };
+    
+    struct NameKeyHash {
+        size_t operator()(const NameKey& key) const { return key.hash; }
+    };
+    
+    // 线程名索引（主键：线程名，值：槽位下标），与threadMap同时维护
+    std::unordered_map<NameKey, uint32_t, NameKeyHash> nameIndex;
+    
+    // 线程名的散列值
+    static size_t hashName(std::string_view threadName) {
+        return std::hash<std::string_view>()(threadName);
+    }
     
-    // 保护映射表的互斥锁
-    std::mutex mapMutex;
+    // 辅助方法：通过线程名查找槽位（持有mapMutex时调用），不存在时返回false
+    bool findSlotByName(std::string_view threadName, size_t nameHash, uint32_t& index) const;
     
-    // 辅助方法：通过线程名查找线程ID
-    pthread_t findThreadIdByName(const std::string& threadName);
+    // 辅助方法：设置线程的调度策略和优先级，权限不足时保持原有调度参数
+    void applySchedParams(const std::string& threadName, pthread_t threadId, const RegisterOptions& options);
 };
 
 // 方便用户使用的全局函数
 void Sleep();
-void Wakeup(const std::string& threadName);
+void Wakeup(std::string_view threadName);
 void Wakeup(pthread_t threadId);
 
 #endif // THREAD_MANAGER_H
\ No newline at end of file
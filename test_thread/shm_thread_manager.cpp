@@ -0,0 +1,535 @@
+#define DLL_EXPORTS
+#include "shm_thread_manager.h"
+#include "thread_log.h"
+#include "spin_policy.h"
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+
+// 状态字位于共享内存中，要求原子操作不依赖进程内的锁
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "std::atomic<uint32_t> must be lock-free in shared memory");
+
+// 槽位：按缓存行对齐，相邻线程的状态字不会共享缓存行
+// 状态字布局：高30位为槽位代数，bit1为未消费的许可，bit0为1表示睡眠中（直接作为进程间共享的futex等待地址）
+// pid为0表示空闲；注册时先写线程名再写pid，注册中途崩溃的进程不会留下名字不完整的已用槽位
+struct alignas(64) ShmSlot {
+    std::atomic<uint32_t> state;
+    int32_t pid;                                            // 所属进程（持有注册表锁时读写）
+    int32_t tid;                                            // 内核线程ID，只用于日志
+    uint32_t nameHash;                                      // 线程名的FNV-1a散列，查找时先比较散列
+    char name[ShmThreadManager::kMaxNameLength + 1];
+};
+
+// 共享内存段布局，版本号或大小不一致的段拒绝映射
+struct ShmSegment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t segmentSize;
+    std::atomic<uint32_t> ready;                            // 创建者初始化完成后置为kShmReady
+    pthread_mutex_t mutex;                                  // 注册表锁（进程间共享、健壮）
+    ShmSlot slots[ShmThreadManager::kMaxThreads];
+};
+
+namespace {
+
+const uint32_t kShmMagic = 0x54484d53u;         // "SMHT"
+const uint32_t kShmVersion = 1;
+const uint32_t kShmReady = 1;
+
+const uint32_t kSleeping = 1u;
+const uint32_t kPermit = 2u;
+const uint32_t kGenerationShift = 2;
+const uint32_t kGenerationMask = 0x3FFFFFFFu;
+
+// 等待其他进程完成段初始化的时间上限
+const int kAttachRetries = 1000;
+const useconds_t kAttachRetryMicros = 1000;
+
+const uint64_t kNoDeadline = UINT64_MAX;
+
+inline uint32_t generationOf(uint32_t state) {
+    return state >> kGenerationShift;
+}
+
+inline uint32_t makeState(uint32_t generation, uint32_t flags) {
+    return (generation << kGenerationShift) | flags;
+}
+
+// 下一个代数，跳过0（0表示无效句柄）
+inline uint32_t nextGeneration(uint32_t generation) {
+    uint32_t next = (generation + 1) & kGenerationMask;
+    return next == 0 ? 1 : next;
+}
+
+// FNV-1a散列
+uint32_t hashName(const std::string& name) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < name.size(); ++i) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 进程是否已退出（pid可能被复用：复用期间槽位不会被回收，直到该pid也退出）
+bool processGone(int32_t pid) {
+    return kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+// 进程间共享的futex等待/唤醒（不使用FUTEX_PRIVATE_FLAG，内核按物理页定位等待者）
+// 截止时间是CLOCK_MONOTONIC上的绝对时间
+void sharedFutexWait(std::atomic<uint32_t>* word, uint32_t expected, uint64_t deadlineNanos) {
+    if (deadlineNanos == kNoDeadline) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, NULL, NULL, 0);
+        return;
+    }
+    struct timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadlineNanos / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadlineNanos % 1000000000ULL);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_BITSET, expected, &deadline, NULL,
+            FUTEX_BITSET_MATCH_ANY);
+}
+
+void sharedFutexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// 向指定代数的槽位投递唤醒：睡眠中则清除睡眠位并FUTEX_WAKE，否则保存许可；代数不匹配时返回false
+bool wakeSlot(ShmSlot& slot, uint32_t generation) {
+    uint32_t state = slot.state.load(std::memory_order_acquire);
+    for (;;) {
+        if (generationOf(state) != generation) {
+            return false;
+        }
+        uint32_t next = (state & kSleeping) ? makeState(generation, 0) : (state | kPermit);
+        if (next == state) {
+            return true;    // 已有未消费的许可
+        }
+        if (slot.state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            if (state & kSleeping) {
+                sharedFutexWake(&slot.state);
+            }
+            return true;
+        }
+    }
+}
+
+// 初始化新建的段（只由创建者执行，其他进程在ready置位之前不会访问）
+bool initSegment(ShmSegment* segment) {
+    pthread_mutexattr_t attr;
+    int ret = pthread_mutexattr_init(&attr);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutexattr_init failed: " << ret);
+        return false;
+    }
+    ret = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    if (ret == 0) {
+        ret = pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    }
+    if (ret == 0) {
+        ret = pthread_mutex_init(&segment->mutex, &attr);
+    }
+    pthread_mutexattr_destroy(&attr);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: Failed to initialize process-shared mutex: " << ret);
+        return false;
+    }
+    
+    // ftruncate()得到的内存已清零，只需设置各槽位的初始代数
+    for (uint32_t i = 0; i < ShmThreadManager::kMaxThreads; ++i) {
+        segment->slots[i].state.store(makeState(1, 0), std::memory_order_relaxed);
+    }
+    segment->magic = kShmMagic;
+    segment->version = kShmVersion;
+    segment->slotCount = ShmThreadManager::kMaxThreads;
+    segment->segmentSize = sizeof(ShmSegment);
+    segment->ready.store(kShmReady, std::memory_order_release);
+    return true;
+}
+
+// 当前线程注册到的段和句柄（一个线程同时只能注册到一个段）
+thread_local ShmThreadManager* currentManager = NULL;
+thread_local ParkHandle currentHandle;
+
+} // namespace
+
+// 映射共享内存段，不存在时创建
+ShmThreadManager* ShmThreadManager::attach(const std::string& segmentName) {
+    // 本进程已映射的段（管理器与段映射在进程生命周期内保持有效）
+    static std::mutex attachMutex;
+    static std::map<std::string, ShmThreadManager*>* attached = new std::map<std::string, ShmThreadManager*>();
+    
+    std::lock_guard<std::mutex> lock(attachMutex);
+    std::map<std::string, ShmThreadManager*>::iterator it = attached->find(segmentName);
+    if (it != attached->end()) {
+        return it->second;
+    }
+    
+    // O_EXCL保证只有一个进程负责初始化
+    bool creator = true;
+    int fd = shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(segmentName.c_str(), O_RDWR, 0);
+    }
+    if (fd < 0) {
+        THREAD_LOG_ERROR("Error: shm_open failed for " << segmentName << ": " << errno);
+        return NULL;
+    }
+    
+    if (creator) {
+        if (ftruncate(fd, sizeof(ShmSegment)) != 0) {
+            THREAD_LOG_ERROR("Error: ftruncate failed for " << segmentName << ": " << errno);
+            close(fd);
+            shm_unlink(segmentName.c_str());
+            return NULL;
+        }
+    } else {
+        // 等待创建者设置段大小
+        struct stat info;
+        int retries = 0;
+        while (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) < sizeof(ShmSegment) &&
+               retries++ < kAttachRetries) {
+            usleep(kAttachRetryMicros);
+        }
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != sizeof(ShmSegment)) {
+            THREAD_LOG_ERROR("Error: Shared memory segment " << segmentName << " has unexpected size");
+            close(fd);
+            return NULL;
+        }
+    }
+    
+    void* memory = mmap(NULL, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // 映射建立后不再需要描述符
+    if (memory == MAP_FAILED) {
+        THREAD_LOG_ERROR("Error: mmap failed for " << segmentName << ": " << errno);
+        if (creator) {
+            shm_unlink(segmentName.c_str());
+        }
+        return NULL;
+    }
+    ShmSegment* segment = static_cast<ShmSegment*>(memory);
+    
+    if (creator) {
+        if (!initSegment(segment)) {
+            munmap(memory, sizeof(ShmSegment));
+            shm_unlink(segmentName.c_str());
+            return NULL;
+        }
+    } else {
+        // 等待创建者完成初始化
+        int retries = 0;
+        while (segment->ready.load(std::memory_order_acquire) != kShmReady && retries++ < kAttachRetries) {
+            usleep(kAttachRetryMicros);
+        }
+        if (segment->ready.load(std::memory_order_acquire) != kShmReady) {
+            THREAD_LOG_ERROR("Error: Shared memory segment " << segmentName << " was never initialized");
+            munmap(memory, sizeof(ShmSegment));
+            return NULL;
+        }
+        if (segment->magic != kShmMagic || segment->version != kShmVersion ||
+            segment->slotCount != kMaxThreads || segment->segmentSize != sizeof(ShmSegment)) {
+            THREAD_LOG_ERROR("Error: Shared memory segment " << segmentName << " has an incompatible layout");
+            munmap(memory, sizeof(ShmSegment));
+            return NULL;
+        }
+    }
+    
+    ShmThreadManager* manager = new ShmThreadManager(segmentName, segment);
+    (*attached)[segmentName] = manager;
+    THREAD_LOG_INFO("Shared memory segment " << (creator ? "created" : "attached") << ": " << segmentName);
+    return manager;
+}
+
+// 删除共享内存段的名字
+bool ShmThreadManager::unlinkSegment(const std::string& segmentName) {
+    // 段不存在（从未创建或已被删除）视为成功，启动前清理残留的段时不记录错误
+    if (shm_unlink(segmentName.c_str()) != 0 && errno != ENOENT) {
+        THREAD_LOG_ERROR("Error: shm_unlink failed for " << segmentName << ": " << errno);
+        return false;
+    }
+    return true;
+}
+
+// 构造函数
+ShmThreadManager::ShmThreadManager(const std::string& segmentName, ShmSegment* segment)
+    : segmentName(segmentName), segment(segment) {
+}
+
+// 加注册表锁
+bool ShmThreadManager::lockRegistry() {
+    int ret = pthread_mutex_lock(&segment->mutex);
+    if (ret == EOWNERDEAD) {
+        // 上一个持有者在持有锁时退出：注册表的每次修改都以写pid结束，已用槽位总是完整的，恢复一致性即可
+        THREAD_LOG_WARN("Warning: Registry lock owner died, recovering segment " << segmentName);
+        ret = pthread_mutex_consistent(&segment->mutex);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_mutex_consistent failed for " << segmentName << ": " << ret);
+            pthread_mutex_unlock(&segment->mutex);
+            return false;
+        }
+        reapLocked();
+        return true;
+    }
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for " << segmentName << ": " << ret);
+        return false;
+    }
+    return true;
+}
+
+// 解锁注册表
+void ShmThreadManager::unlockRegistry() {
+    int ret = pthread_mutex_unlock(&segment->mutex);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for " << segmentName << ": " << ret);
+    }
+}
+
+// 回收已退出进程的槽位
+size_t ShmThreadManager::reapLocked() {
+    size_t reaped = 0;
+    for (uint32_t i = 0; i < kMaxThreads; ++i) {
+        ShmSlot& slot = segment->slots[i];
+        if (slot.pid != 0 && processGone(slot.pid)) {
+            THREAD_LOG_WARN("Warning: Reclaiming slot of exited process " << slot.pid << ": " << slot.name);
+            releaseSlotLocked(i);
+            reaped++;
+        }
+    }
+    return reaped;
+}
+
+// 按线程名查找槽位
+uint32_t ShmThreadManager::findSlotLocked(const std::string& threadName, uint32_t nameHash) {
+    for (uint32_t i = 0; i < kMaxThreads; ++i) {
+        const ShmSlot& slot = segment->slots[i];
+        if (slot.pid != 0 && slot.nameHash == nameHash && threadName == slot.name) {
+            return i;
+        }
+    }
+    return kMaxThreads;
+}
+
+// 可供threadName注册的空闲槽位：线程名已被占用或没有空闲槽位时返回kMaxThreads
+uint32_t ShmThreadManager::claimableSlotLocked(const std::string& threadName, uint32_t nameHash) {
+    if (findSlotLocked(threadName, nameHash) != kMaxThreads) {
+        return kMaxThreads;
+    }
+    for (uint32_t i = 0; i < kMaxThreads; ++i) {
+        if (segment->slots[i].pid == 0) {
+            return i;
+        }
+    }
+    return kMaxThreads;
+}
+
+// 释放槽位
+void ShmThreadManager::releaseSlotLocked(uint32_t index) {
+    ShmSlot& slot = segment->slots[index];
+    slot.pid = 0;
+    
+    // 递增代数并清除睡眠位和许可：睡眠中的线程看到代数变化而返回，持有旧句柄的唤醒方被拒绝
+    uint32_t state = slot.state.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+        next = makeState(nextGeneration(generationOf(state)), 0);
+    } while (!slot.state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+    if (state & kSleeping) {
+        sharedFutexWake(&slot.state);
+    }
+}
+
+// 注册调用线程
+ParkHandle ShmThreadManager::registerThread(const std::string& threadName) {
+    if (threadName.empty() || threadName.size() > kMaxNameLength) {
+        THREAD_LOG_ERROR("Error: Invalid shared thread name (1-" << kMaxNameLength << " bytes): " << threadName);
+        return ParkHandle();
+    }
+    if (currentManager != NULL) {
+        THREAD_LOG_ERROR("Error: Thread already registered in a shared segment: " << threadName);
+        return ParkHandle();
+    }
+    
+    uint32_t nameHash = hashName(threadName);
+    if (!lockRegistry()) {
+        return ParkHandle();
+    }
+    
+    // 线程名冲突或没有空闲槽位时，先回收已退出进程的槽位再重试一次
+    uint32_t index = claimableSlotLocked(threadName, nameHash);
+    if (index == kMaxThreads && reapLocked() != 0) {
+        index = claimableSlotLocked(threadName, nameHash);
+    }
+    if (index == kMaxThreads) {
+        bool exists = findSlotLocked(threadName, nameHash) != kMaxThreads;
+        unlockRegistry();
+        if (exists) {
+            THREAD_LOG_ERROR("Error: Shared thread name already exists: " << threadName);
+        } else {
+            THREAD_LOG_ERROR("Error: No free shared thread slot for: " << threadName);
+        }
+        return ParkHandle();
+    }
+    
+    ShmSlot& slot = segment->slots[index];
+    memcpy(slot.name, threadName.c_str(), threadName.size() + 1);
+    slot.nameHash = nameHash;
+    slot.tid = static_cast<int32_t>(syscall(SYS_gettid));
+    slot.pid = static_cast<int32_t>(getpid());
+    ParkHandle handle(index, generationOf(slot.state.load(std::memory_order_relaxed)));
+    unlockRegistry();
+    
+    currentManager = this;
+    currentHandle = handle;
+    THREAD_LOG_INFO("Shared thread registered: " << threadName << " (segment: " << segmentName << ")");
+    return handle;
+}
+
+// 注销调用线程
+void ShmThreadManager::unregisterThread() {
+    if (currentManager != this) {
+        THREAD_LOG_ERROR("Error: Thread not registered in shared segment " << segmentName);
+        return;
+    }
+    ParkHandle handle = currentHandle;
+    currentManager = NULL;
+    currentHandle = ParkHandle();
+    
+    if (!lockRegistry()) {
+        return;
+    }
+    // 槽位可能已被回收（例如被误判为已退出进程的槽位），此时代数已变化
+    ShmSlot& slot = segment->slots[handle.index];
+    if (slot.pid == static_cast<int32_t>(getpid()) &&
+        generationOf(slot.state.load(std::memory_order_relaxed)) == handle.generation) {
+        releaseSlotLocked(handle.index);
+    }
+    unlockRegistry();
+}
+
+// 睡眠直到被唤醒
+void ShmThreadManager::Sleep() {
+    park(kNoDeadline);
+}
+
+// 限时睡眠
+WakeReason ShmThreadManager::SleepFor(std::chrono::nanoseconds timeout) {
+    uint64_t now = spinClockNanos();
+    uint64_t nanos = timeout.count() > 0 ? static_cast<uint64_t>(timeout.count()) : 0;
+    return park(nanos < kNoDeadline - now ? now + nanos : kNoDeadline - 1);
+}
+
+// 睡眠直到被唤醒、到达截止时间或被注销
+WakeReason ShmThreadManager::park(uint64_t deadlineNanos) {
+    if (currentManager != this) {
+        THREAD_LOG_ERROR("Error: Thread not registered in shared segment " << segmentName);
+        return kWakeUnregistered;
+    }
+    ShmSlot& slot = segment->slots[currentHandle.index];
+    const uint32_t generation = currentHandle.generation;
+    
+    // 消费许可，或者宣告睡眠
+    uint32_t state = slot.state.load(std::memory_order_acquire);
+    for (;;) {
+        if (generationOf(state) != generation) {
+            return kWakeUnregistered;
+        }
+        uint32_t next = (state & kPermit) ? makeState(generation, 0) : makeState(generation, kSleeping);
+        if (slot.state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            if (state & kPermit) {
+                return kWakeNotified;
+            }
+            break;
+        }
+    }
+    
+    // 状态字仍为“本代数 + 睡眠中”时才阻塞；EINTR、虚假唤醒和超时后重新检查
+    const uint32_t sleepingState = makeState(generation, kSleeping);
+    for (;;) {
+        state = slot.state.load(std::memory_order_acquire);
+        if (state != sleepingState) {
+            return generationOf(state) == generation ? kWakeNotified : kWakeUnregistered;
+        }
+        if (deadlineNanos != kNoDeadline && spinClockNanos() >= deadlineNanos) {
+            // 撤销睡眠声明；与唤醒方的CAS竞争失败说明通知已经到达
+            if (slot.state.compare_exchange_strong(state, makeState(generation, 0), std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+                return kWakeTimeout;
+            }
+            continue;
+        }
+        sharedFutexWait(&slot.state, sleepingState, deadlineNanos);
+    }
+}
+
+// 按线程名唤醒
+bool ShmThreadManager::Wakeup(const std::string& threadName) {
+    ParkHandle handle = findHandle(threadName);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Shared thread not found: " << threadName);
+        return false;
+    }
+    // 解锁后再投递：线程在此期间注销时代数已变化，CAS失败
+    return wakeSlot(segment->slots[handle.index], handle.generation);
+}
+
+// 按句柄唤醒
+bool ShmThreadManager::Wakeup(ParkHandle handle) {
+    if (!handle.valid() || handle.index >= kMaxThreads) {
+        return false;
+    }
+    return wakeSlot(segment->slots[handle.index], handle.generation);
+}
+
+// 按线程名查找句柄
+ParkHandle ShmThreadManager::findHandle(const std::string& threadName) {
+    if (threadName.size() > kMaxNameLength || !lockRegistry()) {
+        return ParkHandle();
+    }
+    ParkHandle handle;
+    uint32_t index = findSlotLocked(threadName, hashName(threadName));
+    if (index != kMaxThreads) {
+        handle = ParkHandle(index, generationOf(segment->slots[index].state.load(std::memory_order_relaxed)));
+    }
+    unlockRegistry();
+    return handle;
+}
+
+// 回收已退出进程遗留的槽位
+size_t ShmThreadManager::reapDeadThreads() {
+    if (!lockRegistry()) {
+        return 0;
+    }
+    size_t reaped = reapLocked();
+    unlockRegistry();
+    return reaped;
+}
+
+#else
+
+// 其他平台：没有进程间共享的futex和健壮互斥锁，不支持跨进程管理器
+ShmThreadManager* ShmThreadManager::attach(const std::string& segmentName) {
+    THREAD_LOG_ERROR("Error: Shared memory thread manager is only supported on Linux: " << segmentName);
+    return NULL;
+}
+
+bool ShmThreadManager::unlinkSegment(const std::string& segmentName) {
+    THREAD_LOG_ERROR("Error: Shared memory thread manager is only supported on Linux: " << segmentName);
+    return false;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SHM_THREAD_MANAGER_H
+#define SHM_THREAD_MANAGER_H
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include "park_handle.h"
+
+#if defined(_WIN32)
+#ifdef DLL_EXPORTS
+#define DLL_API __declspec(dllexport)
+#else
+#define DLL_API __declspec(dllimport)
+#endif
+#else
+#define DLL_API
+#endif
+
+struct ShmSegment;
+
+// 跨进程的线程管理器（仅Linux）：注册表位于命名的POSIX共享内存段中，映射同一个段的所有进程共享线程名，
+// 一个进程中的Wakeup("svc/worker3")可以直接唤醒另一个进程中的线程，不再需要经过Unix套接字中转
+//
+// 每个槽位的状态字是进程间共享的futex（不带FUTEX_PRIVATE_FLAG）：唤醒方一次CAS加一次FUTEX_WAKE，
+// 内核按物理页定位等待者，与各进程把段映射到哪个地址无关
+// 注册表由进程间共享的健壮互斥锁（PTHREAD_PROCESS_SHARED + PTHREAD_MUTEX_ROBUST）保护：
+// 持有锁的进程崩溃后，下一个加锁的进程恢复锁的一致性，并回收已退出进程遗留的槽位
+//
+// 与ThreadManager的区别：只能注册调用线程本身；线程名长度有上限；未睡眠时到达的Wakeup()最多保存一个许可
+class DLL_API ShmThreadManager {
+public:
+    // 槽位数量（一个段中同时注册的线程数上限）
+    static const uint32_t kMaxThreads = 256;
+    
+    // 线程名最大长度（字节，不含结尾的'\0'）
+    static const size_t kMaxNameLength = 47;
+    
+    // 打开名为segmentName的共享内存段（例如"/svc_threads"），不存在时创建并初始化
+    // 同一进程内多次打开同一个段返回同一个管理器；失败时返回NULL
+    // 创建段的进程在初始化完成前崩溃时，其他进程等待超时后返回NULL，需要先调用unlinkSegment()
+    static ShmThreadManager* attach(const std::string& segmentName);
+    
+    // 删除共享内存段的名字：已映射的进程继续使用原来的段，之后attach()会创建新段；段不存在时也返回true
+    static bool unlinkSegment(const std::string& segmentName);
+    
+    // 把调用线程以threadName注册到段中，成功返回有效句柄（失败返回无效句柄）
+    // 线程名已被一个已退出进程的线程占用时先回收该槽位再注册（服务崩溃重启后可以沿用原来的线程名）
+    // 一个线程同时只能注册到一个段
+    ParkHandle registerThread(const std::string& threadName);
+    
+    // 注销调用线程
+    void unregisterThread();
+    
+    // 调用线程睡眠，直到被唤醒（有未消费的许可时立即返回）
+    void Sleep();
+    
+    // 限时睡眠（单调时钟），返回醒来原因
+    WakeReason SleepFor(std::chrono::nanoseconds timeout);
+    
+    // 按线程名唤醒（加一次注册表锁查找），线程不存在时返回false
+    bool Wakeup(const std::string& threadName);
+    
+    // 按句柄唤醒：不加锁，只有一次CAS，必要时一次FUTEX_WAKE；句柄已失效时返回false
+    // 句柄在所有映射该段的进程中都有效，频繁唤醒同一个线程时先用findHandle()取得句柄
+    bool Wakeup(ParkHandle handle);
+    
+    // 按线程名查找句柄，线程不存在时返回无效句柄
+    ParkHandle findHandle(const std::string& threadName);
+    
+    // 回收已退出进程遗留的槽位（睡眠在这些槽位上的唤醒方得到false），返回回收的槽位数
+    // 注册表锁的上一个持有者崩溃时、注册时槽位不足或线程名冲突时会自动执行
+    size_t reapDeadThreads();
+    
+private:
+    ShmThreadManager(const std::string& segmentName, ShmSegment* segment);
+    ShmThreadManager(const ShmThreadManager&) = delete;
+    ShmThreadManager& operator=(const ShmThreadManager&) = delete;
+    
+    // 加注册表锁，上一个持有者崩溃时恢复一致性并回收已退出进程的槽位；失败时返回false
+    bool lockRegistry();
+    void unlockRegistry();
+    
+    // 回收已退出进程的槽位（持有注册表锁时调用）
+    size_t reapLocked();
+    
+    // 按线程名查找槽位（持有注册表锁时调用），不存在时返回kMaxThreads
+    uint32_t findSlotLocked(const std::string& threadName, uint32_t nameHash);
+    
+    // 可供threadName注册的空闲槽位（持有注册表锁时调用），线程名已被占用或没有空闲槽位时返回kMaxThreads
+    uint32_t claimableSlotLocked(const std::string& threadName, uint32_t nameHash);
+    
+    // 释放槽位：递增代数，睡眠中的线程醒来（持有注册表锁时调用）
+    void releaseSlotLocked(uint32_t index);
+    
+    // 睡眠直到被唤醒、到达截止时间（单调时钟纳秒，UINT64_MAX表示无限期）或被注销
+    WakeReason park(uint64_t deadlineNanos);
+    
+    std::string segmentName;
+    ShmSegment* segment;
+};
+
+#endif // SHM_THREAD_MANAGER_H
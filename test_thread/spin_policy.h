@@ -0,0 +1,128 @@
+#ifndef SPIN_POLICY_H
+#define SPIN_POLICY_H
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Sleep()的自旋策略：先用pause指令退避自旋，再让出CPU，最后才真正阻塞
+struct SpinPolicy {
+    enum Mode {
+        kNoSpin = 0,        // 不自旋，直接阻塞（默认）
+        kFixedSpin = 1,     // 每次都自旋spinNanos纳秒
+        kAdaptiveSpin = 2   // 每个线程根据最近的睡眠时长自动选择自旋时长，最长spinNanos纳秒
+    };
+    
+    Mode mode;
+    uint32_t spinNanos;     // 自旋时长（自适应模式下为上限）
+    uint32_t yieldCount;    // 自旋结束后调用yield的次数
+    
+    SpinPolicy() : mode(kNoSpin), spinNanos(0), yieldCount(0) {}
+    SpinPolicy(Mode mode, uint32_t spinNanos, uint32_t yieldCount)
+        : mode(mode), spinNanos(spinNanos), yieldCount(yieldCount) {}
+};
+
+// CPU暂停指令：降低自旋时的功耗，并让出超线程的执行资源
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// 单调时钟的纳秒读数
+inline uint64_t spinClockNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 是否值得自旋：单CPU时唤醒方必须等自旋方让出CPU才能运行，自旋只会推迟唤醒
+inline bool spinUseful() {
+    static const bool useful = std::thread::hardware_concurrency() > 1;
+    return useful;
+}
+
+// 自旋等待done()成立：pause指数退避（每轮最多64次pause），每轮检查一次时间，超时后再yield若干次
+// 在自旋或yield阶段等到返回true，否则返回false，由调用者继续阻塞；单CPU时跳过pause自旋，只保留yield
+template <typename Done>
+bool spinThenYield(Done done, uint32_t spinNanos, uint32_t yieldCount) {
+    if (spinNanos > 0 && spinUseful()) {
+        const uint64_t deadline = spinClockNanos() + spinNanos;
+        uint32_t backoff = 1;
+        for (;;) {
+            for (uint32_t i = 0; i < backoff; ++i) {
+                cpuRelax();
+            }
+            if (done()) {
+                return true;
+            }
+            if (backoff < 64) {
+                backoff <<= 1;
+            }
+            if (spinClockNanos() >= deadline) {
+                break;
+            }
+        }
+    }
+    
+    for (uint32_t i = 0; i < yieldCount; ++i) {
+        std::this_thread::yield();
+        if (done()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 每个线程的自适应自旋状态，由线程自己在Sleep()中读写，槽位被复用时由注册方复位
+// 字段使用relaxed原子变量：复位与旧线程在注销前最后一次记录并发时也不是数据竞争
+// 用最近睡眠时长（从开始睡眠到被唤醒）的指数滑动平均估计下一次等待时长：
+// 平均值的两倍不超过上限时自旋这么久，大多数唤醒都能在自旋阶段等到；
+// 否则说明唤醒间隔明显长于一次上下文切换，自旋只会浪费CPU，直接阻塞
+class AdaptiveSpinState {
+public:
+    AdaptiveSpinState() : avgWaitNanos(0), budgetNanos(0) {}
+    
+    // 回到初始状态（不自旋），之前使用该槽位的线程的睡眠时长不影响新线程
+    void reset() {
+        avgWaitNanos.store(0, std::memory_order_relaxed);
+        budgetNanos.store(0, std::memory_order_relaxed);
+    }
+    
+    // 本次睡眠应自旋的时长（纳秒）
+    uint32_t spinNanos(const SpinPolicy& policy) const {
+        uint32_t budget;
+        switch (policy.mode) {
+        case SpinPolicy::kFixedSpin:
+            return policy.spinNanos;
+        case SpinPolicy::kAdaptiveSpin:
+            budget = budgetNanos.load(std::memory_order_relaxed);
+            return budget < policy.spinNanos ? budget : policy.spinNanos;
+        default:
+            return 0;
+        }
+    }
+    
+    // 记录一次睡眠的实际等待时长（只在自适应模式下需要）
+    void record(const SpinPolicy& policy, uint64_t waitedNanos) {
+        // 平滑系数1/8：既能跟上负载变化，又不会被偶发的长等待打乱
+        uint64_t average = avgWaitNanos.load(std::memory_order_relaxed);
+        int64_t delta = static_cast<int64_t>(waitedNanos) - static_cast<int64_t>(average);
+        average = static_cast<uint64_t>(static_cast<int64_t>(average) + delta / 8);
+        avgWaitNanos.store(average, std::memory_order_relaxed);
+        uint64_t budget = average * 2;
+        budgetNanos.store(budget <= policy.spinNanos ? static_cast<uint32_t>(budget) : 0, std::memory_order_relaxed);
+    }
+    
+private:
+    std::atomic<uint64_t> avgWaitNanos;   // 最近睡眠时长的指数滑动平均
+    std::atomic<uint32_t> budgetNanos;    // 下一次的自旋预算
+};
+
+#endif // SPIN_POLICY_H
@@ -0,0 +1,457 @@
+#include "task_scheduler.h"
+#include "thread_manager.h"
+#include "thread_log.h"
+#include <thread>
+#include <exception>
+
+// 当前线程所属的工作线程（非工作线程为空），提交任务时据此选择本地队列还是全局注入队列
+static thread_local SchedulerWorker* currentWorker = nullptr;
+
+// 调度器实例编号，拼入工作线程的注册名，多个同名调度器的工作线程不会在ThreadManager中重名
+static std::atomic<uint32_t> nextSchedulerId(1);
+
+// 双端队列的环形数组，容量为2的幂
+struct WorkStealingDeque::Array {
+    int64_t capacity;
+    int64_t mask;
+    std::atomic<Task*>* slots;
+    
+    explicit Array(int64_t capacity) : capacity(capacity), mask(capacity - 1),
+                                       slots(new std::atomic<Task*>[capacity]) {}
+    ~Array() { delete[] slots; }
+    
+    // 元素按release/acquire读写，窃取方读到指针时任务内容一定已经可见
+    Task* get(int64_t i) const { return slots[i & mask].load(std::memory_order_acquire); }
+    void put(int64_t i, Task* task) { slots[i & mask].store(task, std::memory_order_release); }
+};
+
+WorkStealingDeque::WorkStealingDeque() : top(0), bottom(0), array(new Array(256)) {
+}
+
+WorkStealingDeque::~WorkStealingDeque() {
+    delete array.load(std::memory_order_relaxed);
+    for (Array* old : retired) {
+        delete old;
+    }
+}
+
+WorkStealingDeque::Array* WorkStealingDeque::grow(Array* old, int64_t b, int64_t t) {
+    Array* bigger = new Array(old->capacity * 2);
+    for (int64_t i = t; i < b; ++i) {
+        bigger->put(i, old->get(i));
+    }
+    // 窃取方可能仍在读取旧数组，不能立即释放
+    retired.push_back(old);
+    array.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+void WorkStealingDeque::push(Task* task) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Array* a = array.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+        a = grow(a, b, t);
+    }
+    a->put(b, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+Task* WorkStealingDeque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Array* a = array.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    // 先公布bottom再读top，与steal()中先读top再读bottom构成Dekker式同步
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    
+    if (t > b) {
+        // 队列为空
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    
+    Task* task = a->get(b);
+    if (t == b) {
+        // 只剩最后一个元素，与窃取方竞争top
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            task = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+Task* WorkStealingDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+    
+    Array* a = array.load(std::memory_order_acquire);
+    Task* task = a->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        // 与其他窃取方或所属线程竞争失败
+        return nullptr;
+    }
+    return task;
+}
+
+bool WorkStealingDeque::empty() const {
+    int64_t b = bottom.load(std::memory_order_acquire);
+    int64_t t = top.load(std::memory_order_acquire);
+    return b <= t;
+}
+
+// SchedulerWorker实现
+SchedulerWorker::SchedulerWorker(TaskScheduler* scheduler, size_t index, const std::string& name)
+    : Thread(name), scheduler(scheduler), index(index),
+      randomState((index + 1) * 0x9E3779B97F4A7C15ull), idle(false) {
+}
+
+SchedulerWorker::~SchedulerWorker() {
+}
+
+void SchedulerWorker::run() {
+    RegisterOptions options;
+    options.permitLimit = 1;    // 宣告空闲之后、睡眠之前到达的唤醒保存为许可，不会丢失
+    handle = ThreadManager::getInstance()->registerThread(name, std::this_thread::get_id(), options);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Failed to register scheduler worker " << name);
+        scheduler->reportRegistration(false);
+        return;
+    }
+    currentWorker = this;
+    scheduler->reportRegistration(true);
+    
+    for (;;) {
+        Task* task = findTask();
+        if (task) {
+            execute(task);
+            continue;
+        }
+        
+        // 停止时先执行完全部剩余任务再退出
+        if (scheduler->stopping.load(std::memory_order_acquire) && !scheduler->hasWork()) {
+            break;
+        }
+        park();
+    }
+    
+    currentWorker = nullptr;
+    ThreadManager::getInstance()->unregisterThread(handle);
+}
+
+Task* SchedulerWorker::findTask() {
+    Task* task = deque.pop();
+    if (task) {
+        return task;
+    }
+    
+    task = scheduler->popInjected();
+    if (task) {
+        return task;
+    }
+    
+    // 随机选取窃取目标，避免所有空闲线程同时争抢同一个队列
+    size_t count = scheduler->workers.size();
+    if (count < 2) {
+        return nullptr;
+    }
+    for (size_t attempt = 0; attempt < 2 * count; ++attempt) {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        size_t victim = randomState % count;
+        if (victim == index) {
+            continue;
+        }
+        task = scheduler->workers[victim]->deque.steal();
+        if (task) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void SchedulerWorker::execute(Task* task) {
+    try {
+        task->fn();
+    } catch (const std::exception& e) {
+        THREAD_LOG_ERROR("Error: Task threw exception in " << name << ": " << e.what());
+    } catch (...) {
+        THREAD_LOG_ERROR("Error: Task threw unknown exception in " << name);
+    }
+    delete task;
+}
+
+void SchedulerWorker::park() {
+    // 先宣告空闲再检查任务：提交方先放入任务再检查空闲线程，两边至少有一方看到对方
+    idle.store(true, std::memory_order_seq_cst);
+    scheduler->idleCount.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    if (scheduler->hasWork() || scheduler->stopping.load(std::memory_order_seq_cst)) {
+        // 撤销空闲宣告；已被提交方认领时它会投递一次唤醒，保存为许可，下一次睡眠立即返回
+        if (idle.exchange(false, std::memory_order_acq_rel)) {
+            scheduler->idleCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    
+    ThreadManager::getInstance()->Sleep();
+    
+    // 被认领的线程已由认领方撤销空闲宣告；虚假唤醒时自己撤销
+    if (idle.exchange(false, std::memory_order_acq_rel)) {
+        scheduler->idleCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// TaskScheduler实现
+TaskScheduler::TaskScheduler(size_t workerCount, const std::string& name)
+    : name(name), injectedCount(0), idleCount(0), wakeCursor(0), startedWorkers(0), stopping(false),
+      registeredWorkers(0), failedWorkers(0) {
+    if (workerCount == 0) {
+        workerCount = std::thread::hardware_concurrency();
+        if (workerCount == 0) {
+            workerCount = 1;
+        }
+    }
+    
+    workerPrefix = name + "#" + std::to_string(nextSchedulerId.fetch_add(1, std::memory_order_relaxed)) + "_worker";
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.push_back(new SchedulerWorker(this, i, workerPrefix + std::to_string(i)));
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    stop();
+    
+    // 未启动就被销毁时，丢弃尚未执行的任务
+    for (Task* task : injected) {
+        delete task;
+    }
+    injected.clear();
+    
+    for (SchedulerWorker* worker : workers) {
+        delete worker;
+    }
+}
+
+bool TaskScheduler::start() {
+    if (startedWorkers != 0) {
+        THREAD_LOG_ERROR("Error: Scheduler " << name << " is already started");
+        return false;
+    }
+    if (stopping.load(std::memory_order_relaxed)) {
+        THREAD_LOG_ERROR("Error: Scheduler " << name << " is stopped");
+        return false;
+    }
+    
+    bool failed = false;
+    for (SchedulerWorker* worker : workers) {
+        if (!worker->start()) {
+            THREAD_LOG_ERROR("Error: Failed to start worker for scheduler " << name);
+            failed = true;
+            break;
+        }
+        startedWorkers++;
+    }
+    
+    // 等待已启动的工作线程注册完成：注册失败的工作线程已经退出，不会再执行任务
+    {
+        std::unique_lock<std::mutex> lock(startMutex);
+        startCond.wait(lock, [this]() { return registeredWorkers + failedWorkers == startedWorkers; });
+        if (failedWorkers != 0) {
+            THREAD_LOG_ERROR("Error: " << failedWorkers << " workers of scheduler " << name << " failed to register");
+            failed = true;
+        }
+    }
+    
+    // 部分工作线程不可用时整体停止，不以缺少工作线程的状态继续运行
+    if (failed) {
+        stop();
+        THREAD_LOG_ERROR("Error: Scheduler " << name << " failed to start");
+        return false;
+    }
+    
+    THREAD_LOG_INFO("Scheduler " << name << " started with " << workers.size() << " workers");
+    return true;
+}
+
+void TaskScheduler::stop() {
+    {
+        // 与submit()在同一把锁下检查/设置stopping：之前提交的任务一定被工作线程看到，之后提交的任务被丢弃
+        std::lock_guard<std::mutex> lock(injectMutex);
+        if (stopping.load(std::memory_order_relaxed)) {
+            return;
+        }
+        stopping.store(true, std::memory_order_seq_cst);
+    }
+    
+    // 唤醒全部空闲的工作线程；没有宣告空闲的线程会在睡眠前看到stopping
+    for (size_t i = 0; i < startedWorkers; ++i) {
+        SchedulerWorker* worker = workers[i];
+        if (worker->idle.exchange(false, std::memory_order_seq_cst)) {
+            idleCount.fetch_sub(1, std::memory_order_relaxed);
+            ThreadManager::getInstance()->Wakeup(worker->handle);
+        }
+    }
+    
+    for (size_t i = 0; i < startedWorkers; ++i) {
+        workers[i]->join();
+    }
+    
+    if (startedWorkers != 0) {
+        THREAD_LOG_INFO("Scheduler " << name << " stopped");
+    }
+}
+
+void TaskScheduler::reportRegistration(bool registered) {
+    std::lock_guard<std::mutex> lock(startMutex);
+    if (registered) {
+        registeredWorkers++;
+    } else {
+        failedWorkers++;
+    }
+    startCond.notify_all();
+}
+
+void TaskScheduler::submit(std::function<void()> fn) {
+    Task* task = new Task(std::move(fn));
+    
+    SchedulerWorker* worker = currentWorker;
+    if (worker != nullptr && worker->scheduler == this) {
+        // 工作线程内提交：压入本地队列，通常由自己执行，空闲线程可以窃取
+        worker->deque.push(task);
+    } else {
+        std::unique_lock<std::mutex> lock(injectMutex);
+        if (stopping.load(std::memory_order_relaxed)) {
+            lock.unlock();
+            THREAD_LOG_ERROR("Error: Scheduler " << name << " is stopped, task discarded");
+            delete task;
+            return;
+        }
+        injected.push_back(task);
+        injectedCount.fetch_add(1, std::memory_order_release);
+    }
+    
+    // 先放入任务再检查空闲线程，与park()中的顺序相反
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeOneIdle();
+}
+
+void TaskScheduler::submitBatch(std::vector<std::function<void()>> fns) {
+    if (fns.empty()) {
+        return;
+    }
+    
+    SchedulerWorker* worker = currentWorker;
+    if (worker != nullptr && worker->scheduler == this) {
+        for (std::function<void()>& fn : fns) {
+            worker->deque.push(new Task(std::move(fn)));
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(injectMutex);
+        if (stopping.load(std::memory_order_relaxed)) {
+            lock.unlock();
+            THREAD_LOG_ERROR("Error: Scheduler " << name << " is stopped, " << fns.size() << " tasks discarded");
+            return;
+        }
+        for (std::function<void()>& fn : fns) {
+            injected.push_back(new Task(std::move(fn)));
+        }
+        injectedCount.fetch_add(fns.size(), std::memory_order_release);
+    }
+    
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (fns.size() == 1) {
+        wakeOneIdle();
+    } else {
+        wakeIdle(fns.size());
+    }
+}
+
+int TaskScheduler::currentWorkerIndex() const {
+    SchedulerWorker* worker = currentWorker;
+    if (worker != nullptr && worker->scheduler == this) {
+        return static_cast<int>(worker->index);
+    }
+    return -1;
+}
+
+void TaskScheduler::wakeOneIdle() {
+    if (idleCount.load(std::memory_order_seq_cst) <= 0) {
+        return;
+    }
+    
+    // 认领一个空闲线程（撤销它的空闲宣告）再唤醒，并发的提交方不会重复唤醒同一个线程
+    size_t count = workers.size();
+    size_t start = wakeCursor.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        SchedulerWorker* worker = workers[(start + i) % count];
+        if (!worker->idle.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        if (worker->idle.exchange(false, std::memory_order_acq_rel)) {
+            idleCount.fetch_sub(1, std::memory_order_relaxed);
+            ThreadManager::getInstance()->Wakeup(worker->handle);
+            return;
+        }
+    }
+}
+
+void TaskScheduler::wakeIdle(size_t maxCount) {
+    if (idleCount.load(std::memory_order_seq_cst) <= 0) {
+        return;
+    }
+    
+    std::vector<ParkHandle> handles;
+    size_t count = workers.size();
+    size_t start = wakeCursor.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < count && handles.size() < maxCount; ++i) {
+        SchedulerWorker* worker = workers[(start + i) % count];
+        if (!worker->idle.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        if (worker->idle.exchange(false, std::memory_order_acq_rel)) {
+            idleCount.fetch_sub(1, std::memory_order_relaxed);
+            handles.push_back(worker->handle);
+        }
+    }
+    
+    if (!handles.empty()) {
+        ThreadManager::getInstance()->WakeupMany(handles);
+    }
+}
+
+Task* TaskScheduler::popInjected() {
+    if (injectedCount.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(injectMutex);
+    if (injected.empty()) {
+        return nullptr;
+    }
+    Task* task = injected.front();
+    injected.pop_front();
+    injectedCount.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+bool TaskScheduler::hasWork() const {
+    if (injectedCount.load(std::memory_order_seq_cst) != 0) {
+        return true;
+    }
+    for (SchedulerWorker* worker : workers) {
+        if (!worker->deque.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,169 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include "thread.h"
+#include "park_handle.h"
+
+#if defined(_WIN32)
+#ifdef DLL_EXPORTS
+#define DLL_API __declspec(dllexport)
+#else
+#define DLL_API __declspec(dllimport)
+#endif
+#else
+#define DLL_API
+#endif
+
+class TaskScheduler;
+
+// 任务：堆上分配，由执行它的工作线程释放
+struct Task {
+    std::function<void()> fn;
+    
+    explicit Task(std::function<void()> fn) : fn(std::move(fn)) {}
+};
+
+// Chase-Lev工作窃取双端队列（按Lê等人给出的弱内存模型版本实现）
+// 只有所属工作线程在底部push/pop，其他线程从顶部steal；数组写满时加倍扩容，
+// 旧数组可能仍被窃取方读取，保留到队列销毁时才释放
+class WorkStealingDeque {
+public:
+    WorkStealingDeque();
+    ~WorkStealingDeque();
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    
+    // 所属线程：压入/弹出底部（LIFO，缓存友好）
+    void push(Task* task);
+    Task* pop();
+    
+    // 任意线程：从顶部窃取（FIFO），队列为空或与其他窃取方/所属线程竞争失败时返回空指针
+    Task* steal();
+    
+    // 近似判断是否为空（用于睡眠前的检查）
+    bool empty() const;
+    
+private:
+    struct Array;
+    
+    Array* grow(Array* array, int64_t bottom, int64_t top);
+    
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    std::atomic<Array*> array;
+    std::vector<Array*> retired;    // 扩容后被替换的数组（只由所属线程访问）
+};
+
+// 调度器的工作线程：在Thread之上运行窃取循环，没有任务时通过ThreadManager的Sleep()睡眠
+class SchedulerWorker : public Thread {
+public:
+    SchedulerWorker(TaskScheduler* scheduler, size_t index, const std::string& name);
+    ~SchedulerWorker();
+    
+    void run() override;
+    
+private:
+    friend class TaskScheduler;
+    
+    // 依次从本地队列、全局注入队列、随机选取的其他工作线程获取任务
+    Task* findTask();
+    
+    // 执行并释放任务
+    void execute(Task* task);
+    
+    // 没有任务时睡眠，返回前已重新标记为忙碌
+    void park();
+    
+    TaskScheduler* scheduler;
+    size_t index;
+    uint64_t randomState;               // 选取窃取目标的xorshift状态
+    WorkStealingDeque deque;
+    ParkHandle handle;                  // 在ThreadManager中的注册句柄（在第一次宣告空闲之前写入）
+    alignas(64) std::atomic<bool> idle; // 是否已宣告空闲（准备睡眠或正在睡眠）
+};
+
+// 工作窃取任务调度器
+// 每个工作线程拥有一个Chase-Lev双端队列：工作线程内提交的任务压入自己的队列，其他线程提交的任务进入全局注入队列；
+// 空闲的工作线程从随机选取的其他工作线程窃取任务，仍然没有任务时注册为空闲并通过ThreadManager的Sleep()睡眠
+// （许可模式，睡眠前到达的唤醒不会丢失）；提交任务时只在有空闲工作线程时唤醒其中一个
+class DLL_API TaskScheduler {
+public:
+    // workerCount为0时使用std::thread::hardware_concurrency()
+    // name用作工作线程注册名的前缀，再加上进程内唯一的实例编号（例如"scheduler#2_worker0"），同名的调度器可以同时存在
+    explicit TaskScheduler(size_t workerCount = 0, const std::string& name = "scheduler");
+    
+    // 停止调度器（见stop()）
+    ~TaskScheduler();
+    
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+    
+    // 启动全部工作线程并等待它们注册到ThreadManager；启动前提交的任务在启动后执行
+    // 任何一个工作线程启动或注册失败（例如线程数达到上限）时停止调度器并返回false，之后提交的任务被丢弃
+    bool start();
+    
+    // 执行完已提交的全部任务后停止并等待工作线程退出；之后提交的任务被丢弃
+    void stop();
+    
+    // 提交任务（任意线程）
+    void submit(std::function<void()> fn);
+    
+    // 批量提交：一次放入全部任务，再认领最多同样数量的空闲工作线程，通过一次WakeupMany()唤醒
+    void submitBatch(std::vector<std::function<void()>> fns);
+    
+    size_t workerCount() const { return workers.size(); }
+    
+    // 工作线程注册名的前缀（例如"scheduler#2_worker"），第i个工作线程注册为前缀加上i
+    const std::string& workerNamePrefix() const { return workerPrefix; }
+    
+    // 当前线程是否是本调度器的工作线程，是则返回其下标，否则返回-1
+    int currentWorkerIndex() const;
+    
+private:
+    friend class SchedulerWorker;
+    
+    // 有空闲的工作线程时唤醒其中一个
+    void wakeOneIdle();
+    
+    // 认领并批量唤醒最多maxCount个空闲的工作线程
+    void wakeIdle(size_t maxCount);
+    
+    // 从全局注入队列取出任务
+    Task* popInjected();
+    
+    // 是否还有可执行的任务（睡眠前的检查）
+    bool hasWork() const;
+    
+    // 工作线程报告注册结果（start()等待全部已启动的工作线程报告）
+    void reportRegistration(bool registered);
+    
+    std::string name;
+    std::string workerPrefix;
+    std::vector<SchedulerWorker*> workers;
+    
+    // 全局注入队列：非工作线程提交的任务（加锁，只在跨线程提交时使用）
+    std::mutex injectMutex;
+    std::deque<Task*> injected;
+    std::atomic<size_t> injectedCount;
+    
+    alignas(64) std::atomic<int> idleCount;       // 已宣告空闲的工作线程数
+    alignas(64) std::atomic<uint32_t> wakeCursor; // 唤醒空闲线程时的起始位置，避免总是唤醒同一个
+    size_t startedWorkers;                        // 已启动的工作线程数（只由调用start()/stop()的线程访问）
+    std::atomic<bool> stopping;
+    
+    // 工作线程的注册结果
+    std::mutex startMutex;
+    std::condition_variable startCond;
+    size_t registeredWorkers;
+    size_t failedWorkers;
+};
+
+#endif // TASK_SCHEDULER_H
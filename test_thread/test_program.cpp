@@ -1,7 +1,107 @@
 #include "thread_manager.h"
+#include "thread_manager_pthread.h"
+#include "timer_service.h"
+#include "task_scheduler.h"
+#include "parallel.h"
+#include "shm_thread_manager.h"
+#include "cpu_topology.h"
+#include "thread.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#ifdef __linux__
+#include <unistd.h>
+#include <sched.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+// 失败的检查数（作为程序的返回值）
+static int failedChecks = 0;
+
+// 检查结果并输出
+void check(bool condition, const std::string& description) {
+    std::cout << (condition ? "[PASS] " : "[FAIL] ") << description << std::endl;
+    if (!condition) {
+        failedChecks++;
+    }
+}
+
+// 等待条件成立，超时返回false
+bool waitUntil(const std::function<bool()>& condition, std::chrono::milliseconds timeout) {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// 线程注册之后、第一次睡眠之前收到wakeups次Wakeup，统计之后有多少次Sleep()不阻塞就返回
+int sleepsAfterEarlyWakeups(const std::string& threadName, uint32_t permitLimit, int wakeups) {
+    std::atomic<bool> registered(false);
+    std::atomic<bool> go(false);
+    std::atomic<bool> stop(false);
+    std::atomic<bool> exited(false);
+    std::atomic<int> returned(0);
+    
+    std::thread worker([&]() {
+        RegisterOptions options;
+        options.permitLimit = permitLimit;
+        ThreadManager::getInstance()->registerThread(threadName, std::this_thread::get_id(), options);
+        registered = true;
+        while (!go) {
+            std::this_thread::yield();
+        }
+        while (!stop) {
+            Sleep();
+            if (!stop) {
+                returned++;
+            }
+        }
+        ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        exited = true;
+    });
+    
+    waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+    for (int i = 0; i < wakeups; ++i) {
+        Wakeup(threadName);
+    }
+    go = true;
+    
+    // 许可被消费完之后线程应当阻塞在Sleep()中
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int result = returned.load();
+    
+    // 未睡眠时到达的唤醒可能被丢弃，重复唤醒直到线程退出
+    stop = true;
+    while (!exited) {
+        Wakeup(threadName);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    worker.join();
+    return result;
+}
+
+// 许可语义：提前到达的Wakeup保存为许可，下一次Sleep()消费它并立即返回
+void testPermits() {
+    std::cout << "\n=== Test 4: Early wakeups and permits ===" << std::endl;
+    check(sleepsAfterEarlyWakeups("PermitNone", 0, 1) == 0, "without permits an early Wakeup is dropped");
+    check(sleepsAfterEarlyWakeups("PermitBinary", 1, 1) == 1, "an early Wakeup is consumed by the next Sleep()");
+    check(sleepsAfterEarlyWakeups("PermitBinary", 1, 3) == 1, "binary permit coalesces repeated early Wakeups");
+    check(sleepsAfterEarlyWakeups("PermitCounting", 3, 2) == 2, "counting permits keep every early Wakeup");
+    check(sleepsAfterEarlyWakeups("PermitCounting", 3, 5) == 3, "counting permits are capped at permitLimit");
+}
 
 // 子线程函数（C++标准库版本）
 void workerThreadFunc(const std::string& threadName) {
@@ -24,6 +124,1256 @@ void workerThreadFunc(const std::string& threadName) {
     std::cout << "Worker thread exited: " << threadName << std::endl;
 }
 
+// 组唤醒：组成员使用二值许可，唤醒不依赖成员是否已经进入睡眠
+void testGroups() {
+    std::cout << "\n=== Test 5: Thread groups ===" << std::endl;
+    
+    const int kMembers = 4;
+    std::atomic<int> wakeups[kMembers];
+    std::atomic<int> registered(0);
+    std::atomic<int> exited(0);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> members;
+    for (int i = 0; i < kMembers; ++i) {
+        wakeups[i] = 0;
+        members.push_back(std::thread([&, i]() {
+            // 成员0-2属于组Pool，成员3只属于组Other；成员2同时属于两个组
+            RegisterOptions options;
+            options.permitLimit = 1;
+            if (i < 3) {
+                options.groups.push_back("Pool");
+            }
+            if (i >= 2) {
+                options.groups.push_back("Other");
+            }
+            ThreadManager::getInstance()->registerThread("GroupMember" + std::to_string(i),
+                                                         std::this_thread::get_id(), options);
+            registered++;
+            while (!stop) {
+                Sleep();
+                if (!stop) {
+                    wakeups[i]++;
+                }
+            }
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+            exited++;
+        }));
+    }
+    waitUntil([&]() { return registered == kMembers; }, std::chrono::seconds(5));
+    
+    auto total = [&]() {
+        int sum = 0;
+        for (int i = 0; i < kMembers; ++i) {
+            sum += wakeups[i];
+        }
+        return sum;
+    };
+    
+    // WakeupGroup()唤醒组内全部成员，不唤醒组外的线程
+    check(WakeupGroup("Pool") == 3, "WakeupGroup delivers to every member");
+    check(waitUntil([&]() { return wakeups[0] == 1 && wakeups[1] == 1 && wakeups[2] == 1; },
+                    std::chrono::seconds(5)), "every group member wakes up");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    check(wakeups[3] == 0, "threads outside the group are not woken");
+    
+    // WakeupOneOfGroup()只唤醒一个成员
+    for (int round = 1; round <= 3; ++round) {
+        int before = total();
+        check(WakeupOneOfGroup("Pool"), "WakeupOneOfGroup delivers a wakeup");
+        waitUntil([&]() { return total() > before; }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        check(total() == before + 1 && wakeups[3] == 0, "WakeupOneOfGroup wakes exactly one member");
+    }
+    
+    // 属于多个组的线程可以通过任一组唤醒
+    int shared = wakeups[2];
+    check(WakeupGroup("Other") == 2, "a thread can belong to several groups");
+    check(waitUntil([&]() { return wakeups[2] == shared + 1 && wakeups[3] == 1; }, std::chrono::seconds(5)),
+          "members of the second group wake up");
+    check(WakeupGroup("NoSuchGroup") == 0, "waking an unknown group delivers nothing");
+    
+    stop = true;
+    while (exited < kMembers) {
+        WakeupGroup("Pool");
+        WakeupGroup("Other");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (size_t i = 0; i < members.size(); ++i) {
+        members[i].join();
+    }
+    check(WakeupGroup("Pool") == 0, "a group is removed when its last member unregisters");
+}
+
+// 限时睡眠：分别因超时、被唤醒和被注销而返回
+void testTimedSleep() {
+    std::cout << "\n=== Test 6: Timed sleeps ===" << std::endl;
+    
+    // 超时：没有唤醒时在截止时间之后返回
+    {
+        WakeReason reason = kWakeNotified;
+        std::chrono::steady_clock::duration elapsed;
+        std::thread sleeper([&]() {
+            ThreadManager::getInstance()->registerThread("TimedTimeout", std::this_thread::get_id());
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            reason = SleepFor(std::chrono::milliseconds(50));
+            elapsed = std::chrono::steady_clock::now() - start;
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        sleeper.join();
+        check(reason == kWakeTimeout, "SleepFor returns kWakeTimeout when nobody wakes the thread");
+        check(elapsed >= std::chrono::milliseconds(50), "SleepFor does not return before the deadline");
+    }
+    
+    // 被唤醒：使用二值许可，Wakeup()无论在睡眠之前还是之后到达都不会丢失
+    {
+        WakeReason reason = kWakeTimeout;
+        std::atomic<bool> registered(false);
+        std::chrono::steady_clock::duration elapsed;
+        std::thread sleeper([&]() {
+            RegisterOptions options;
+            options.permitLimit = 1;
+            ThreadManager::getInstance()->registerThread("TimedNotified", std::this_thread::get_id(), options);
+            registered = true;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            reason = SleepFor(std::chrono::seconds(10));
+            elapsed = std::chrono::steady_clock::now() - start;
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        Wakeup("TimedNotified");
+        sleeper.join();
+        check(reason == kWakeNotified, "SleepFor returns kWakeNotified when woken");
+        check(elapsed < std::chrono::seconds(5), "a woken SleepFor returns before its deadline");
+    }
+    
+    // 被注销：其他线程注销睡眠中的线程
+    {
+        WakeReason reason = kWakeTimeout;
+        std::atomic<bool> registered(false);
+        ParkHandle handle;
+        std::thread sleeper([&]() {
+            handle = ThreadManager::getInstance()->registerThread("TimedUnregistered", std::this_thread::get_id());
+            registered = true;
+            reason = SleepFor(std::chrono::seconds(10));
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ThreadManager::getInstance()->unregisterThread(handle);
+        sleeper.join();
+        check(reason == kWakeUnregistered, "SleepFor returns kWakeUnregistered when the thread is unregistered");
+    }
+}
+
+// 定时唤醒：线程使用二值许可，定时器在睡眠之前到期也不会丢失
+void testTimerService() {
+    std::cout << "\n=== Test 7: Timer service ===" << std::endl;
+    TimerService* timers = TimerService::getInstance();
+    
+    // 单次定时器：三个线程的截止时间分布在时间轮的不同层（粒度100微秒，每层64个槽），按截止时间先后到期
+    {
+        const int kSleepers = 3;
+        const int delaysMs[kSleepers] = {500, 2, 20};
+        std::chrono::steady_clock::duration elapsed[kSleepers];
+        WakeReason reasons[kSleepers];
+        std::atomic<int> registered(0);
+        ParkHandle handles[kSleepers];
+        std::vector<std::thread> sleepers;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kSleepers; ++i) {
+            sleepers.push_back(std::thread([&, i]() {
+                RegisterOptions options;
+                options.permitLimit = 1;
+                handles[i] = ThreadManager::getInstance()->registerThread("TimerTarget" + std::to_string(i),
+                                                                          std::this_thread::get_id(), options);
+                registered++;
+                reasons[i] = SleepFor(std::chrono::seconds(10));
+                elapsed[i] = std::chrono::steady_clock::now() - start;
+                ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+            }));
+        }
+        waitUntil([&]() { return registered == kSleepers; }, std::chrono::seconds(5));
+        timers->scheduleWakeupAt(handles[0], start + std::chrono::milliseconds(delaysMs[0]));
+        timers->scheduleWakeupAt("TimerTarget1", start + std::chrono::milliseconds(delaysMs[1]));
+        timers->scheduleWakeupAt(handles[2], start + std::chrono::milliseconds(delaysMs[2]));
+        for (size_t i = 0; i < sleepers.size(); ++i) {
+            sleepers[i].join();
+        }
+        
+        bool notified = true;
+        bool onTime = true;
+        for (int i = 0; i < kSleepers; ++i) {
+            notified = notified && reasons[i] == kWakeNotified;
+            onTime = onTime && elapsed[i] >= std::chrono::milliseconds(delaysMs[i]);
+        }
+        check(notified, "one-shot timers wake their targets (by handle and by name)");
+        check(onTime, "one-shot timers never fire before their deadline");
+        check(elapsed[1] < elapsed[2] && elapsed[2] < elapsed[0], "one-shot timers fire in deadline order");
+    }
+    
+    // 取消：被取消的定时器不再唤醒目标
+    {
+        WakeReason reason = kWakeNotified;
+        std::atomic<bool> registered(false);
+        ParkHandle handle;
+        std::thread sleeper([&]() {
+            RegisterOptions options;
+            options.permitLimit = 1;
+            handle = ThreadManager::getInstance()->registerThread("TimerCancelled", std::this_thread::get_id(), options);
+            registered = true;
+            reason = SleepFor(std::chrono::milliseconds(200));
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        size_t pending = timers->pendingCount();
+        TimerId id = timers->scheduleWakeup(handle, std::chrono::milliseconds(50));
+        check(timers->pendingCount() == pending + 1, "a scheduled timer is pending");
+        check(timers->cancel(id), "a pending timer can be cancelled");
+        check(!timers->cancel(id), "a cancelled timer cannot be cancelled again");
+        sleeper.join();
+        check(reason == kWakeTimeout, "a cancelled timer does not wake its target");
+    }
+    
+    // 周期定时器：每10毫秒唤醒一次，取消后不再唤醒
+    {
+        std::atomic<int> wakeups(0);
+        std::atomic<bool> registered(false);
+        std::atomic<bool> stop(false);
+        ParkHandle handle;
+        std::thread sleeper([&]() {
+            RegisterOptions options;
+            options.permitLimit = 1;
+            handle = ThreadManager::getInstance()->registerThread("TimerPeriodic", std::this_thread::get_id(), options);
+            registered = true;
+            while (!stop) {
+                if (SleepFor(std::chrono::milliseconds(100)) == kWakeNotified) {
+                    wakeups++;
+                }
+            }
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        TimerId id = timers->schedulePeriodicWakeup(handle, std::chrono::milliseconds(10));
+        check(waitUntil([&]() { return wakeups >= 5; }, std::chrono::seconds(5)), "a periodic timer keeps firing");
+        check(timers->cancel(id), "a periodic timer can be cancelled");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        int afterCancel = wakeups;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        check(wakeups == afterCancel, "a cancelled periodic timer stops firing");
+        stop = true;
+        sleeper.join();
+    }
+}
+
+// 构造一条消息：type为发送方编号，data中存放序号
+ThreadMessage makeMessage(uint32_t sender, uint32_t sequence) {
+    ThreadMessage message;
+    message.type = sender;
+    message.size = sizeof(sequence);
+    memcpy(message.data, &sequence, sizeof(sequence));
+    return message;
+}
+
+uint32_t sequenceOf(const ThreadMessage& message) {
+    uint32_t sequence;
+    memcpy(&sequence, message.data, sizeof(sequence));
+    return sequence;
+}
+
+// 邮箱：Post()投递定长消息，Sleep(messages, maxCount)取出消息
+void testMailbox() {
+    std::cout << "\n=== Test 8: Mailbox ===" << std::endl;
+    
+    // 睡眠之前投递的消息：下一次Sleep()不阻塞，按投递顺序取出；邮箱满时Post()返回false
+    {
+        std::atomic<bool> registered(false);
+        std::atomic<bool> go(false);
+        size_t received = 0;
+        bool ordered = true;
+        std::thread receiver([&]() {
+            RegisterOptions options;
+            options.mailboxCapacity = 4;
+            ThreadManager::getInstance()->registerThread("MailboxSmall", std::this_thread::get_id(), options);
+            registered = true;
+            while (!go) {
+                std::this_thread::yield();
+            }
+            ThreadMessage messages[8];
+            received = Sleep(messages, 8);
+            for (size_t i = 0; i < received; ++i) {
+                ordered = ordered && sequenceOf(messages[i]) == i;
+            }
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        bool posted = true;
+        for (uint32_t i = 0; i < 4; ++i) {
+            posted = Post("MailboxSmall", makeMessage(0, i)) && posted;
+        }
+        check(posted, "Post succeeds while the mailbox has room");
+        check(!Post("MailboxSmall", makeMessage(0, 4)), "Post fails when the mailbox is full");
+        go = true;
+        receiver.join();
+        check(received == 4 && ordered, "Sleep returns messages posted before it, in order, without blocking");
+        check(!Post("MailboxSmall", makeMessage(0, 0)), "Post fails after the receiver unregisters");
+    }
+    
+    // 未启用邮箱的线程
+    {
+        std::atomic<bool> registered(false);
+        std::atomic<bool> done(false);
+        std::thread plain([&]() {
+            ThreadManager::getInstance()->registerThread("MailboxNone", std::this_thread::get_id());
+            registered = true;
+            while (!done) {
+                std::this_thread::yield();
+            }
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        check(!Post("MailboxNone", makeMessage(0, 0)), "Post fails for a thread without a mailbox");
+        done = true;
+        plain.join();
+    }
+    
+    // 多个发送方并发投递：每条消息恰好收到一次，同一发送方的消息保持顺序
+    {
+        const uint32_t kSenders = 4;
+        const uint32_t kPerSender = 2000;
+        std::atomic<bool> registered(false);
+        ParkHandle handle;
+        size_t received = 0;
+        bool ordered = true;
+        std::thread receiver([&]() {
+            RegisterOptions options;
+            options.mailboxCapacity = 64;
+            handle = ThreadManager::getInstance()->registerThread("MailboxBusy", std::this_thread::get_id(), options);
+            registered = true;
+            std::vector<uint32_t> next(kSenders, 0);
+            ThreadMessage messages[16];
+            while (received < kSenders * kPerSender) {
+                size_t count = Sleep(messages, 16);
+                for (size_t i = 0; i < count; ++i) {
+                    uint32_t sender = messages[i].type;
+                    if (sender >= kSenders || sequenceOf(messages[i]) != next[sender]) {
+                        ordered = false;
+                    } else {
+                        next[sender]++;
+                    }
+                }
+                received += count;
+            }
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        std::vector<std::thread> senders;
+        for (uint32_t s = 0; s < kSenders; ++s) {
+            senders.push_back(std::thread([&, s]() {
+                for (uint32_t i = 0; i < kPerSender; ++i) {
+                    // 邮箱满时让出CPU后重试
+                    while (!Post(handle, makeMessage(s, i))) {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        }
+        for (size_t s = 0; s < senders.size(); ++s) {
+            senders[s].join();
+        }
+        receiver.join();
+        check(received == kSenders * kPerSender, "every message from concurrent senders is received once");
+        check(ordered, "messages from one sender arrive in order");
+    }
+}
+
+// 工作窃取调度器
+void testTaskScheduler() {
+    std::cout << "\n=== Test 9: Task scheduler ===" << std::endl;
+    
+    // 两个同名（默认名）的调度器同时运行，各自执行全部任务
+    {
+        std::atomic<int> ran(0);
+        TaskScheduler first(2);
+        TaskScheduler second(2);
+        check(first.start() && second.start(), "two schedulers with the default name start");
+        for (int i = 0; i < 100; ++i) {
+            first.submit([&]() { ran++; });
+            second.submit([&]() { ran++; });
+        }
+        first.stop();
+        second.stop();
+        check(ran == 200, "both schedulers run every submitted task");
+    }
+    
+    // 启动前提交、批量提交、工作线程内提交的任务都会执行，stop()执行完全部任务后返回
+    {
+        const int kTasks = 1000;
+        std::atomic<int> ran(0);
+        std::atomic<int> nested(0);
+        TaskScheduler scheduler(4, "TestScheduler");
+        scheduler.submit([&]() { ran++; });
+        check(scheduler.start(), "a scheduler starts with tasks submitted before start()");
+        
+        std::vector<std::function<void()>> batch;
+        for (int i = 0; i < kTasks; ++i) {
+            batch.push_back([&]() {
+                ran++;
+                // 工作线程内提交的任务进入本地队列，可以被其他工作线程窃取
+                scheduler.submit([&]() { nested++; });
+            });
+        }
+        scheduler.submitBatch(batch);
+        scheduler.stop();
+        check(ran == kTasks + 1, "every submitted task runs before stop() returns");
+        check(nested == kTasks, "tasks submitted from worker threads run too");
+        
+        scheduler.submit([&]() { ran++; });
+        check(ran == kTasks + 1, "tasks submitted after stop() are discarded");
+    }
+    
+    // 工作线程注册失败时start()返回false
+    {
+        std::atomic<bool> registered(false);
+        std::atomic<bool> done(false);
+        bool started = true;
+        {
+            TaskScheduler scheduler(2, "Conflict");
+            
+            // 启动之前占用这个调度器的一个工作线程名
+            std::string conflictingName = scheduler.workerNamePrefix() + "1";
+            std::thread occupant([&]() {
+                ThreadManager::getInstance()->registerThread(conflictingName, std::this_thread::get_id());
+                registered = true;
+                while (!done) {
+                    std::this_thread::yield();
+                }
+                ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+            });
+            waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+            started = scheduler.start();
+            done = true;
+            occupant.join();
+        }
+        check(!started, "start() fails when a worker cannot register");
+    }
+}
+
+// 并行循环与归约
+void testParallel() {
+    std::cout << "\n=== Test 10: parallel_for / parallel_reduce ===" << std::endl;
+    
+    TaskScheduler scheduler(4, "TestParallel");
+    check(scheduler.start(), "the parallel test scheduler starts");
+    
+    // 每个元素恰好被处理一次（两种分块方式，长度不是块大小的整数倍）
+    const int kLength = 100003;
+    ParallelChunking chunkings[2] = {kChunkStatic, kChunkDynamic};
+    for (int c = 0; c < 2; ++c) {
+        std::vector<std::atomic<int>> visits(kLength);
+        for (int i = 0; i < kLength; ++i) {
+            visits[i] = 0;
+        }
+        parallel_for(scheduler, 0, kLength, 1000, [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                visits[i]++;
+            }
+        }, chunkings[c]);
+        bool once = true;
+        for (int i = 0; i < kLength; ++i) {
+            once = once && visits[i] == 1;
+        }
+        check(once, std::string(c == 0 ? "static" : "dynamic") + " parallel_for visits every index once");
+    }
+    
+    // 归约结果与顺序计算一致
+    long long expected = static_cast<long long>(kLength) * (kLength - 1) / 2;
+    long long sum = parallel_reduce(scheduler, 0, kLength, 1000, 0LL, [](int first, int last) {
+        long long partial = 0;
+        for (int i = first; i < last; ++i) {
+            partial += i;
+        }
+        return partial;
+    }, [](long long a, long long b) { return a + b; });
+    check(sum == expected, "parallel_reduce matches the sequential sum");
+    
+    // 空区间返回单位元
+    check(parallel_reduce(scheduler, 5, 5, 1, 42LL, [](int, int) { return 0LL; },
+                          [](long long a, long long b) { return a + b; }) == 42,
+          "parallel_reduce over an empty range returns the identity");
+    
+    // 在工作线程内嵌套调用不会死锁
+    std::atomic<long long> nestedSum(0);
+    parallel_for(scheduler, 0, 8, 1, [&](int first, int last) {
+        for (int outer = first; outer < last; ++outer) {
+            nestedSum += parallel_reduce(scheduler, 0, 1000, 10, 0LL, [](int a, int b) {
+                return static_cast<long long>(b - a);
+            }, [](long long a, long long b) { return a + b; });
+        }
+    });
+    check(nestedSum == 8 * 1000, "nested parallel calls inside workers complete");
+    
+    // 块中抛出的异常在调用线程中重新抛出
+    bool caught = false;
+    try {
+        parallel_for(scheduler, 0, 1000, 10, [](int first, int) {
+            if (first == 500) {
+                throw std::runtime_error("chunk failed");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    check(caught, "an exception thrown in a chunk is rethrown to the caller");
+    
+    scheduler.stop();
+}
+
+#ifdef __linux__
+// 跨进程管理器：子进程中的线程被父进程按句柄唤醒；未注销就退出的进程留下的槽位被回收
+void testSharedMemory() {
+    std::cout << "\n=== Test 11: Cross-process thread manager ===" << std::endl;
+    
+    const std::string segmentName = "/test_program_threads";
+    ShmThreadManager::unlinkSegment(segmentName);
+    check(ShmThreadManager::unlinkSegment(segmentName), "unlinking a missing segment succeeds");
+    ShmThreadManager* manager = ShmThreadManager::attach(segmentName);
+    check(manager != NULL, "the shared memory segment is created");
+    if (manager == NULL) {
+        return;
+    }
+    
+    // 子进程睡眠3次，每次都必须被父进程唤醒（而不是超时），否则以非0状态退出
+    pid_t pid = fork();
+    if (pid == 0) {
+        ShmThreadManager* child = ShmThreadManager::attach(segmentName);
+        if (child == NULL || !child->registerThread("child/sleeper").valid()) {
+            _exit(2);
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (child->SleepFor(std::chrono::seconds(5)) != kWakeNotified) {
+                _exit(1);
+            }
+        }
+        child->unregisterThread();
+        _exit(0);
+    }
+    
+    ParkHandle handle;
+    waitUntil([&]() { return (handle = manager->findHandle("child/sleeper")).valid(); }, std::chrono::seconds(5));
+    check(handle.valid(), "a thread registered in another process is visible");
+    int status = 0;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        manager->Wakeup(handle);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "a thread in another process is woken by handle");
+    check(!manager->Wakeup(handle), "a handle is stale after its thread unregisters");
+    
+    // 子进程注册后不注销就退出：槽位被回收，线程名可以重新注册
+    pid = fork();
+    if (pid == 0) {
+        ShmThreadManager* child = ShmThreadManager::attach(segmentName);
+        _exit(child != NULL && child->registerThread("child/crashed").valid() ? 0 : 1);
+    }
+    waitpid(pid, &status, 0);
+    check(manager->findHandle("child/crashed").valid(), "a dead process leaves its slot behind");
+    check(manager->reapDeadThreads() == 1, "reapDeadThreads reclaims the dead process's slot");
+    check(!manager->findHandle("child/crashed").valid(), "the reclaimed thread name is free again");
+    
+    // 本进程注册同名线程：超时与许可
+    check(manager->registerThread("child/crashed").valid(), "the name of a dead thread can be registered again");
+    check(manager->SleepFor(std::chrono::milliseconds(20)) == kWakeTimeout, "SleepFor times out without a wakeup");
+    manager->Wakeup("child/crashed");
+    check(manager->SleepFor(std::chrono::milliseconds(20)) == kWakeNotified, "a Wakeup before SleepFor is kept");
+    manager->unregisterThread();
+    
+    ShmThreadManager::unlinkSegment(segmentName);
+}
+#endif
+
+// 条件变量实现的管理器：注册、睡眠和唤醒，限时睡眠以及批量唤醒
+void testPthreadManager() {
+    std::cout << "\n=== Test 12: ThreadManagerPthread ===" << std::endl;
+    
+    // 按线程名唤醒睡眠中的线程（未睡眠时到达的唤醒会被丢弃，重复唤醒直到线程返回）
+    {
+        std::atomic<bool> registered(false);
+        std::atomic<bool> woken(false);
+        bool valid = false;
+        std::thread sleeper([&]() {
+            valid = ThreadManagerPthread::getInstance()->registerThread("PthreadSleeper", pthread_self()).valid();
+            registered = true;
+            SleepPthread();
+            woken = true;
+            ThreadManagerPthread::getInstance()->unregisterThread(pthread_self());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        bool returned = waitUntil([&]() {
+            WakeupPthread("PthreadSleeper");
+            return woken.load();
+        }, std::chrono::seconds(5));
+        sleeper.join();
+        check(valid, "ThreadManagerPthread registers a thread");
+        check(returned, "WakeupPthread wakes a sleeping thread by name");
+    }
+    
+    // 限时睡眠：没有唤醒时因超时返回，被唤醒时在截止时间之前返回
+    {
+        WakeReason timeoutReason = kWakeNotified;
+        WakeReason notifiedReason = kWakeTimeout;
+        std::chrono::steady_clock::duration elapsed;
+        std::atomic<bool> sleeping(false);
+        std::thread sleeper([&]() {
+            ThreadManagerPthread::getInstance()->registerThread("PthreadTimed", pthread_self());
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            timeoutReason = SleepForPthread(std::chrono::milliseconds(50));
+            elapsed = std::chrono::steady_clock::now() - start;
+            sleeping = true;
+            notifiedReason = SleepForPthread(std::chrono::seconds(10));
+            ThreadManagerPthread::getInstance()->unregisterThread(pthread_self());
+        });
+        waitUntil([&]() { return sleeping.load(); }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        WakeupPthread("PthreadTimed");
+        sleeper.join();
+        check(timeoutReason == kWakeTimeout, "SleepForPthread returns kWakeTimeout when nobody wakes the thread");
+        check(elapsed >= std::chrono::milliseconds(50), "SleepForPthread does not return before the deadline");
+        check(notifiedReason == kWakeNotified, "SleepForPthread returns kWakeNotified when woken");
+    }
+    
+    // 批量唤醒：WakeupManyPthread按线程名唤醒一部分线程，WakeupAllPthread唤醒其余线程
+    {
+        const int kSleepers = 4;
+        std::atomic<int> registered(0);
+        std::atomic<int> woken(0);
+        std::vector<std::thread> sleepers;
+        for (int i = 0; i < kSleepers; ++i) {
+            sleepers.push_back(std::thread([&, i]() {
+                ThreadManagerPthread::getInstance()->registerThread("PthreadBatch" + std::to_string(i), pthread_self());
+                registered++;
+                SleepPthread();
+                woken++;
+                ThreadManagerPthread::getInstance()->unregisterThread(pthread_self());
+            }));
+        }
+        waitUntil([&]() { return registered.load() == kSleepers; }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        std::vector<std::string> names;
+        names.push_back("PthreadBatch0");
+        names.push_back("PthreadBatch1");
+        size_t manyCount = WakeupManyPthread(names);
+        bool manyWoken = waitUntil([&]() { return woken.load() == 2; }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        bool othersStillAsleep = woken.load() == 2;
+        size_t allCount = WakeupAllPthread();
+        bool allWoken = waitUntil([&]() { return woken.load() == kSleepers; }, std::chrono::seconds(5));
+        for (size_t i = 0; i < sleepers.size(); ++i) {
+            sleepers[i].join();
+        }
+        check(manyCount == 2 && manyWoken && othersStillAsleep, "WakeupManyPthread wakes only the named threads");
+        check(allCount == 2 && allWoken, "WakeupAllPthread wakes the remaining sleeping threads");
+    }
+}
+
+// 失效句柄：注销之后槽位被新线程复用，用旧句柄唤醒既不投递，也不会唤醒槽位的新主人
+void testStaleHandles() {
+    std::cout << "\n=== Test 13: Stale handles ===" << std::endl;
+    
+    // ThreadManager：空闲槽位后进先出，下一次注册复用刚归还的槽位
+    {
+        ParkHandle oldHandle = ThreadManager::getInstance()->registerThread("StaleOld", std::this_thread::get_id());
+        ThreadManager::getInstance()->unregisterThread(oldHandle);
+        
+        ParkHandle newHandle;
+        std::atomic<bool> registered(false);
+        WakeReason reason = kWakeNotified;
+        std::thread owner([&]() {
+            newHandle = ThreadManager::getInstance()->registerThread("StaleNew", std::this_thread::get_id());
+            registered = true;
+            reason = SleepFor(std::chrono::milliseconds(300));
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        
+        // 睡眠之前的唤醒会成为许可，睡眠期间的唤醒会唤醒线程：两者都不应发生
+        Wakeup(oldHandle);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Wakeup(oldHandle);
+        owner.join();
+        check(newHandle.index == oldHandle.index && newHandle.generation != oldHandle.generation,
+              "ThreadManager reuses the slot with a new generation");
+        check(reason == kWakeTimeout, "ThreadManager ignores a stale handle after the slot is reused");
+    }
+    
+    // ThreadManagerPthread：同样复用刚归还的槽位
+    {
+        ParkHandle oldHandle = ThreadManagerPthread::getInstance()->registerThread("StaleOldPthread", pthread_self());
+        ThreadManagerPthread::getInstance()->unregisterThread(oldHandle);
+        
+        ParkHandle newHandle;
+        std::atomic<bool> registered(false);
+        WakeReason reason = kWakeNotified;
+        std::thread owner([&]() {
+            newHandle = ThreadManagerPthread::getInstance()->registerThread("StaleNewPthread", pthread_self());
+            registered = true;
+            reason = SleepForPthread(std::chrono::milliseconds(300));
+            ThreadManagerPthread::getInstance()->unregisterThread(pthread_self());
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        WakeupPthread(oldHandle);
+        owner.join();
+        check(newHandle.index == oldHandle.index && newHandle.generation != oldHandle.generation,
+              "ThreadManagerPthread reuses the slot with a new generation");
+        check(reason == kWakeTimeout, "ThreadManagerPthread ignores a stale handle after the slot is reused");
+    }
+}
+
+// 批量唤醒的返回值：只计入真正被唤醒的线程，不存在的线程名、失效句柄和无效句柄都不计入
+void testWakeupCounts() {
+    std::cout << "\n=== Test 14: Batch wakeup counts ===" << std::endl;
+    const int kSleepers = 4;
+    
+    // ThreadManager
+    {
+        std::vector<ParkHandle> handles(kSleepers);
+        std::atomic<int> registered(0);
+        std::atomic<int> exited(0);
+        std::vector<std::thread> sleepers;
+        for (int i = 0; i < kSleepers; ++i) {
+            sleepers.push_back(std::thread([&, i]() {
+                handles[i] = ThreadManager::getInstance()->registerThread("Count" + std::to_string(i),
+                                                                          std::this_thread::get_id());
+                registered++;
+                Sleep();
+                ThreadManager::getInstance()->unregisterThread(handles[i]);
+                exited++;
+            }));
+        }
+        waitUntil([&]() { return registered.load() == kSleepers; }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        std::vector<std::string> names;
+        names.push_back("Count0");
+        names.push_back("NoSuchThread");
+        names.push_back("Count1");
+        size_t byName = WakeupMany(names);
+        waitUntil([&]() { return exited.load() == 2; }, std::chrono::seconds(5));
+        
+        // Count0和Count1已注销，它们的句柄已失效
+        std::vector<ParkHandle> batch;
+        batch.push_back(handles[0]);
+        batch.push_back(handles[2]);
+        batch.push_back(handles[1]);
+        batch.push_back(ParkHandle());
+        size_t byHandle = WakeupMany(batch);
+        waitUntil([&]() { return exited.load() == 3; }, std::chrono::seconds(5));
+        size_t all = WakeupAll();
+        waitUntil([&]() { return exited.load() == kSleepers; }, std::chrono::seconds(5));
+        for (size_t i = 0; i < sleepers.size(); ++i) {
+            sleepers[i].join();
+        }
+        check(byName == 2, "WakeupMany(names) does not count an unknown name");
+        check(byHandle == 1, "WakeupMany(handles) does not count stale or invalid handles");
+        check(all == 1, "WakeupAll counts only the remaining sleeping thread");
+    }
+    
+    // ThreadManagerPthread
+    {
+        std::vector<ParkHandle> handles(kSleepers);
+        std::atomic<int> registered(0);
+        std::atomic<int> exited(0);
+        std::vector<std::thread> sleepers;
+        for (int i = 0; i < kSleepers; ++i) {
+            sleepers.push_back(std::thread([&, i]() {
+                handles[i] = ThreadManagerPthread::getInstance()->registerThread("CountPthread" + std::to_string(i),
+                                                                                 pthread_self());
+                registered++;
+                SleepPthread();
+                ThreadManagerPthread::getInstance()->unregisterThread(handles[i]);
+                exited++;
+            }));
+        }
+        waitUntil([&]() { return registered.load() == kSleepers; }, std::chrono::seconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        std::vector<std::string> names;
+        names.push_back("CountPthread0");
+        names.push_back("NoSuchThread");
+        names.push_back("CountPthread1");
+        size_t byName = WakeupManyPthread(names);
+        waitUntil([&]() { return exited.load() == 2; }, std::chrono::seconds(5));
+        
+        std::vector<ParkHandle> batch;
+        batch.push_back(handles[0]);
+        batch.push_back(handles[2]);
+        batch.push_back(handles[1]);
+        batch.push_back(ParkHandle());
+        size_t byHandle = WakeupManyPthread(batch);
+        waitUntil([&]() { return exited.load() == 3; }, std::chrono::seconds(5));
+        size_t all = WakeupAllPthread();
+        waitUntil([&]() { return exited.load() == kSleepers; }, std::chrono::seconds(5));
+        for (size_t i = 0; i < sleepers.size(); ++i) {
+            sleepers[i].join();
+        }
+        check(byName == 2, "WakeupManyPthread(names) does not count an unknown name");
+        check(byHandle == 1, "WakeupManyPthread(handles) does not count stale or invalid handles");
+        check(all == 1, "WakeupAllPthread counts only the remaining sleeping thread");
+    }
+}
+
+// 睡眠/唤醒统计：已知次数的睡眠和唤醒之后，快照中的计数与延迟直方图都与之吻合
+void testStats() {
+    std::cout << "\n=== Test 15: Sleep/wakeup statistics ===" << std::endl;
+    const int kCycles = 5;
+    
+    ParkHandle handle;
+    std::atomic<bool> registered(false);
+    std::atomic<int> cycles(0);
+    std::atomic<bool> finished(false);
+    std::atomic<bool> release(false);
+    std::thread sleeper([&]() {
+        handle = ThreadManager::getInstance()->registerThread("StatsSleeper", std::this_thread::get_id());
+        registered = true;
+        for (int i = 0; i < kCycles; ++i) {
+            Sleep();
+            cycles++;
+        }
+        finished = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+        ThreadManager::getInstance()->unregisterThread(handle);
+    });
+    waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+    
+    // 未启用许可：线程尚未睡眠时唤醒不被投递，计为多余的唤醒，重试直到投递成功
+    uint64_t missedWakeups = 0;
+    std::vector<ParkHandle> target(1, handle);
+    for (int i = 0; i < kCycles; ++i) {
+        while (WakeupMany(target) == 0) {
+            missedWakeups++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        waitUntil([&]() { return cycles.load() == i + 1; }, std::chrono::seconds(5));
+    }
+    
+    // 线程运行中收到的唤醒没有任何效果
+    waitUntil([&]() { return finished.load(); }, std::chrono::seconds(5));
+    Wakeup(handle);
+    
+    ThreadStats stats;
+    bool found = ThreadManager::getInstance()->snapshotStats(handle, stats);
+    release = true;
+    sleeper.join();
+    
+    uint64_t histogramTotal = 0;
+    for (size_t i = 0; i < ThreadStats::kWakeLatencyBuckets; ++i) {
+        histogramTotal += stats.wakeLatency[i];
+    }
+    check(found, "snapshotStats finds a registered thread");
+    check(found && stats.sleeps == kCycles && stats.parks == kCycles, "snapshotStats counts every sleep");
+    check(found && stats.wakeupsReceived == kCycles, "snapshotStats counts every delivered wakeup");
+    check(found && stats.redundantWakeups == missedWakeups + 1, "snapshotStats counts redundant wakeups");
+    check(found && histogramTotal == kCycles, "the wake latency histogram adds up to the wakeup count");
+}
+
+#ifdef __linux__
+// eventfd唤醒通道：运行中的线程被唤醒时描述符变为可读，consumeWakeups()取走唤醒并清空描述符
+void testWakeFd() {
+    std::cout << "\n=== Test 16: eventfd wake channel ===" << std::endl;
+    
+    std::atomic<bool> ready(false);
+    int fd = -1;
+    bool readable = false;
+    size_t consumed = 0;
+    bool drained = false;
+    size_t consumedAgain = 1;
+    std::thread worker([&]() {
+        RegisterOptions options;
+        options.wakeFd = true;
+        ThreadManager::getInstance()->registerThread("WakeFdThread", std::this_thread::get_id(), options);
+        fd = ThreadManager::getInstance()->getWakeFd();
+        ready = true;
+        
+        // 线程不调用Sleep()，而是在poll()中等待描述符可读
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        readable = fd >= 0 && poll(&pfd, 1, 5000) == 1 && (pfd.revents & POLLIN) != 0;
+        consumed = ThreadManager::getInstance()->consumeWakeups();
+        
+        pfd.revents = 0;
+        drained = fd >= 0 && poll(&pfd, 1, 0) == 0;
+        consumedAgain = ThreadManager::getInstance()->consumeWakeups();
+        ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+    });
+    waitUntil([&]() { return ready.load(); }, std::chrono::seconds(5));
+    Wakeup("WakeFdThread");
+    worker.join();
+    check(fd >= 0, "getWakeFd returns a descriptor when the channel is enabled");
+    check(readable, "waking a running thread makes its eventfd readable");
+    check(consumed == 1, "consumeWakeups takes the pending wakeup");
+    check(drained && consumedAgain == 0, "consumeWakeups drains the eventfd");
+}
+#endif
+
+#ifdef __linux__
+// 信号处理函数唤醒的目标线程（在安装处理函数之前设置）
+static ParkHandle signalTarget;
+static std::atomic<bool> signalDelivered(false);
+
+static void onWakeSignal(int) {
+    if (WakeupFromSignal(signalTarget)) {
+        signalDelivered = true;
+    }
+}
+
+// 在信号处理函数中唤醒：SIGUSR1发给睡眠中的线程，处理函数调用WakeupFromSignal()唤醒它自己
+void testSignalWakeup() {
+    std::cout << "\n=== Test 17: Wakeup from a signal handler ===" << std::endl;
+    
+    std::atomic<bool> registered(false);
+    WakeReason reason = kWakeTimeout;
+    std::thread sleeper([&]() {
+        // 二值许可：信号在线程睡眠之前到达也不会丢失
+        RegisterOptions options;
+        options.permitLimit = 1;
+        signalTarget = ThreadManager::getInstance()->registerThread("SignalSleeper", std::this_thread::get_id(), options);
+        registered = true;
+        reason = SleepFor(std::chrono::seconds(5));
+        ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+    });
+    waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+    
+    struct sigaction action;
+    struct sigaction previous;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onWakeSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, &previous);
+    
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int ret = pthread_kill(sleeper.native_handle(), SIGUSR1);
+    sleeper.join();
+    sigaction(SIGUSR1, &previous, NULL);
+    
+    check(ret == 0 && signalDelivered.load(), "WakeupFromSignal delivers a wakeup from a signal handler");
+    check(reason == kWakeNotified, "a thread signalled while parked wakes with kWakeNotified");
+}
+#endif
+
+#ifdef __linux__
+// CPU绑定与按距离唤醒：注册时绑定的CPU生效，无效的CPU集合使注册失败，WakeupNearestOfGroup()优先唤醒同一个核上的成员
+void testAffinity() {
+    std::cout << "\n=== Test 18: CPU affinity and nearest wakeup ===" << std::endl;
+    CpuTopology* topology = CpuTopology::getInstance();
+    
+    // 进程允许使用的CPU
+    std::vector<int> allowed;
+    cpu_set_t processSet;
+    CPU_ZERO(&processSet);
+    if (sched_getaffinity(0, sizeof(processSet), &processSet) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &processSet)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+    check(!allowed.empty(), "the process has at least one allowed CPU");
+    if (allowed.empty()) {
+        return;
+    }
+    const int nearCpu = allowed[0];
+    
+    // 注册时绑定CPU，之后线程的亲和性只包含这个CPU
+    {
+        bool valid = false;
+        bool pinned = false;
+        std::thread pinnedThread([&]() {
+            RegisterOptions options;
+            options.cpuAffinity.push_back(nearCpu);
+            valid = ThreadManager::getInstance()->registerThread("AffinityPinned", std::this_thread::get_id(), options).valid();
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            pinned = pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0 &&
+                     CPU_COUNT(&cpuSet) == 1 && CPU_ISSET(nearCpu, &cpuSet);
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        pinnedThread.join();
+        check(valid && pinned, "registerThread applies cpuAffinity to the calling thread");
+    }
+    
+    // 不存在的CPU：注册失败，线程名不被占用，线程的亲和性保持不变
+    {
+        bool rejected = false;
+        bool unchanged = false;
+        bool nameFree = false;
+        std::thread invalidThread([&]() {
+            RegisterOptions options;
+            options.cpuAffinity.push_back(static_cast<int>(topology->cpuCount()) + 1);
+            rejected = !ThreadManager::getInstance()->registerThread("AffinityInvalid", std::this_thread::get_id(),
+                                                                     options).valid();
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            unchanged = pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0 &&
+                        CPU_EQUAL(&cpuSet, &processSet);
+            nameFree = ThreadManager::getInstance()->registerThread("AffinityInvalid", std::this_thread::get_id()).valid();
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        });
+        invalidThread.join();
+        check(rejected, "registerThread fails for a CPU set with no usable CPU");
+        check(unchanged && nameFree, "a failed affinity registration leaves no trace");
+    }
+    
+    // 按距离唤醒需要两个不在同一个物理核上的CPU
+    int farCpu = -1;
+    for (size_t i = 1; i < allowed.size(); ++i) {
+        if (CpuTopology::distance(topology->locationOf(nearCpu), topology->locationOf(allowed[i])) != kSameCore) {
+            farCpu = allowed[i];
+            break;
+        }
+    }
+    if (farCpu < 0) {
+        std::cout << "WakeupNearestOfGroup check skipped: no two allowed CPUs on different cores" << std::endl;
+        return;
+    }
+    
+    // 两个成员分别绑定在唤醒方所在的CPU和另一个核上，最近的成员先被唤醒
+    const int memberCpus[2] = { nearCpu, farCpu };
+    std::atomic<int> registered(0);
+    std::atomic<int> woken(0);
+    std::atomic<int> firstWoken(-1);
+    std::vector<std::thread> members;
+    for (int i = 0; i < 2; ++i) {
+        members.push_back(std::thread([&, i]() {
+            RegisterOptions options;
+            options.groups.push_back("NearestGroup");
+            options.cpuAffinity.push_back(memberCpus[i]);
+            ThreadManager::getInstance()->registerThread("NearestMember" + std::to_string(i),
+                                                         std::this_thread::get_id(), options);
+            registered++;
+            Sleep();
+            int expected = -1;
+            firstWoken.compare_exchange_strong(expected, i);
+            woken++;
+            ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+        }));
+    }
+    waitUntil([&]() { return registered.load() == 2; }, std::chrono::seconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    
+    bool delivered = false;
+    std::thread waker([&]() {
+        RegisterOptions options;
+        options.cpuAffinity.push_back(nearCpu);
+        ThreadManager::getInstance()->registerThread("NearestWaker", std::this_thread::get_id(), options);
+        delivered = WakeupNearestOfGroup("NearestGroup");
+        ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+    });
+    waker.join();
+    waitUntil([&]() { return woken.load() >= 1; }, std::chrono::seconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    bool onlyOne = woken.load() == 1;
+    WakeupGroup("NearestGroup");
+    for (size_t i = 0; i < members.size(); ++i) {
+        members[i].join();
+    }
+    check(delivered && onlyOne && firstWoken.load() == 0,
+          "WakeupNearestOfGroup wakes the member pinned to the caller's CPU");
+}
+#endif
+
+// 槽位增长：同时注册的线程超过一个槽位块（64个），按线程名逐个唤醒，全部线程都能醒来
+void testSlotGrowth() {
+    std::cout << "\n=== Test 19: Registering more threads than one slot chunk ===" << std::endl;
+    const int kThreads = 200;
+    
+    // ThreadManager：二值许可，每个线程名只需唤醒一次
+    {
+        std::atomic<int> registered(0);
+        std::atomic<int> woken(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.push_back(std::thread([&, i]() {
+                RegisterOptions options;
+                options.permitLimit = 1;
+                if (ThreadManager::getInstance()->registerThread("Grow" + std::to_string(i), std::this_thread::get_id(),
+                                                                 options).valid()) {
+                    registered++;
+                }
+                Sleep();
+                woken++;
+                ThreadManager::getInstance()->unregisterThread(std::this_thread::get_id());
+            }));
+        }
+        bool allRegistered = waitUntil([&]() { return registered.load() == kThreads; }, std::chrono::seconds(10));
+        for (int i = 0; i < kThreads; ++i) {
+            Wakeup("Grow" + std::to_string(i));
+        }
+        bool allWoken = waitUntil([&]() { return woken.load() == kThreads; }, std::chrono::seconds(10));
+        for (size_t i = 0; i < threads.size(); ++i) {
+            threads[i].join();
+        }
+        check(allRegistered, "ThreadManager registers 200 threads");
+        check(allWoken, "ThreadManager wakes all 200 threads by name");
+    }
+    
+    // ThreadManagerPthread：未睡眠时到达的唤醒会被丢弃，重复唤醒尚未醒来的线程
+    {
+        std::atomic<int> registered(0);
+        std::atomic<int> woken(0);
+        std::atomic<bool> wokenFlags[kThreads];
+        for (int i = 0; i < kThreads; ++i) {
+            wokenFlags[i] = false;
+        }
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.push_back(std::thread([&, i]() {
+                if (ThreadManagerPthread::getInstance()->registerThread("GrowPthread" + std::to_string(i),
+                                                                        pthread_self()).valid()) {
+                    registered++;
+                }
+                SleepPthread();
+                wokenFlags[i] = true;
+                woken++;
+                ThreadManagerPthread::getInstance()->unregisterThread(pthread_self());
+            }));
+        }
+        bool allRegistered = waitUntil([&]() { return registered.load() == kThreads; }, std::chrono::seconds(10));
+        bool allWoken = waitUntil([&]() {
+            for (int i = 0; i < kThreads; ++i) {
+                if (!wokenFlags[i]) {
+                    WakeupPthread("GrowPthread" + std::to_string(i));
+                }
+            }
+            return woken.load() == kThreads;
+        }, std::chrono::seconds(10));
+        for (size_t i = 0; i < threads.size(); ++i) {
+            threads[i].join();
+        }
+        check(allRegistered, "ThreadManagerPthread registers 200 threads");
+        check(allWoken, "ThreadManagerPthread wakes all 200 threads by name");
+    }
+}
+
+#ifdef __linux__
+// 记录自己运行时的调度策略的线程
+class PolicyProbeThread : public Thread {
+public:
+    PolicyProbeThread() : Thread("PolicyProbe"), policy(-1) {}
+    
+    void run() override {
+        struct sched_param param;
+        pthread_getschedparam(pthread_self(), &policy, &param);
+    }
+    
+    int policy;
+};
+
+// Thread的调度参数：无效参数被拒绝，没有实时调度权限（EPERM）时start()以默认调度参数创建线程
+void testThreadScheduling() {
+    std::cout << "\n=== Test 20: Thread scheduling ===" << std::endl;
+    
+    {
+        PolicyProbeThread thread;
+        check(!thread.setScheduling(SCHED_FIFO, sched_get_priority_max(SCHED_FIFO) + 1),
+              "setScheduling rejects an out-of-range real-time priority");
+        check(!thread.setScheduling(-1, 0), "setScheduling rejects an unknown policy");
+    }
+    
+    // 放弃实时调度权限的子进程：按SCHED_FIFO创建线程返回EPERM，start()退回默认调度参数
+    int defaultPolicy;
+    struct sched_param defaultParam;
+    pthread_getschedparam(pthread_self(), &defaultPolicy, &defaultParam);
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct rlimit limit;
+        limit.rlim_cur = 0;
+        limit.rlim_max = 0;
+        setrlimit(RLIMIT_RTPRIO, &limit);
+        if (geteuid() == 0 && setuid(65534) != 0) {
+            _exit(2);
+        }
+        PolicyProbeThread thread;
+        bool ok = thread.setScheduling(SCHED_FIFO, sched_get_priority_min(SCHED_FIFO)) && thread.start() &&
+                  thread.join() && thread.policy == defaultPolicy;
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    bool fellBack = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    check(fellBack, "Thread::start falls back to the default policy without real-time permission");
+}
+#endif
+
+// 自旋策略：自旋期间到达的唤醒不进入阻塞路径（统计中可见），自适应模式的自旋预算不超过上限
+void testSpinPolicy() {
+    std::cout << "\n=== Test 21: Spin policies ===" << std::endl;
+    
+    // 固定自旋：自旋窗口足够长（单CPU时只yield，次数足够多），唤醒在自旋期间到达
+    ThreadManager::getInstance()->setSpinPolicy(SpinPolicy(SpinPolicy::kFixedSpin, 200000000, 1000000));
+    {
+        ParkHandle handle;
+        std::atomic<bool> registered(false);
+        std::atomic<bool> woken(false);
+        std::atomic<bool> release(false);
+        std::thread sleeper([&]() {
+            handle = ThreadManager::getInstance()->registerThread("SpinSleeper", std::this_thread::get_id());
+            registered = true;
+            Sleep();
+            woken = true;
+            while (!release) {
+                std::this_thread::yield();
+            }
+            ThreadManager::getInstance()->unregisterThread(handle);
+        });
+        waitUntil([&]() { return registered.load(); }, std::chrono::seconds(5));
+        
+        // 未启用许可：线程进入PARKING（开始自旋）之前的唤醒不被投递，重试直到投递成功
+        std::vector<ParkHandle> target(1, handle);
+        waitUntil([&]() { return WakeupMany(target) == 1; }, std::chrono::seconds(5));
+        waitUntil([&]() { return woken.load(); }, std::chrono::seconds(5));
+        
+        ThreadStats stats;
+        bool found = ThreadManager::getInstance()->snapshotStats(handle, stats);
+        release = true;
+        sleeper.join();
+        check(woken.load(), "a spinning thread is woken");
+        check(found && stats.sleeps == 1 && stats.spinWakeups == 1,
+              "a wakeup during the spin window returns without blocking");
+    }
+    ThreadManager::getInstance()->setSpinPolicy(SpinPolicy());
+    
+    // 自适应自旋：预算是最近等待时长滑动平均的两倍，任何时候都不超过上限，等待较长时不再自旋
+    {
+        SpinPolicy adaptive(SpinPolicy::kAdaptiveSpin, 10000, 0);
+        AdaptiveSpinState state;
+        check(state.spinNanos(adaptive) == 0, "adaptive spinning starts without a budget");
+        
+        bool bounded = true;
+        for (int i = 0; i < 100; ++i) {
+            state.record(adaptive, 4000);
+            bounded = bounded && state.spinNanos(adaptive) <= adaptive.spinNanos;
+        }
+        uint32_t shortBudget = state.spinNanos(adaptive);
+        check(bounded && shortBudget > 0, "short waits give a spin budget within spinNanos");
+        
+        for (int i = 0; i < 100; ++i) {
+            state.record(adaptive, 1000000);
+            bounded = bounded && state.spinNanos(adaptive) <= adaptive.spinNanos;
+        }
+        check(bounded && state.spinNanos(adaptive) == 0, "long waits turn adaptive spinning off");
+        
+        for (int i = 0; i < 100; ++i) {
+            state.record(adaptive, 4000);
+        }
+        state.reset();
+        check(state.spinNanos(adaptive) == 0, "reset() clears the adaptive spin budget");
+    }
+}
+
 int main() {
     std::cout << "Main thread started" << std::endl;
     
@@ -72,6 +1422,31 @@ int main() {
     worker3.join();
     worker4.join();
     
-    std::cout << "\nMain thread exited" << std::endl;
-    return 0;
+    testPermits();
+    testGroups();
+    testTimedSleep();
+    testTimerService();
+    testMailbox();
+    testTaskScheduler();
+    testParallel();
+#ifdef __linux__
+    testSharedMemory();
+#endif
+    testPthreadManager();
+    testStaleHandles();
+    testWakeupCounts();
+    testStats();
+#ifdef __linux__
+    testWakeFd();
+    testSignalWakeup();
+    testAffinity();
+#endif
+    testSlotGrowth();
+#ifdef __linux__
+    testThreadScheduling();
+#endif
+    testSpinPolicy();
+    
+    std::cout << "\nMain thread exited, " << failedChecks << " checks failed" << std::endl;
+    return failedChecks == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -1,21 +1,24 @@
 #include "thread.h"
+#include "thread_log.h"
 #include <unistd.h>
+#include <sched.h>
 
 // Thread基类实现
-Thread::Thread(const std::string& name) : name(name), running(false) {
+Thread::Thread(const std::string& name)
+    : name(name), running(false), schedPolicy(SCHED_OTHER), schedPriority(0) {
     int ret;
     
     // 初始化互斥锁
     ret = pthread_mutex_init(&mutex, NULL);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_init failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_init failed for " << name << ": " << ret);
         // 注意：在构造函数中如果互斥锁初始化失败，可能需要更复杂的错误处理
     }
     
     // 初始化条件变量
     ret = pthread_cond_init(&cond, NULL);
     if (ret != 0) {
-        std::cerr << "Error: pthread_cond_init failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_cond_init failed for " << name << ": " << ret);
         // 注意：在构造函数中如果条件变量初始化失败，可能需要更复杂的错误处理
     }
 }
@@ -26,13 +29,13 @@ Thread::~Thread() {
     // 销毁条件变量
     ret = pthread_cond_destroy(&cond);
     if (ret != 0) {
-        std::cerr << "Error: pthread_cond_destroy failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_cond_destroy failed for " << name << ": " << ret);
     }
     
     // 销毁互斥锁
     ret = pthread_mutex_destroy(&mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_destroy failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_destroy failed for " << name << ": " << ret);
     }
 }
 
@@ -40,19 +43,98 @@ bool Thread::start() {
     int ret;
     
     if (running) {
-        std::cerr << "Error: Thread " << name << " is already running" << std::endl;
+        THREAD_LOG_ERROR("Error: Thread " << name << " is already running");
         return false;
     }
     
     running = true;
-    ret = pthread_create(&tid, NULL, threadFunc, this);
+    if (schedPolicy != SCHED_OTHER) {
+        ret = createWithScheduling();
+        if (ret == EPERM) {
+            // 没有实时调度权限：以默认调度参数创建线程
+            THREAD_LOG_WARN("Warning: No permission for real-time scheduling, starting " << name << " with default policy");
+            ret = pthread_create(&tid, NULL, threadFunc, this);
+        }
+    } else {
+        ret = pthread_create(&tid, NULL, threadFunc, this);
+    }
     if (ret != 0) {
-        std::cerr << "Error: pthread_create failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_create failed for " << name << ": " << ret);
         running = false;
         return false;
     }
     
-    std::cout << "Thread " << name << " started successfully" << std::endl;
+    THREAD_LOG_INFO("Thread " << name << " started successfully");
+    return true;
+}
+
+bool Thread::setScheduling(int policy, int priority) {
+    if (running) {
+        THREAD_LOG_ERROR("Error: Thread " << name << " is already running");
+        return false;
+    }
+    
+    if (policy != SCHED_OTHER && policy != SCHED_FIFO && policy != SCHED_RR) {
+        THREAD_LOG_ERROR("Error: Invalid scheduling policy for " << name << ": " << policy);
+        return false;
+    }
+    
+    if (policy != SCHED_OTHER &&
+        (priority < sched_get_priority_min(policy) || priority > sched_get_priority_max(policy))) {
+        THREAD_LOG_ERROR("Error: Invalid real-time priority for " << name << ": " << priority);
+        return false;
+    }
+    
+    schedPolicy = policy;
+    schedPriority = priority;
+    return true;
+}
+
+int Thread::createWithScheduling() {
+    int ret;
+    pthread_attr_t attr;
+    struct sched_param param;
+    
+    ret = pthread_attr_init(&attr);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_attr_init failed for " << name << ": " << ret);
+        return ret;
+    }
+    
+    // 使用属性中的调度参数，而不是继承创建者的调度参数
+    param.sched_priority = schedPriority;
+    ret = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    if (ret == 0) {
+        ret = pthread_attr_setschedpolicy(&attr, schedPolicy);
+    }
+    if (ret == 0) {
+        ret = pthread_attr_setschedparam(&attr, &param);
+    }
+    if (ret == 0) {
+        ret = pthread_create(&tid, &attr, threadFunc, this);
+    } else {
+        THREAD_LOG_ERROR("Error: Failed to set scheduling attributes for " << name << ": " << ret);
+    }
+    
+    pthread_attr_destroy(&attr);
+    return ret;
+}
+
+bool Thread::join() {
+    int ret;
+    
+    if (!running) {
+        THREAD_LOG_ERROR("Error: Thread " << name << " is not running");
+        return false;
+    }
+    
+    ret = pthread_join(tid, NULL);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_join failed for " << name << ": " << ret);
+        return false;
+    }
+    
+    running = false;
     return true;
 }
 
@@ -75,35 +157,35 @@ void WorkerThread::Sleep() {
     // 加锁
     ret = pthread_mutex_lock(&mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for " << name << ": " << ret);
         return;
     }
     
     sleeping = true;
-    std::cout << name << " is going to sleep..." << std::endl;
+    THREAD_LOG_INFO(name << " is going to sleep...");
     
     while (sleeping) {
         ret = pthread_cond_wait(&cond, &mutex);
         if (ret != 0) {
             if (ret == EINTR) {
                 // 被信号中断，继续等待
-                std::cout << name << " pthread_cond_wait interrupted by signal, continuing..." << std::endl;
+                THREAD_LOG_WARN(name << " pthread_cond_wait interrupted by signal, continuing...");
                 continue;
             } else {
                 // 其他错误，需要处理
-                std::cerr << "Error: pthread_cond_wait failed for " << name << ": " << ret << std::endl;
+                THREAD_LOG_ERROR("Error: pthread_cond_wait failed for " << name << ": " << ret);
                 sleeping = false;  // 设置为false，确保状态一致
                 break;
             }
         }
     }
     
-    std::cout << name << " is woken up!" << std::endl;
+    THREAD_LOG_INFO(name << " is woken up!");
     
     // 解锁
     ret = pthread_mutex_unlock(&mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for " << name << ": " << ret);
     }
 }
 
@@ -113,7 +195,7 @@ void WorkerThread::Wakeup() {
     // 加锁
     ret = pthread_mutex_lock(&mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for " << name << ": " << ret);
         return;
     }
     
@@ -121,26 +203,26 @@ void WorkerThread::Wakeup() {
         sleeping = false;
         ret = pthread_cond_signal(&cond);
         if (ret != 0) {
-            std::cerr << "Error: pthread_cond_signal failed for " << name << ": " << ret << std::endl;
+            THREAD_LOG_ERROR("Error: pthread_cond_signal failed for " << name << ": " << ret);
             // 即使信号发送失败，也将sleeping设置为false，确保状态一致
         } else {
-            std::cout << name << " is being woken up by main thread" << std::endl;
+            THREAD_LOG_INFO(name << " is being woken up by main thread");
         }
     }
     
     // 解锁
     ret = pthread_mutex_unlock(&mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for " << name << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for " << name << ": " << ret);
     }
 }
 
 void WorkerThread::run() {
-    std::cout << name << " started" << std::endl;
+    THREAD_LOG_INFO(name << " started");
     while (running) {
         Sleep();
     }
-    std::cout << name << " exited" << std::endl;
+    THREAD_LOG_INFO(name << " exited");
 }
 
 // MainThread实现
@@ -151,18 +233,18 @@ MainThread::~MainThread() {
 }
 
 void MainThread::run() {
-    std::cout << name << " started" << std::endl;
+    THREAD_LOG_INFO(name << " started");
     // 主线程的run方法可以留空，因为唤醒操作会通过外部调用WakeupWorker方法执行
     while (running) {
         sleep(1); // 防止主线程退出
     }
-    std::cout << name << " exited" << std::endl;
+    THREAD_LOG_INFO(name << " exited");
 }
 
 void MainThread::WakeupWorker(WorkerThread* worker) {
     if (worker) {
         worker->Wakeup();
     } else {
-        std::cerr << "Error: NULL worker thread pointer" << std::endl;
+        THREAD_LOG_ERROR("Error: NULL worker thread pointer");
     }
 }
\ No newline at end of file
@@ -12,6 +12,11 @@ public:
     virtual ~Thread();
     
     bool start();
+    bool join();
+    
+    // 设置线程创建时使用的调度策略和优先级（在start()之前调用）
+    // SCHED_FIFO/SCHED_RR需要相应权限，权限不足时start()记录警告并以默认调度参数创建线程
+    bool setScheduling(int policy, int priority);
     virtual void run() = 0;
     
 protected:
@@ -20,9 +25,14 @@ protected:
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     bool running;
+    int schedPolicy;
+    int schedPriority;
     
 private:
     static void* threadFunc(void* arg);
+    
+    // 按schedPolicy/schedPriority创建线程，返回pthread错误码
+    int createWithScheduling();
 };
 
 class WorkerThread : public Thread {
@@ -0,0 +1,249 @@
+#include "thread_log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <streambuf>
+#include <thread>
+
+namespace {
+
+// 每条日志的最大长度，超出部分被截断
+const size_t kLogLineSize = 240;
+
+// 每个线程环形缓冲区的条目数（2的幂）
+const uint64_t kRingCapacity = 256;
+
+// 后台输出线程空闲时的轮询间隔：有日志时1毫秒，连续空闲时逐步退避到50毫秒
+const int kMinPollMillis = 1;
+const int kMaxPollMillis = 50;
+
+// 把格式化输出直接写入固定大小的缓冲区，写满后丢弃后续字符
+class LineBuffer : public std::streambuf {
+public:
+    void reset(char* buffer, size_t size) {
+        setp(buffer, buffer + size);
+    }
+    
+    size_t length() const {
+        return static_cast<size_t>(pptr() - pbase());
+    }
+};
+
+} // namespace
+
+// 一条日志
+struct LogRecord {
+    uint64_t sequence;   // 全局提交序号
+    uint32_t level;      // 日志级别
+    uint32_t length;     // 文本长度（不含换行）
+    char text[kLogLineSize];
+};
+
+// 单生产者（所属线程）单消费者（输出方）的无锁环形缓冲区
+// head只由所属线程写入，tail只由输出方写入，两者分别按缓存行对齐，避免互相干扰
+struct LogRing {
+    alignas(64) std::atomic<uint64_t> head{0};    // 下一个写入位置
+    alignas(64) std::atomic<uint64_t> tail{0};    // 下一个读取位置
+    std::atomic<uint64_t> dropped{0};             // 因缓冲区满而丢弃的日志数
+    std::atomic<bool> orphaned{false};            // 所属线程已退出，输出完剩余日志后由输出方释放
+    LogRecord records[kRingCapacity];
+};
+
+namespace {
+
+// 线程局部的日志状态：环形缓冲区、格式化流，以及缓冲区满时使用的临时条目
+struct ThreadLogState {
+    LogRing* ring;
+    LogRecord* current;     // begin()正在写入的条目
+    bool overflow;          // 缓冲区已满，本条日志写入临时条目后丢弃
+    LineBuffer buffer;
+    std::ostream stream;
+    LogRecord scratch;
+    
+    ThreadLogState() : ring(NULL), current(NULL), overflow(false), stream(&buffer) {}
+    
+    ~ThreadLogState() {
+        // 线程退出：环形缓冲区交给输出方，输出完剩余日志后释放
+        if (ring != NULL) {
+            ring->orphaned.store(true, std::memory_order_release);
+            ring = NULL;
+        }
+    }
+};
+
+thread_local ThreadLogState logState;
+
+} // namespace
+
+// 获取单例实例
+// 使用函数内静态变量：其他单例的构造函数可能在静态初始化阶段记录日志，此时日志单例必须已经可用
+ThreadLogger* ThreadLogger::getInstance() {
+    static ThreadLogger* instance = new ThreadLogger();
+    return instance;
+}
+
+// 构造函数：启动后台输出线程，并在进程退出时输出剩余日志
+ThreadLogger::ThreadLogger() : minLevel(kLogInfo), nextSequence(0), stopped(false) {
+    std::thread(&ThreadLogger::drainLoop, this).detach();
+    std::atexit(&ThreadLogger::shutdownHook);
+}
+
+// 析构函数（单例不会被销毁）
+ThreadLogger::~ThreadLogger() {
+}
+
+// 设置运行期日志级别
+void ThreadLogger::setLevel(LogLevel level) {
+    minLevel.store(level, std::memory_order_relaxed);
+}
+
+// 获取运行期日志级别
+LogLevel ThreadLogger::getLevel() const {
+    return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed));
+}
+
+// 当前线程的环形缓冲区
+LogRing* ThreadLogger::currentRing() {
+    if (logState.ring == NULL) {
+        LogRing* ring = new LogRing();
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(ring);
+        logState.ring = ring;
+    }
+    return logState.ring;
+}
+
+// 开始一条日志
+std::ostream& ThreadLogger::begin(LogLevel level) {
+    LogRing* ring = currentRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    
+    // 缓冲区已满（输出方跟不上）：写入临时条目，提交时丢弃
+    logState.overflow = head - ring->tail.load(std::memory_order_acquire) >= kRingCapacity;
+    logState.current = logState.overflow ? &logState.scratch : &ring->records[head & (kRingCapacity - 1)];
+    logState.current->level = level;
+    
+    logState.buffer.reset(logState.current->text, kLogLineSize);
+    logState.stream.clear();
+    return logState.stream;
+}
+
+// 提交一条日志
+void ThreadLogger::commit() {
+    LogRing* ring = logState.ring;
+    if (logState.overflow) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    LogRecord* record = logState.current;
+    record->length = static_cast<uint32_t>(logState.buffer.length());
+    record->sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+    
+    // 发布条目：输出方acquire读取head后能看到完整的条目内容
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    
+    // 后台输出已停止（进程正在退出），同步输出
+    if (stopped.load(std::memory_order_relaxed)) {
+        drainOnce();
+    }
+}
+
+// 输出所有已提交的日志
+size_t ThreadLogger::drainOnce() {
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+    
+    // 复制环形缓冲区列表，输出期间不阻塞新线程登记
+    std::vector<LogRing*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        snapshot = rings;
+    }
+    
+    // 收集各缓冲区中已提交的条目，按全局序号合并
+    std::vector<LogRecord*> batch;
+    std::vector<uint64_t> heads(snapshot.size());
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        LogRing* ring = snapshot[i];
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        heads[i] = ring->head.load(std::memory_order_acquire);
+        for (uint64_t pos = tail; pos != heads[i]; ++pos) {
+            batch.push_back(&ring->records[pos & (kRingCapacity - 1)]);
+        }
+    }
+    std::sort(batch.begin(), batch.end(), [](const LogRecord* a, const LogRecord* b) {
+        return a->sequence < b->sequence;
+    });
+    
+    for (size_t i = 0; i < batch.size(); ++i) {
+        FILE* out = batch[i]->level >= kLogWarn ? stderr : stdout;
+        fwrite(batch[i]->text, 1, batch[i]->length, out);
+        fputc('\n', out);
+    }
+    
+    // 归还已输出的条目，并报告丢弃的日志数
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        snapshot[i]->tail.store(heads[i], std::memory_order_release);
+        uint64_t dropped = snapshot[i]->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            fprintf(stderr, "Warning: %llu log messages dropped (log buffer full)\n",
+                    static_cast<unsigned long long>(dropped));
+        }
+    }
+    fflush(stdout);
+    fflush(stderr);
+    
+    // 释放所属线程已退出且已输出完的环形缓冲区
+    // 先确认orphaned再读取head：线程退出后不会再提交日志，此时为空就永远为空
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (size_t i = 0; i < rings.size();) {
+            LogRing* ring = rings[i];
+            if (ring->orphaned.load(std::memory_order_acquire) &&
+                ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed)) {
+                rings[i] = rings.back();
+                rings.pop_back();
+                delete ring;
+            } else {
+                ++i;
+            }
+        }
+    }
+    
+    return batch.size();
+}
+
+// 同步输出此前已提交的全部日志
+void ThreadLogger::flush() {
+    drainOnce();
+}
+
+// 后台输出线程：有日志时快速轮询，空闲时逐步退避
+void ThreadLogger::drainLoop() {
+    int pollMillis = kMinPollMillis;
+    while (!stopped.load(std::memory_order_acquire)) {
+        if (drainOnce() > 0) {
+            pollMillis = kMinPollMillis;
+        } else if (pollMillis < kMaxPollMillis) {
+            pollMillis = std::min(pollMillis * 2, kMaxPollMillis);
+        }
+        
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCond.wait_for(lock, std::chrono::milliseconds(pollMillis), [this]() {
+            return stopped.load(std::memory_order_acquire);
+        });
+    }
+}
+
+// 进程退出：停止后台输出线程并同步输出剩余日志，之后提交的日志也同步输出
+// 后台线程已分离，不在这里join（在动态库卸载等场景下join可能死锁），由drainMutex保证不会重复输出
+void ThreadLogger::shutdownHook() {
+    ThreadLogger* logger = getInstance();
+    {
+        std::lock_guard<std::mutex> lock(logger->wakeMutex);
+        logger->stopped.store(true, std::memory_order_release);
+    }
+    logger->wakeCond.notify_all();
+    logger->drainOnce();
+}
@@ -0,0 +1,107 @@
+#ifndef THREAD_LOG_H
+#define THREAD_LOG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <ostream>
+
+// 日志级别
+enum LogLevel {
+    kLogDebug = 0,
+    kLogInfo = 1,
+    kLogWarn = 2,
+    kLogError = 3,
+    kLogOff = 4
+};
+
+// 编译期开关：
+//   THREAD_LOG_DISABLE    所有日志调用被完全移除，参数也不会求值（发布版本使用）
+//   THREAD_LOG_MIN_LEVEL  低于该级别的日志调用在编译期移除（默认保留全部级别）
+#ifndef THREAD_LOG_MIN_LEVEL
+#define THREAD_LOG_MIN_LEVEL kLogDebug
+#endif
+
+struct LogRing;
+
+// 异步日志：每个线程把格式化好的日志写入自己的无锁环形缓冲区，由后台输出线程统一写到stdout/stderr
+// 记录日志的线程不加任何锁，也不做任何I/O；缓冲区满时丢弃新日志并计数，不会阻塞调用者
+// Info及以下级别输出到stdout，Warn及以上级别输出到stderr，多个线程的日志按提交顺序输出
+class ThreadLogger {
+public:
+    static ThreadLogger* getInstance();
+    
+    // 运行期级别过滤（默认kLogInfo）
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const;
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+    }
+    
+    // 开始一条日志：返回当前线程的格式化流，直接写入环形缓冲区中的下一个条目，不分配内存
+    std::ostream& begin(LogLevel level);
+    
+    // 提交begin()开始的日志
+    void commit();
+    
+    // 同步输出此前已提交的全部日志（进程退出时自动调用）
+    void flush();
+    
+private:
+    ThreadLogger();
+    ~ThreadLogger();
+    ThreadLogger(const ThreadLogger&) = delete;
+    ThreadLogger& operator=(const ThreadLogger&) = delete;
+    
+    // 当前线程的环形缓冲区（首次记录日志时创建并登记）
+    LogRing* currentRing();
+    
+    // 输出所有环形缓冲区中已提交的日志，返回输出的条数
+    size_t drainOnce();
+    
+    // 后台输出线程
+    void drainLoop();
+    
+    // 进程退出时停止后台输出，并输出剩余日志
+    static void shutdownHook();
+    
+    std::atomic<int> minLevel;
+    std::atomic<uint64_t> nextSequence;   // 全局提交序号，输出时按序号合并各线程的日志
+    std::atomic<bool> stopped;            // 后台输出已停止，之后提交的日志同步输出
+    
+    // 已登记的环形缓冲区（只在线程首次记录日志和输出时加锁）
+    std::mutex ringsMutex;
+    std::vector<LogRing*> rings;
+    
+    // 串行化输出（后台线程和flush()）
+    std::mutex drainMutex;
+    
+    // 唤醒后台输出线程（只在停止时使用，平时按间隔轮询，记录日志的一方不需要通知）
+    std::mutex wakeMutex;
+    std::condition_variable wakeCond;
+};
+
+// THREAD_LOG_ENABLED(level)：该级别的日志是否会输出，用于在记录日志前准备开销较大的参数
+#ifdef THREAD_LOG_DISABLE
+#define THREAD_LOG_ENABLED(level) false
+#define THREAD_LOG(level, expr) do {} while (0)
+#else
+#define THREAD_LOG_ENABLED(level) ((level) >= THREAD_LOG_MIN_LEVEL && ThreadLogger::getInstance()->enabled(level))
+#define THREAD_LOG(level, expr) \
+    do { \
+        if (THREAD_LOG_ENABLED(level)) { \
+            ThreadLogger::getInstance()->begin(level) << expr; \
+            ThreadLogger::getInstance()->commit(); \
+        } \
+    } while (0)
+#endif
+
+#define THREAD_LOG_DEBUG(expr) THREAD_LOG(kLogDebug, expr)
+#define THREAD_LOG_INFO(expr) THREAD_LOG(kLogInfo, expr)
+#define THREAD_LOG_WARN(expr) THREAD_LOG(kLogWarn, expr)
+#define THREAD_LOG_ERROR(expr) THREAD_LOG(kLogError, expr)
+
+#endif // THREAD_LOG_H
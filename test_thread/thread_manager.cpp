@@ -1,23 +1,328 @@
 #define DLL_EXPORTS
 #include "thread_manager.h"
+#include "thread_log.h"
 #include <mutex>
-#include <condition_variable>
+#include <shared_mutex>
 #include <thread>
 #include <iostream>
 #include <memory>
 #include <atomic>
+#include <algorithm>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#include <condition_variable>
+#endif
+
+namespace {
+
+// 状态字布局：高22位为槽位代数，中间8位为未消费的许可数，低2位为线程状态
+// 代数、许可和状态在同一个字中，唤醒方的一次CAS即可同时校验句柄是否过期并决定如何投递
+//
+// 状态转换（G为当前代数，P为许可数）：
+//   G|P|RUNNING    -> G|P-1|RUNNING  Sleep()消费一个许可后立即返回（只由本线程执行）
+//   G|0|RUNNING    -> G|0|PARKING    Sleep()宣告即将睡眠（只由本线程执行）
+//   G|0|PARKING    -> G|0|PARKED     Sleep()确认没有通知后准备阻塞（只由本线程执行）
+//   G|0|PARKING    -> G|0|NOTIFIED   Wakeup()在目标阻塞之前投递通知，不需要系统调用
+//   G|0|PARKED     -> G|0|NOTIFIED   Wakeup()投递通知，并执行一次FUTEX_WAKE
+//   G|0|PARKING/PARKED -> G|0|RUNNING 限时睡眠到达截止时间（只由本线程执行，与投递通知的CAS竞争）
+//   G|P|NOTIFIED   -> G|P|RUNNING    Sleep()消费通知后返回（只由本线程执行）
+//   G|P|RUNNING    -> G|P+1|RUNNING  启用许可时，Wakeup()把提前到达的唤醒保存为许可
+//   G|P|NOTIFIED   -> G|P+1|NOTIFIED 启用计数许可时，Wakeup()继续累积许可
+//   G|*|*          -> G'|0|RUNNING   注销：代数递增，目标处于PARKED时执行一次FUTEX_WAKE
+// 未消费的唤醒总数（许可数，加上NOTIFIED算作一个）不超过许可上限，超出的Wakeup()被合并；
+// 未启用许可（上限为0）时，RUNNING或NOTIFIED状态下的Wakeup()不做任何事
+//
+// 自旋：启用自旋策略时，Sleep()在PARKING状态下先自旋（pause退避、再yield），期间只读取状态字；
+// 自旋期间到达的Wakeup()走PARKING -> NOTIFIED，不需要FUTEX_WAKE，睡眠方也不进入FUTEX_WAIT
+//
+// 内存序：
+//   - 宣告PARKING和投递通知/许可都使用seq_cst的CAS，保证“先发布数据再唤醒”的一方与
+//     “先宣告睡眠再检查条件”的一方之间不会互相错过（Dekker式的存储-加载顺序）
+//   - Sleep()在观察到NOTIFIED、消费许可或代数改变时使用acquire读取，唤醒方在Wakeup()之前写入的数据
+//     在Sleep()返回后都可见
+//   - futexWait()只在状态字仍等于PARKED时阻塞，内核在比较和入队之间持有futex桶锁，
+//     因此PARKING -> PARKED和PARKED -> NOTIFIED之间不存在丢失唤醒的窗口
+//   - 代数只有22位，同一槽位被重复注册约400万次后才会回绕；持有如此之久的过期句柄才可能被误认
+const uint32_t kStateMask = 0x3u;
+const uint32_t kPermitShift = 2;
+const uint32_t kPermitMask = 0xFFu;
+const uint32_t kPermitUnit = 1u << kPermitShift;
+const uint32_t kGenerationShift = 10;
+const uint32_t kGenerationMask = 0x3FFFFFu;
+
+// 许可上限的最大值（受许可位宽限制）
+const uint32_t kMaxPermitLimit = kPermitMask;
+
+// 邮箱容量的最大值
+const uint32_t kMaxMailboxCapacity = 1u << 16;
+
+const uint32_t kRunning = 0;    // 运行中，未睡眠
+const uint32_t kParking = 1;    // 已宣告睡眠，尚未阻塞
+const uint32_t kParked = 2;     // 已在futex上阻塞
+const uint32_t kNotified = 3;   // 已收到通知，尚未被本线程消费
+
+// 无效槽位下标
+const uint32_t kInvalidSlot = 0xFFFFFFFFu;
+
+inline uint32_t generationOf(uint32_t word) {
+    return word >> kGenerationShift;
+}
+
+inline uint32_t permitsOf(uint32_t word) {
+    return (word >> kPermitShift) & kPermitMask;
+}
+
+inline uint32_t stateOf(uint32_t word) {
+    return word & kStateMask;
+}
+
+// 构造许可数为0的状态字
+inline uint32_t makeWord(uint32_t generation, uint32_t state) {
+    return (generation << kGenerationShift) | state;
+}
+
+// 只替换状态，保留代数和许可数
+inline uint32_t withState(uint32_t word, uint32_t state) {
+    return (word & ~kStateMask) | state;
+}
+
+// 下一个代数，跳过0（0表示无效句柄）
+inline uint32_t nextGeneration(uint32_t generation) {
+    uint32_t next = (generation + 1) & kGenerationMask;
+    return next == 0 ? 1 : next;
+}
+
+// 当前线程的注册句柄缓存
+thread_local ParkHandle currentThreadHandle;
+
+// 当前线程的线程名（与注册句柄缓存一起设置），睡眠日志只使用这份副本，不读取可能被复用的槽位
+thread_local std::string currentThreadName;
+
+// 唤醒延迟对应的直方图桶：floor(log2(nanos))，超出范围的归入最后一个桶
+inline size_t latencyBucket(uint64_t nanos) {
+    size_t bucket = 0;
+    while (nanos > 1 && bucket + 1 < ThreadStats::kWakeLatencyBuckets) {
+        nanos >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// 统计计数器只由本线程写入时的递增：普通的读-写即可，不需要原子读-改-写
+inline void bumpOwned(std::atomic<uint64_t>& counter, uint64_t delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// seqlock写端：序号变为奇数后再写字段，写完后序号变为偶数
+inline void beginStatsWrite(ThreadStatsCounters& stats) {
+    stats.sequence.store(stats.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void endStatsWrite(ThreadStatsCounters& stats) {
+    stats.sequence.store(stats.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// 注册时清零统计（槽位可能被复用）
+void resetStats(ThreadStatsCounters& stats) {
+    beginStatsWrite(stats);
+    stats.sleeps.store(0, std::memory_order_relaxed);
+    stats.parks.store(0, std::memory_order_relaxed);
+    stats.spinWakeups.store(0, std::memory_order_relaxed);
+    stats.parkedNanos.store(0, std::memory_order_relaxed);
+    stats.timeouts.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < ThreadStats::kWakeLatencyBuckets; ++i) {
+        stats.wakeLatency[i].store(0, std::memory_order_relaxed);
+    }
+    endStatsWrite(stats);
+    stats.wakeupsReceived.store(0, std::memory_order_relaxed);
+    stats.redundantWakeups.store(0, std::memory_order_relaxed);
+}
+
+#ifdef __linux__
+// Linux：直接在状态字上进行futex等待/唤醒，不需要任何互斥锁
+// 状态字的值不等于expected时立即返回；被信号中断（EINTR）、虚假唤醒或超时时由调用者重新检查
+// 截止时间是CLOCK_MONOTONIC上的绝对时间（FUTEX_WAIT_BITSET），重试时不会累积误差
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, uint64_t deadlineNanos) {
+    if (deadlineNanos == UINT64_MAX) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+        return;
+    }
+    struct timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadlineNanos / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadlineNanos % 1000000000ULL);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_BITSET_PRIVATE, expected, &deadline, NULL,
+            FUTEX_BITSET_MATCH_ANY);
+}
+
+void futexWake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+#else
+// 其他平台：按状态字地址散列到固定数量的互斥锁/条件变量上模拟futex
+// 唤醒方先修改状态字再进入桶锁，等待方在桶锁内检查状态字，因此不会丢失唤醒
+struct ParkBucket {
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+const size_t kParkBucketCount = 64;
+ParkBucket parkBuckets[kParkBucketCount];
+
+ParkBucket& parkBucketFor(const void* addr) {
+    return parkBuckets[(reinterpret_cast<uintptr_t>(addr) >> 4) % kParkBucketCount];
+}
+
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, uint64_t deadlineNanos) {
+    ParkBucket& bucket = parkBucketFor(word);
+    std::unique_lock<std::mutex> lock(bucket.mutex);
+    if (word->load(std::memory_order_acquire) == expected) {
+        if (deadlineNanos == UINT64_MAX) {
+            bucket.cond.wait(lock);
+        } else {
+            bucket.cond.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadlineNanos)));
+        }
+    }
+}
+
+void futexWake(std::atomic<uint32_t>* word) {
+    ParkBucket& bucket = parkBucketFor(word);
+    {
+        std::lock_guard<std::mutex> lock(bucket.mutex);
+    }
+    // 同一个桶可能有多个线程在等待，需要全部通知，由各自重新检查状态字
+    bucket.cond.notify_all();
+}
+#endif
+
+// 将散列值再次打散后取分片下标（shardCount为2的幂）
+// std::thread::id的散列值通常是对齐的地址，低位几乎恒定，直接取模会让分片严重不均
+size_t shardIndex(size_t hash, size_t shardCount) {
+    uint64_t h = hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h) & (shardCount - 1);
+}
+
+} // namespace
+
+// 邮箱单元：序号 + 投递方看到的槽位代数 + 消息
+struct MailboxCell {
+    std::atomic<uint64_t> sequence;
+    uint32_t generation;
+    ThreadMessage message;
+};
+
+// 有界无锁多生产者单消费者邮箱（Dmitry Vyukov的有界队列）
+// 每个单元的序号说明它当前可写（sequence == pos）还是可读（sequence == pos + 1）：
+// 投递方CAS推进enqueuePos占得单元后写入消息，再以release发布序号；只有所属线程出队，dequeuePos不需要CAS
+// 消息带有投递时的槽位代数：与注销并发的投递可能落在槽位复用后的邮箱里，所属线程出队时丢弃代数不符的消息
+struct ThreadMailbox {
+    const uint64_t mask;
+    alignas(64) std::atomic<uint64_t> enqueuePos;
+    alignas(64) std::atomic<uint64_t> dequeuePos;
+    MailboxCell* cells;
+    
+    explicit ThreadMailbox(uint32_t capacity) : mask(capacity - 1), enqueuePos(0), dequeuePos(0),
+                                                cells(new MailboxCell[capacity]) {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    ~ThreadMailbox() {
+        delete[] cells;
+    }
+    
+    uint64_t capacity() const {
+        return mask + 1;
+    }
+    
+    // 入队（任意线程），邮箱已满时返回false
+    bool push(const ThreadMessage& message, uint32_t generation) {
+        uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+        MailboxCell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(sequence - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->generation = generation;
+        cell->message = message;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // 出队（只由所属线程调用），邮箱为空时返回false
+    bool pop(ThreadMessage& message, uint32_t& generation) {
+        uint64_t pos = dequeuePos.load(std::memory_order_relaxed);
+        MailboxCell* cell = &cells[pos & mask];
+        if (cell->sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        generation = cell->generation;
+        message = cell->message;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // 是否有已发布的消息（只由所属线程调用）
+    bool hasMessages() const {
+        uint64_t pos = dequeuePos.load(std::memory_order_relaxed);
+        return cells[pos & mask].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+};
 
 // 静态实例初始化
 ThreadManager* ThreadManager::instance = new ThreadManager();
 
 // 构造函数
-ThreadManager::ThreadManager() {
-    // std::mutex会自动初始化，不需要手动操作
+ThreadManager::ThreadManager() : spinMode(SpinPolicy::kNoSpin), spinNanos(0), spinYieldCount(0), slotCount(0) {
+    // 分片的std::shared_mutex会自动初始化，不需要手动操作
+    for (uint32_t i = 0; i < kMaxSlotChunks; ++i) {
+        slotChunks[i].store(NULL, std::memory_order_relaxed);
+    }
+    
+    // 预先分配第一个槽位块，常见规模的注册不需要再分配槽位内存
+    slotChunks[0].store(createSlotChunk(), std::memory_order_relaxed);
+    freeSlots.reserve(kSlotChunkSize);
 }
 
 // 析构函数
 ThreadManager::~ThreadManager() {
-    // std::mutex和std::condition_variable会自动销毁，不需要手动清理
+    // 释放所有槽位块和邮箱
+    for (uint32_t i = 0; i < kMaxSlotChunks; ++i) {
+        ThreadInfo* chunk = slotChunks[i].load(std::memory_order_relaxed);
+        if (chunk == NULL) {
+            continue;
+        }
+        for (uint32_t k = 0; k < kSlotChunkSize; ++k) {
+            delete chunk[k].mailboxStorage;
+        }
+        delete[] chunk;
+    }
+    for (size_t i = 0; i < retiredMailboxes.size(); ++i) {
+        delete retiredMailboxes[i];
+    }
 }
 
 // 获取单例实例
@@ -25,151 +330,1077 @@ ThreadManager* ThreadManager::getInstance() {
     return instance;
 }
 
+// 设置自旋策略
+void ThreadManager::setSpinPolicy(const SpinPolicy& policy) {
+    spinNanos.store(policy.spinNanos, std::memory_order_relaxed);
+    spinYieldCount.store(policy.yieldCount, std::memory_order_relaxed);
+    spinMode.store(policy.mode, std::memory_order_relaxed);
+}
+
+// 获取自旋策略
+SpinPolicy ThreadManager::getSpinPolicy() const {
+    return SpinPolicy(static_cast<SpinPolicy::Mode>(spinMode.load(std::memory_order_relaxed)),
+                      spinNanos.load(std::memory_order_relaxed),
+                      spinYieldCount.load(std::memory_order_relaxed));
+}
+
+// 根据线程ID选择注册表分片
+ThreadManager::IdShard& ThreadManager::idShardFor(std::thread::id threadId) {
+    return idShards[shardIndex(std::hash<std::thread::id>()(threadId), kRegistryShardCount)];
+}
+
+// 根据线程名选择注册表分片
+ThreadManager::NameShard& ThreadManager::nameShardFor(const std::string& threadName) {
+    return nameShards[shardIndex(std::hash<std::string>()(threadName), kRegistryShardCount)];
+}
+
+// 根据组名选择组注册表分片
+ThreadManager::GroupShard& ThreadManager::groupShardFor(const std::string& group) {
+    return groupShards[shardIndex(std::hash<std::string>()(group), kRegistryShardCount)];
+}
+
+// 按线程ID查找注册句柄
+ParkHandle ThreadManager::findHandle(std::thread::id threadId) {
+    IdShard& shard = idShardFor(threadId);
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    auto it = shard.threads.find(threadId);
+    return it == shard.threads.end() ? ParkHandle() : it->second;
+}
+
+// 按线程名查找注册句柄
+ParkHandle ThreadManager::findHandle(const std::string& threadName) {
+    NameShard& shard = nameShardFor(threadName);
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    auto it = shard.threads.find(threadName);
+    return it == shard.threads.end() ? ParkHandle() : it->second;
+}
+
+// 按下标访问槽位
+ThreadInfo* ThreadManager::slotAt(uint32_t index) {
+    if (index >= kMaxSlotChunks * kSlotChunkSize) {
+        return NULL;
+    }
+    ThreadInfo* chunk = slotChunks[index / kSlotChunkSize].load(std::memory_order_acquire);
+    return chunk == NULL ? NULL : &chunk[index % kSlotChunkSize];
+}
+
+// 创建槽位块（按缓存行对齐）
+ThreadInfo* ThreadManager::createSlotChunk() {
+    ThreadInfo* chunk = new ThreadInfo[kSlotChunkSize];
+    for (uint32_t i = 0; i < kSlotChunkSize; ++i) {
+        chunk[i].state.store(makeWord(1, kRunning), std::memory_order_relaxed);
+    }
+    return chunk;
+}
+
+// 分配槽位：优先复用已注销的槽位，否则顺序分配，必要时分配新的槽位块
+uint32_t ThreadManager::allocateSlot() {
+    std::lock_guard<std::mutex> lock(slotMutex);
+    
+    if (!freeSlots.empty()) {
+        uint32_t index = freeSlots.back();
+        freeSlots.pop_back();
+        return index;
+    }
+    
+    if (slotCount == kMaxSlotChunks * kSlotChunkSize) {
+        return kInvalidSlot;
+    }
+    
+    if (slotChunks[slotCount / kSlotChunkSize].load(std::memory_order_relaxed) == NULL) {
+        // 发布块指针，之后无锁读取的一方能看到初始化完成的槽位
+        slotChunks[slotCount / kSlotChunkSize].store(createSlotChunk(), std::memory_order_release);
+    }
+    
+    return slotCount++;
+}
+
+// 归还槽位（槽位代数已在注销时递增）
+void ThreadManager::releaseSlot(uint32_t index) {
+    std::lock_guard<std::mutex> lock(slotMutex);
+    freeSlots.push_back(index);
+}
+
+// 当前线程的注册句柄
+ParkHandle ThreadManager::currentHandle() {
+    ParkHandle handle = currentThreadHandle;
+    if (handle.valid()) {
+        ThreadInfo* info = slotAt(handle.index);
+        if (info != NULL && generationOf(info->state.load(std::memory_order_acquire)) == handle.generation) {
+            return handle;
+        }
+    }
+    
+    // 缓存为空或已失效（例如由其他线程代为注册），查找注册表并刷新缓存
+    // 注销时先移除线程ID条目再归还槽位，持有分片读锁期间槽位中的线程名不会被改写
+    IdShard& shard = idShardFor(std::this_thread::get_id());
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    auto it = shard.threads.find(std::this_thread::get_id());
+    handle = it == shard.threads.end() ? ParkHandle() : it->second;
+    currentThreadHandle = handle;
+    currentThreadName = handle.valid() ? slotAt(handle.index)->name : std::string();
+    return handle;
+}
+
+// 投递一次唤醒：调用者无需持有任何锁
+ThreadManager::DeliverResult ThreadManager::deliverWakeup(ThreadInfo& info, uint32_t generation) {
+    const uint32_t limit = info.permitLimit.load(std::memory_order_relaxed);
+    uint32_t word = info.state.load(std::memory_order_relaxed);
+    for (;;) {
+        // 句柄已过期（代数不同），不会误唤醒复用该槽位的其他线程
+        if (generationOf(word) != generation) {
+            return kNotDelivered;
+        }
+        
+        uint32_t state = stateOf(word);
+        uint32_t next;
+        if (state == kParking || state == kParked) {
+            // PARKING/PARKED -> NOTIFIED；只有目标已经阻塞时才需要系统调用
+            // 投递前记录时间戳，目标在acquire读到NOTIFIED后据此计算唤醒延迟
+            next = withState(word, kNotified);
+            info.stats.notifyNanos.store(spinClockNanos(), std::memory_order_relaxed);
+        } else {
+            // RUNNING/NOTIFIED：启用许可时保存为许可，未消费的唤醒总数达到上限（或未启用许可）时合并
+            uint32_t pending = permitsOf(word) + (state == kNotified ? 1 : 0);
+            if (pending >= limit) {
+                info.stats.redundantWakeups.fetch_add(1, std::memory_order_relaxed);
+                return kNotDelivered;
+            }
+            next = word + kPermitUnit;
+        }
+        
+        if (info.state.compare_exchange_weak(word, next, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            info.stats.wakeupsReceived.fetch_add(1, std::memory_order_relaxed);
+            if (state == kParked) {
+                return kDeliveredParked;
+            }
+            return state == kParking ? kDelivered : kDeliveredPermit;
+        }
+    }
+}
+
+// 写入线程的eventfd唤醒通道
+// eventfd随槽位创建后不再关闭，即使与注销并发也不会写到被复用的描述符上；写入过期的通道最多造成一次虚假唤醒
+bool ThreadManager::writeWakeFd(ThreadInfo& info) {
+#ifdef __linux__
+    if (!info.wakeFdEnabled.load(std::memory_order_acquire)) {
+        return true;
+    }
+    uint64_t one = 1;
+    ssize_t ret;
+    do {
+        ret = write(info.wakeFd.load(std::memory_order_relaxed), &one, sizeof(one));
+    } while (ret < 0 && errno == EINTR);
+    // EAGAIN表示计数已接近上限，描述符必然可读，忽略即可
+    return ret >= 0 || errno == EAGAIN;
+#else
+    (void)info;
+    return true;
+#endif
+}
+
+// 写入线程的eventfd唤醒通道，失败时记录日志
+void ThreadManager::signalWakeFd(ThreadInfo& info) {
+    if (!writeWakeFd(info)) {
+        THREAD_LOG_ERROR("Error: write to wake eventfd failed: " << errno);
+    }
+}
+
+// 唤醒指定代数的线程：调用者无需持有任何锁
+bool ThreadManager::wakeThreadInfo(ThreadInfo& info, uint32_t generation) {
+    DeliverResult result = deliverWakeup(info, generation);
+    if (result == kDeliveredParked) {
+        futexWake(&info.state);
+    } else if (result == kDeliveredPermit) {
+        signalWakeFd(info);
+    }
+    return result != kNotDelivered;
+}
+
+// 批量唤醒已解析的句柄
+// 先对所有目标完成CAS（正在PARKING自旋的目标此时就能看到通知），再逐个对已阻塞的目标执行FUTEX_WAKE，
+// 系统调用不会推迟其他目标收到通知
+size_t ThreadManager::wakeHandles(const std::vector<ParkHandle>& handles) {
+    std::vector<ThreadInfo*> parked;
+    std::vector<ThreadInfo*> permitted;
+    size_t delivered = 0;
+    
+    for (size_t i = 0; i < handles.size(); ++i) {
+        ThreadInfo* info = handles[i].valid() ? slotAt(handles[i].index) : NULL;
+        if (info == NULL) {
+            continue;
+        }
+        DeliverResult result = deliverWakeup(*info, handles[i].generation);
+        if (result != kNotDelivered) {
+            ++delivered;
+        }
+        if (result == kDeliveredParked) {
+            parked.push_back(info);
+        } else if (result == kDeliveredPermit) {
+            permitted.push_back(info);
+        }
+    }
+    
+    for (size_t i = 0; i < parked.size(); ++i) {
+        futexWake(&parked[i]->state);
+    }
+    for (size_t i = 0; i < permitted.size(); ++i) {
+        signalWakeFd(*permitted[i]);
+    }
+    return delivered;
+}
+
+// 注册线程（默认选项）
+ParkHandle ThreadManager::registerThread(const std::string& threadName, std::thread::id threadId) {
+    return registerThread(threadName, threadId, RegisterOptions());
+}
+
 // 注册线程
-void ThreadManager::registerThread(const std::string& threadName, std::thread::id threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+ParkHandle ThreadManager::registerThread(const std::string& threadName, std::thread::id threadId,
+                                         const RegisterOptions& options) {
+    NameShard& nameShard = nameShardFor(threadName);
+    IdShard& idShard = idShardFor(threadId);
+    
+    // 固定按“线程名分片 -> 线程ID分片”的顺序加写锁，保证重复检查和插入是原子的
+    // 注册是唯一同时持有两个分片锁的地方，因此不会死锁
+    std::unique_lock<std::shared_mutex> nameLock(nameShard.lock);
+    std::unique_lock<std::shared_mutex> idLock(idShard.lock);
     
     // 检查线程是否已存在（通过线程ID）
-    if (threadMap.find(threadId) != threadMap.end()) {
-        std::cerr << "Error: Thread already registered" << std::endl;
-        return;
+    if (idShard.threads.find(threadId) != idShard.threads.end()) {
+        THREAD_LOG_ERROR("Error: Thread already registered");
+        return ParkHandle();
     }
     
-    // 检查线程名是否已存在
-    if (threadNameToId.find(threadName) != threadNameToId.end()) {
-        std::cerr << "Error: Thread name already exists: " << threadName << std::endl;
-        return;
+    // 不加入注册表的线程之后无法按线程ID找回句柄，只能由线程自己注册（句柄缓存在本线程内）
+    if (options.unlisted && threadId != std::this_thread::get_id()) {
+        THREAD_LOG_ERROR("Error: Unlisted threads can only register themselves: " << threadName);
+        return ParkHandle();
+    }
+    
+    // 检查线程名是否已存在（不加入注册表的线程不占用线程名）
+    if (!options.unlisted && nameShard.threads.find(threadName) != nameShard.threads.end()) {
+        THREAD_LOG_ERROR("Error: Thread name already exists: " << threadName);
+        return ParkHandle();
+    }
+    
+    // 绑定CPU：只能绑定调用线程自己（之后注册失败时绑定仍然保留）
+    if (!options.cpuAffinity.empty()) {
+#ifdef __linux__
+        if (threadId != std::this_thread::get_id()) {
+            THREAD_LOG_ERROR("Error: CPU affinity can only be set when a thread registers itself: " << threadName);
+            return ParkHandle();
+        }
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (size_t i = 0; i < options.cpuAffinity.size(); ++i) {
+            int cpu = options.cpuAffinity[i];
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_setaffinity_np failed for thread " << threadName << ": " << ret);
+            return ParkHandle();
+        }
+#else
+        THREAD_LOG_WARN("Warning: CPU affinity is only supported on Linux, ignored for thread " << threadName);
+#endif
+    }
+    
+    // 分配槽位并初始化线程信息
+    uint32_t index = allocateSlot();
+    if (index == kInvalidSlot) {
+        THREAD_LOG_ERROR("Error: Too many registered threads: " << threadName);
+        return ParkHandle();
     }
     
-    // 创建并初始化线程信息结构体
-    ThreadInfo info;
-    info.name = threadName;
-    info.mutex = std::make_shared<std::mutex>();
-    info.cond = std::make_shared<std::condition_variable>();
+    ThreadInfo* info = slotAt(index);
     
-    // 添加到映射表
-    threadMap.emplace(threadId, info);
-    threadNameToId[threadName] = threadId;
+    // eventfd唤醒通道：槽位第一次启用时创建，之后随槽位复用；清空上一次注册残留的计数
+    uint32_t permitLimit = options.permitLimit < kMaxPermitLimit ? options.permitLimit : kMaxPermitLimit;
+    bool wakeFdEnabled = false;
+    if (options.wakeFd) {
+#ifdef __linux__
+        int fd = info->wakeFd.load(std::memory_order_relaxed);
+        if (fd < 0) {
+            fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (fd < 0) {
+                THREAD_LOG_ERROR("Error: eventfd failed for thread " << threadName << ": " << errno);
+                releaseSlot(index);
+                return ParkHandle();
+            }
+            info->wakeFd.store(fd, std::memory_order_relaxed);
+        } else {
+            uint64_t stale;
+            while (read(fd, &stale, sizeof(stale)) < 0 && errno == EINTR) {
+            }
+        }
+        wakeFdEnabled = true;
+        if (permitLimit == 0) {
+            permitLimit = 1;
+        }
+#else
+        THREAD_LOG_WARN("Warning: wake eventfd is only supported on Linux, ignored for thread " << threadName);
+#endif
+    }
+    
+    // 邮箱：槽位已有的邮箱容量足够时直接复用（残留的消息代数不符，出队时被丢弃），否则换成新邮箱
+    ThreadMailbox* mailbox = NULL;
+    if (options.mailboxCapacity > 0) {
+        uint32_t capacity = 1;
+        while (capacity < options.mailboxCapacity && capacity < kMaxMailboxCapacity) {
+            capacity <<= 1;
+        }
+        if (info->mailboxStorage == NULL || info->mailboxStorage->capacity() < capacity) {
+            if (info->mailboxStorage != NULL) {
+                std::lock_guard<std::mutex> lock(slotMutex);
+                retiredMailboxes.push_back(info->mailboxStorage);
+            }
+            info->mailboxStorage = new ThreadMailbox(capacity);
+        }
+        mailbox = info->mailboxStorage;
+    }
+    
+    info->name = threadName;
+    info->threadId = threadId;
+    info->permitLimit.store(permitLimit, std::memory_order_relaxed);
+    info->lastCpu.store(threadId == std::this_thread::get_id() ? CpuTopology::currentCpu() : -1,
+                        std::memory_order_relaxed);
+    info->mailbox.store(mailbox, std::memory_order_release);
+    info->wakeFdEnabled.store(wakeFdEnabled, std::memory_order_release);
+    resetStats(info->stats);
+    info->spinState.reset();
+    info->groups.clear();
+    for (size_t i = 0; i < options.groups.size(); ++i) {
+        if (std::find(info->groups.begin(), info->groups.end(), options.groups[i]) == info->groups.end()) {
+            info->groups.push_back(options.groups[i]);
+        }
+    }
+    ParkHandle handle(index, generationOf(info->state.load(std::memory_order_acquire)));
+    
+    // 添加到注册表
+    if (!options.unlisted) {
+        idShard.threads.emplace(threadId, handle);
+        nameShard.threads.emplace(threadName, handle);
+    }
     
-    std::cout << "Thread registered: " << threadName << std::endl;
-    // std::lock_guard会自动解锁
+    // 加入各个组（组分片锁总是在线程名/线程ID分片锁之后获取，且同一时刻只持有一个）
+    for (size_t i = 0; i < info->groups.size(); ++i) {
+        GroupShard& groupShard = groupShardFor(info->groups[i]);
+        std::unique_lock<std::shared_mutex> groupLock(groupShard.lock);
+        groupShard.groups[info->groups[i]].members.push_back(handle);
+    }
+    
+    // 在本线程内注册时直接缓存句柄
+    if (threadId == std::this_thread::get_id()) {
+        currentThreadHandle = handle;
+        currentThreadName = threadName;
+    }
+    
+    THREAD_LOG_INFO("Thread registered: " << threadName);
+    return handle;
+    // std::unique_lock会自动解锁
 }
 
-// 注销线程
+// 注销线程（线程ID）
 void ThreadManager::unregisterThread(std::thread::id threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+    ParkHandle handle = findHandle(threadId);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found for unregistration");
+        return;
+    }
+    unregisterThread(handle);
+}
+
+// 注销线程（注册句柄）
+void ThreadManager::unregisterThread(ParkHandle handle) {
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Thread not found for unregistration");
+        return;
+    }
     
-    auto it = threadMap.find(threadId);
-    if (it != threadMap.end()) {
-        std::string threadName = it->second.name;
-        
-        // 清理映射表
-        threadNameToId.erase(threadName);
-        threadMap.erase(it);
-        
-        std::cout << "Thread unregistered: " << threadName << std::endl;
-    } else {
-        std::cerr << "Error: Thread not found for unregistration" << std::endl;
+    // 递增槽位代数并回到RUNNING：成功的一方独占这次注销，旧句柄从此失效
+    // 正在睡眠的线程会看到状态字变化而退出等待
+    uint32_t word = info->state.load(std::memory_order_acquire);
+    do {
+        if (generationOf(word) != handle.generation) {
+            THREAD_LOG_ERROR("Error: Thread not found for unregistration");
+            return;
+        }
+    } while (!info->state.compare_exchange_weak(word, makeWord(nextGeneration(handle.generation), kRunning),
+                                                std::memory_order_seq_cst, std::memory_order_acquire));
+    
+    if (stateOf(word) == kParked) {
+        futexWake(&info->state);
     }
-    // std::lock_guard会自动解锁
+    
+    // 正在epoll中等待的线程通过eventfd得知自己被注销，之后consumeWakeups()返回0
+    signalWakeFd(*info);
+    info->wakeFdEnabled.store(false, std::memory_order_release);
+    info->mailbox.store(NULL, std::memory_order_release);
+    
+    // 槽位归还之前不会被复用，此时读取线程名和线程ID是安全的
+    std::string threadName = info->name;
+    std::thread::id threadId = info->threadId;
+    
+    // 从线程ID分片中移除（只移除仍指向本句柄的条目）
+    {
+        IdShard& idShard = idShardFor(threadId);
+        std::unique_lock<std::shared_mutex> idLock(idShard.lock);
+        auto it = idShard.threads.find(threadId);
+        if (it != idShard.threads.end() && it->second == handle) {
+            idShard.threads.erase(it);
+        }
+    } // 解锁线程ID分片（std::unique_lock离开作用域）
+    
+    // 从线程名分片中移除（只移除仍指向本句柄的条目）
+    {
+        NameShard& nameShard = nameShardFor(threadName);
+        std::unique_lock<std::shared_mutex> nameLock(nameShard.lock);
+        auto it = nameShard.threads.find(threadName);
+        if (it != nameShard.threads.end() && it->second == handle) {
+            nameShard.threads.erase(it);
+        }
+    } // 解锁线程名分片（std::unique_lock离开作用域）
+    
+    // 从各个组中移除，组内没有成员时删除该组
+    for (size_t i = 0; i < info->groups.size(); ++i) {
+        GroupShard& groupShard = groupShardFor(info->groups[i]);
+        std::unique_lock<std::shared_mutex> groupLock(groupShard.lock);
+        auto it = groupShard.groups.find(info->groups[i]);
+        if (it == groupShard.groups.end()) {
+            continue;
+        }
+        std::vector<ParkHandle>& members = it->second.members;
+        auto member = std::find(members.begin(), members.end(), handle);
+        if (member != members.end()) {
+            *member = members.back();
+            members.pop_back();
+        }
+        if (members.empty()) {
+            groupShard.groups.erase(it);
+        }
+    }
+    
+    if (currentThreadHandle == handle) {
+        currentThreadHandle = ParkHandle();
+        currentThreadName.clear();
+    }
+    releaseSlot(handle.index);
+    
+    THREAD_LOG_INFO("Thread unregistered: " << threadName);
 }
 
 // Sleep函数实现，不需要参数
 void ThreadManager::Sleep() {
-    std::thread::id currentThreadId = std::this_thread::get_id();
-    std::string threadName;
-    std::shared_ptr<std::mutex> mutex;
-    std::shared_ptr<std::condition_variable> cond;
+    parkUntil(kNoDeadline);
+}
+
+// 限时睡眠（相对时长）
+WakeReason ThreadManager::SleepFor(std::chrono::nanoseconds timeout) {
+    uint64_t now = spinClockNanos();
+    uint64_t nanos = timeout.count() > 0 ? static_cast<uint64_t>(timeout.count()) : 0;
+    return parkUntil(nanos < kNoDeadline - now ? now + nanos : kNoDeadline - 1);
+}
+
+// 限时睡眠（单调时钟上的截止时间）
+WakeReason ThreadManager::SleepUntil(std::chrono::steady_clock::time_point deadline) {
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    return parkUntil(nanos > 0 ? static_cast<uint64_t>(nanos) : 0);
+}
+
+// 睡眠直到被唤醒、被注销或到达截止时间
+WakeReason ThreadManager::parkUntil(uint64_t deadlineNanos) {
+    // 直接使用缓存的注册句柄，不查找注册表，也不加任何锁
+    ParkHandle handle = currentHandle();
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
     
-    // 加锁保护映射表，获取信息并设置睡眠状态
-    {
-        std::lock_guard<std::mutex> mapLock(mapMutex);
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Thread not registered!");
+        return kWakeUnregistered;
+    }
+    
+    // 记录本次睡眠所在的CPU，供WakeupNearestOfGroup()按距离选择（只是提示，不要求与状态字同步）
+    int cpu = CpuTopology::currentCpu();
+    if (cpu != info->lastCpu.load(std::memory_order_relaxed)) {
+        info->lastCpu.store(cpu, std::memory_order_relaxed);
+    }
+    
+    // 槽位被注销并复用时线程名会被改写，日志使用注册时缓存的线程名（currentThreadName）
+    uint32_t word = info->state.load(std::memory_order_acquire);
+    
+    // 有许可时消费一个许可并立即返回；否则RUNNING -> PARKING，宣告即将睡眠
+    for (;;) {
+        // 代数不匹配说明线程已被注销
+        if (generationOf(word) != handle.generation || stateOf(word) != kRunning) {
+            THREAD_LOG_ERROR("Error: Thread not registered!");
+            return kWakeUnregistered;
+        }
         
-        // 检查线程是否已注册
-        auto it = threadMap.find(currentThreadId);
-        if (it == threadMap.end()) {
-            std::cerr << "Error: Thread not registered!" << std::endl;
-            return;
+        if (permitsOf(word) > 0) {
+            if (info->state.compare_exchange_weak(word, word - kPermitUnit,
+                                                  std::memory_order_acquire, std::memory_order_acquire)) {
+                beginStatsWrite(info->stats);
+                bumpOwned(info->stats.sleeps, 1);
+                endStatsWrite(info->stats);
+                THREAD_LOG_INFO(currentThreadName << " consumed a pending wakeup");
+                return kWakeNotified;
+            }
+            continue;
         }
         
-        threadName = it->second.name;
-        mutex = it->second.mutex;
-        cond = it->second.cond;
-        it->second.sleeping = true;
-    } // 解锁映射表（std::lock_guard离开作用域）
-    
-    // 加锁线程互斥锁
-    std::unique_lock<std::mutex> threadLock(*mutex);
-    
-    std::cout << threadName << " is going to sleep..." << std::endl;
-    
-    // 等待条件变量，使用lambda表达式作为谓词
-    // 注意：即使notify_one()在wait()之前被调用，谓词也会检查sleeping状态
-    // 如果sleeping已经是false，wait()会立即返回，不会丢失通知
-    cond->wait(threadLock, [this, currentThreadId]() {
-        std::lock_guard<std::mutex> mapLock(mapMutex);
-        auto it = threadMap.find(currentThreadId);
-        if (it == threadMap.end()) {
-            return true; // 线程已注销，退出等待
-        }
-        return !it->second.sleeping;
-    });
-    
-    std::cout << threadName << " is woken up!" << std::endl;
-    // std::unique_lock会自动解锁
+        if (info->state.compare_exchange_weak(word, withState(word, kParking),
+                                              std::memory_order_seq_cst, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    
+    // 邮箱中已有消息（包括投递方看到RUNNING而没有唤醒本线程的消息）时不睡眠
+    // 先宣告PARKING再检查邮箱，与Post()“先入队再检查状态”构成Dekker式顺序，两者之间的fence保证不会互相错过
+    ThreadMailbox* mailbox = info->mailbox.load(std::memory_order_relaxed);
+    if (mailbox != NULL) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t expected = makeWord(handle.generation, kParking);
+        if (mailbox->hasMessages() &&
+            info->state.compare_exchange_strong(expected, makeWord(handle.generation, kRunning),
+                                                std::memory_order_acquire, std::memory_order_acquire)) {
+            beginStatsWrite(info->stats);
+            bumpOwned(info->stats.sleeps, 1);
+            endStatsWrite(info->stats);
+            return kWakeNotified;
+        }
+        // CAS失败说明通知已经到达（或线程已被注销），按正常流程处理
+    }
+    
+    THREAD_LOG_INFO(currentThreadName << " is going to sleep...");
+    
+    // 处于PARKING/PARKED时唤醒方只会投递通知，不会改变许可数，因此这里的许可数一定为0
+    const uint32_t parkingWord = makeWord(handle.generation, kParking);
+    const uint32_t parkedWord = makeWord(handle.generation, kParked);
+    
+    // 阻塞之前先按自旋策略在PARKING状态下自旋：唤醒间隔很短时，通知在自旋期间到达，省去双方的系统调用
+    // 限时睡眠的自旋时长不超过剩余时间
+    const SpinPolicy policy = getSpinPolicy();
+    const uint64_t sleepStart = spinClockNanos();
+    uint64_t budget = info->spinState.spinNanos(policy);
+    if (deadlineNanos != kNoDeadline) {
+        budget = std::min<uint64_t>(budget, deadlineNanos > sleepStart ? deadlineNanos - sleepStart : 0);
+    }
+    spinThenYield([&]() { return info->state.load(std::memory_order_relaxed) != parkingWord; },
+                  static_cast<uint32_t>(budget), policy.yieldCount);
+    
+    // PARKING -> PARKED：阻塞前最后一次确认；如果Wakeup()已经投递了通知，CAS失败，直接消费通知
+    // 截止时间已过则不再阻塞，直接尝试超时返回
+    bool timedOut = false;
+    bool blocked = false;
+    uint32_t expected = parkingWord;
+    if (deadlineNanos != kNoDeadline && spinClockNanos() >= deadlineNanos) {
+        timedOut = true;
+    } else if (info->state.compare_exchange_strong(expected, parkedWord,
+                                                   std::memory_order_seq_cst, std::memory_order_acquire)) {
+        blocked = true;
+        // 在状态字上等待，不持有任何互斥锁
+        // 被信号中断（EINTR）、虚假唤醒或超时时，循环重新检查状态字；被注销时代数改变，同样退出等待
+        expected = parkedWord;
+        while (info->state.load(std::memory_order_acquire) == parkedWord) {
+            if (deadlineNanos != kNoDeadline && spinClockNanos() >= deadlineNanos) {
+                timedOut = true;
+                break;
+            }
+            futexWait(&info->state, parkedWord, deadlineNanos);
+        }
+    }
+    
+    // 超时：PARKING/PARKED -> RUNNING；与Wakeup()的投递竞争，CAS失败说明通知已经到达（或线程已被注销），按唤醒处理
+    if (timedOut && !info->state.compare_exchange_strong(expected, withState(expected, kRunning),
+                                                         std::memory_order_acquire, std::memory_order_acquire)) {
+        timedOut = false;
+    }
+    
+    // NOTIFIED -> RUNNING：消费通知，保留期间累积的许可；代数改变说明线程在睡眠期间被注销，状态已由注销方复位
+    bool notified = false;
+    word = info->state.load(std::memory_order_acquire);
+    while (generationOf(word) == handle.generation && stateOf(word) == kNotified) {
+        if (info->state.compare_exchange_weak(word, withState(word, kRunning),
+                                              std::memory_order_acquire, std::memory_order_acquire)) {
+            notified = true;
+            break;
+        }
+    }
+    
+    // 更新统计；线程已被注销时槽位可能被复用，不再写入
+    const uint64_t resumed = spinClockNanos();
+    if (generationOf(word) == handle.generation) {
+        beginStatsWrite(info->stats);
+        bumpOwned(info->stats.sleeps, 1);
+        bumpOwned(info->stats.parks, 1);
+        bumpOwned(info->stats.parkedNanos, resumed - sleepStart);
+        if (timedOut) {
+            bumpOwned(info->stats.timeouts, 1);
+        }
+        if (notified && !blocked) {
+            bumpOwned(info->stats.spinWakeups, 1);
+        }
+        if (notified) {
+            uint64_t notifiedAt = info->stats.notifyNanos.load(std::memory_order_relaxed);
+            bumpOwned(info->stats.wakeLatency[latencyBucket(resumed > notifiedAt ? resumed - notifiedAt : 0)], 1);
+        }
+        endStatsWrite(info->stats);
+        
+        // 自适应模式：用本次实际等待时长更新下一次的自旋预算
+        if (policy.mode == SpinPolicy::kAdaptiveSpin) {
+            info->spinState.record(policy, resumed - sleepStart);
+        }
+    }
+    
+    if (generationOf(word) != handle.generation) {
+        THREAD_LOG_INFO(currentThreadName << " is unregistered while sleeping");
+        return kWakeUnregistered;
+    }
+    if (timedOut) {
+        THREAD_LOG_INFO(currentThreadName << " sleep timed out");
+        return kWakeTimeout;
+    }
+    THREAD_LOG_INFO(currentThreadName << " is woken up!");
+    return kWakeNotified;
+}
+
+// 当前线程的eventfd唤醒通道
+int ThreadManager::getWakeFd() {
+    ParkHandle handle = currentHandle();
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL || !info->wakeFdEnabled.load(std::memory_order_acquire)) {
+        return -1;
+    }
+    return info->wakeFd.load(std::memory_order_relaxed);
+}
+
+// 取走当前线程所有未消费的唤醒
+size_t ThreadManager::consumeWakeups() {
+    ParkHandle handle = currentHandle();
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Thread not registered!");
+        return 0;
+    }
+
+#ifdef __linux__
+    // 先清空eventfd计数：之后保存的许可都会伴随一次新的写入，描述符会再次可读
+    if (info->wakeFdEnabled.load(std::memory_order_acquire)) {
+        uint64_t count;
+        while (read(info->wakeFd.load(std::memory_order_relaxed), &count, sizeof(count)) < 0 && errno == EINTR) {
+        }
+    }
+#endif
+
+    // 再消费全部许可（只在RUNNING状态下由本线程执行）
+    uint32_t word = info->state.load(std::memory_order_acquire);
+    while (generationOf(word) == handle.generation && stateOf(word) == kRunning && permitsOf(word) > 0) {
+        if (info->state.compare_exchange_weak(word, makeWord(handle.generation, kRunning),
+                                              std::memory_order_acquire, std::memory_order_acquire)) {
+            return permitsOf(word);
+        }
+    }
+    return 0;
 }
 
 // 根据线程名唤醒线程
 void ThreadManager::Wakeup(const std::string& threadName) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+    // 在线程名分片中查找（只加所在分片的读锁，一次查找），唤醒本身不持有任何锁
+    ParkHandle handle = findHandle(threadName);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found: " << threadName);
+        return;
+    }
     
-    // 查找线程ID
-    auto nameIt = threadNameToId.find(threadName);
-    if (nameIt == threadNameToId.end()) {
-        std::cerr << "Error: Thread not found: " << threadName << std::endl;
+    // 检查线程是否在睡眠，是则唤醒
+    if (wakeThreadInfo(*slotAt(handle.index), handle.generation)) {
+        THREAD_LOG_INFO("Waking up thread: " << threadName);
+    }
+}
+
+// 根据线程ID唤醒线程
+void ThreadManager::Wakeup(std::thread::id threadId) {
+    // 检查线程是否已注册（只加所在分片的读锁），唤醒本身不持有任何锁
+    ParkHandle handle = findHandle(threadId);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found");
         return;
     }
     
-    std::thread::id threadId = nameIt->second;
-    auto it = threadMap.find(threadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not found" << std::endl;
+    // 检查线程是否在睡眠，是则唤醒
+    if (wakeThreadInfo(*slotAt(handle.index), handle.generation)) {
+        THREAD_LOG_INFO("Waking up thread: ID " << threadId);
+    }
+}
+
+// 根据注册句柄唤醒线程
+void ThreadManager::Wakeup(ParkHandle handle) {
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Invalid park handle");
         return;
     }
     
-    // 检查线程是否在睡眠
-    if (it->second.sleeping) {
-        it->second.sleeping = false;
-        it->second.cond->notify_one(); // 通知等待的线程
-        std::cout << "Waking up thread: " << threadName << std::endl;
+    // 句柄过期时代数不匹配，CAS失败，不会误唤醒复用该槽位的其他线程
+    if (wakeThreadInfo(*info, handle.generation)) {
+        THREAD_LOG_INFO("Waking up thread: slot " << handle.index);
     }
-    // std::lock_guard会自动解锁
 }
 
-// 根据线程ID唤醒线程
-void ThreadManager::Wakeup(std::thread::id threadId) {
-    // 使用std::lock_guard自动管理锁的生命周期
-    std::lock_guard<std::mutex> lock(mapMutex);
+// 只在目标正在睡眠时投递通知：调用者无需持有任何锁
+void ThreadManager::wakeIfSleeping(ThreadInfo& info, uint32_t generation) {
+    uint32_t word = info.state.load(std::memory_order_relaxed);
+    for (;;) {
+        if (generationOf(word) != generation) {
+            return;
+        }
+        
+        uint32_t state = stateOf(word);
+        if (state == kRunning) {
+            // 线程可能正在epoll中等待eventfd
+            signalWakeFd(info);
+            return;
+        }
+        if (state == kNotified) {
+            return;
+        }
+        
+        // PARKING/PARKED -> NOTIFIED，与deliverWakeup()相同
+        info.stats.notifyNanos.store(spinClockNanos(), std::memory_order_relaxed);
+        if (info.state.compare_exchange_weak(word, withState(word, kNotified),
+                                             std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            info.stats.wakeupsReceived.fetch_add(1, std::memory_order_relaxed);
+            if (state == kParked) {
+                futexWake(&info.state);
+            }
+            return;
+        }
+    }
+}
+
+// 向线程的邮箱投递消息（线程名）
+bool ThreadManager::Post(const std::string& threadName, const ThreadMessage& message) {
+    ParkHandle handle = findHandle(threadName);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found: " << threadName);
+        return false;
+    }
+    return Post(handle, message);
+}
+
+// 向线程的邮箱投递消息（注册句柄）
+bool ThreadManager::Post(ParkHandle handle, const ThreadMessage& message) {
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Invalid park handle");
+        return false;
+    }
     
-    // 检查线程是否已注册
-    auto it = threadMap.find(threadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not found" << std::endl;
-        return;
+    ThreadMailbox* mailbox = info->mailbox.load(std::memory_order_acquire);
+    if (mailbox == NULL || generationOf(info->state.load(std::memory_order_acquire)) != handle.generation) {
+        THREAD_LOG_ERROR("Error: Thread has no mailbox: slot " << handle.index);
+        return false;
+    }
+    if (!mailbox->push(message, handle.generation)) {
+        THREAD_LOG_WARN("Warning: Mailbox full, message dropped: slot " << handle.index);
+        return false;
     }
     
-    std::string threadName = it->second.name;
+    // 先发布消息再检查状态：目标已宣告睡眠则唤醒它，否则它在睡眠前一定能看到这条消息
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeIfSleeping(*info, handle.generation);
+    return true;
+}
+
+// 从当前线程的邮箱取出消息
+size_t ThreadManager::Receive(ThreadMessage* messages, size_t maxCount) {
+    ParkHandle handle = currentHandle();
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    ThreadMailbox* mailbox = info == NULL ? NULL : info->mailbox.load(std::memory_order_relaxed);
+    if (mailbox == NULL) {
+        THREAD_LOG_ERROR("Error: Thread has no mailbox!");
+        return 0;
+    }
+    
+    // 丢弃上一次注册残留的消息（代数不符）
+    size_t count = 0;
+    uint32_t generation;
+    while (count < maxCount && mailbox->pop(messages[count], generation)) {
+        if (generation == handle.generation) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 睡眠直到邮箱中有消息，返回取出的消息
+size_t ThreadManager::Sleep(ThreadMessage* messages, size_t maxCount) {
+    size_t count = Receive(messages, maxCount);
+    if (count > 0) {
+        return count;
+    }
+    parkUntil(kNoDeadline);
+    return Receive(messages, maxCount);
+}
+
+#ifdef __linux__
+// 信号处理函数中使用的原子操作必须是无锁的
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "WakeupFromSignal requires lock-free atomics");
+
+// 异步信号安全的唤醒
+// 整条路径只有：槽位块指针的原子读取、deliverWakeup()中的CAS和统计计数器的原子加法、
+// clock_gettime()（记录投递时间戳），以及FUTEX_WAKE或eventfd的write()，都是异步信号安全的
+bool ThreadManager::WakeupFromSignal(ParkHandle handle) {
+    const int savedErrno = errno;
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    DeliverResult result = info == NULL ? kNotDelivered : deliverWakeup(*info, handle.generation);
+    if (result == kDeliveredParked) {
+        futexWake(&info->state);
+    } else if (result == kDeliveredPermit) {
+        writeWakeFd(*info);
+    }
+    errno = savedErrno;
+    return result != kNotDelivered;
+}
+#endif
+
+// 批量唤醒（线程名）
+size_t ThreadManager::WakeupMany(const std::vector<std::string>& threadNames) {
+    // 按分片归类，每个分片只加一次读锁，一次性解析其中的全部线程名
+    std::vector<size_t> byShard[kRegistryShardCount];
+    for (size_t i = 0; i < threadNames.size(); ++i) {
+        byShard[shardIndex(std::hash<std::string>()(threadNames[i]), kRegistryShardCount)].push_back(i);
+    }
+    
+    std::vector<ParkHandle> handles;
+    handles.reserve(threadNames.size());
+    for (size_t s = 0; s < kRegistryShardCount; ++s) {
+        if (byShard[s].empty()) {
+            continue;
+        }
+        NameShard& shard = nameShards[s];
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        for (size_t k = 0; k < byShard[s].size(); ++k) {
+            const std::string& threadName = threadNames[byShard[s][k]];
+            auto it = shard.threads.find(threadName);
+            if (it == shard.threads.end()) {
+                THREAD_LOG_ERROR("Error: Thread not found: " << threadName);
+                continue;
+            }
+            handles.push_back(it->second);
+        }
+    } // 解锁后再唤醒，唤醒本身不持有任何锁
+    
+    size_t delivered = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up threads: " << delivered << " of " << threadNames.size());
+    return delivered;
+}
+
+// 批量唤醒（注册句柄）
+size_t ThreadManager::WakeupMany(const std::vector<ParkHandle>& handles) {
+    size_t delivered = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up threads: " << delivered << " of " << handles.size());
+    return delivered;
+}
+
+// 唤醒所有已注册线程
+size_t ThreadManager::WakeupAll() {
+    // 逐个分片加读锁收集句柄
+    std::vector<ParkHandle> handles;
+    for (size_t s = 0; s < kRegistryShardCount; ++s) {
+        IdShard& shard = idShards[s];
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        for (auto it = shard.threads.begin(); it != shard.threads.end(); ++it) {
+            handles.push_back(it->second);
+        }
+    }
+    
+    size_t delivered = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up all threads: " << delivered << " of " << handles.size());
+    return delivered;
+}
+
+// 唤醒组内全部线程
+size_t ThreadManager::WakeupGroup(const std::string& group) {
+    // 加读锁复制成员句柄，解锁后再唤醒
+    std::vector<ParkHandle> handles;
+    {
+        GroupShard& shard = groupShardFor(group);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        auto it = shard.groups.find(group);
+        if (it == shard.groups.end()) {
+            THREAD_LOG_ERROR("Error: Thread group not found: " << group);
+            return 0;
+        }
+        handles = it->second.members;
+    }
+    
+    size_t delivered = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up thread group: " << group << ", " << delivered << " of " << handles.size());
+    return delivered;
+}
+
+// 唤醒组内一个线程
+bool ThreadManager::WakeupOneOfGroup(const std::string& group) {
+    return wakeOneOfGroup(group, false);
+}
+
+// 唤醒组内离调用线程最近的一个成员
+bool ThreadManager::WakeupNearestOfGroup(const std::string& group) {
+    return wakeOneOfGroup(group, true);
+}
+
+// 唤醒组内一个成员
+bool ThreadManager::wakeOneOfGroup(const std::string& group, bool nearest) {
+    CpuTopology* topology = CpuTopology::getInstance();
+    CpuLocation here;
+    if (nearest) {
+        here = topology->currentLocation();
+    }
+    
+    ThreadInfo* target = NULL;
+    DeliverResult result = kNotDelivered;
+    {
+        GroupShard& shard = groupShardFor(group);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        auto it = shard.groups.find(group);
+        if (it == shard.groups.end()) {
+            THREAD_LOG_ERROR("Error: Thread group not found: " << group);
+            return false;
+        }
+        
+        // 从轮转位置开始找一个正在睡眠（PARKING/PARKED）的成员，同时在多个调用者之间分散唤醒；
+        // 按距离选择时找距离最近的一个，找到同一物理核上的成员即停止。投递失败（成员恰好醒来）时重新查找
+        // 持有读锁期间成员不会被移除，槽位不会被归还，投递本身只是CAS
+        const std::vector<ParkHandle>& members = it->second.members;
+        const size_t count = members.size();
+        const size_t start = it->second.cursor.fetch_add(1, std::memory_order_relaxed) % count;
+        for (size_t attempt = 0; attempt < count && result == kNotDelivered; ++attempt) {
+            size_t best = count;
+            CpuDistance bestDistance = kRemote;
+            for (size_t k = 0; k < count; ++k) {
+                const ParkHandle& member = members[(start + k) % count];
+                ThreadInfo* info = slotAt(member.index);
+                uint32_t word = info->state.load(std::memory_order_relaxed);
+                if (generationOf(word) != member.generation || (stateOf(word) != kParking && stateOf(word) != kParked)) {
+                    continue;
+                }
+                CpuDistance distance = kSameCore;
+                if (nearest) {
+                    CpuLocation there = topology->locationOf(info->lastCpu.load(std::memory_order_relaxed));
+                    distance = CpuTopology::distance(here, there);
+                }
+                if (best == count || distance < bestDistance) {
+                    best = (start + k) % count;
+                    bestDistance = distance;
+                    if (distance == kSameCore) {
+                        break;
+                    }
+                }
+            }
+            if (best == count) {
+                break;
+            }
+            target = slotAt(members[best].index);
+            result = deliverWakeup(*target, members[best].generation);
+        }
+        
+        // 没有成员在睡眠：投递给轮转到的成员，启用许可时保存为许可，下一次Sleep()立即返回
+        if (result == kNotDelivered) {
+            target = slotAt(members[start].index);
+            result = deliverWakeup(*target, members[start].generation);
+        }
+    } // 解锁后再执行FUTEX_WAKE，槽位地址在管理器生命周期内保持有效
+    
+    if (result == kDeliveredParked) {
+        futexWake(&target->state);
+    } else if (result == kDeliveredPermit) {
+        signalWakeFd(*target);
+    }
+    if (result != kNotDelivered) {
+        THREAD_LOG_INFO("Waking up one of thread group: " << group);
+    }
+    return result != kNotDelivered;
+}
+
+// 读取槽位的统计计数器
+bool ThreadManager::readStats(ThreadInfo& info, ParkHandle handle, ThreadStats& stats) {
+    ThreadStatsCounters& counters = info.stats;
+    
+    // seqlock读端：序号为偶数且读取前后一致时副本是一致的；本线程的写入很短，重试几次后让出CPU
+    for (int attempt = 0; ; ++attempt) {
+        uint32_t before = counters.sequence.load(std::memory_order_acquire);
+        if ((before & 1) == 0) {
+            stats.sleeps = counters.sleeps.load(std::memory_order_relaxed);
+            stats.parks = counters.parks.load(std::memory_order_relaxed);
+            stats.spinWakeups = counters.spinWakeups.load(std::memory_order_relaxed);
+            stats.parkedNanos = counters.parkedNanos.load(std::memory_order_relaxed);
+            stats.timeouts = counters.timeouts.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < ThreadStats::kWakeLatencyBuckets; ++i) {
+                stats.wakeLatency[i] = counters.wakeLatency[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (counters.sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        if (attempt >= 16) {
+            std::this_thread::yield();
+        }
+    }
+    stats.wakeupsReceived = counters.wakeupsReceived.load(std::memory_order_relaxed);
+    stats.redundantWakeups = counters.redundantWakeups.load(std::memory_order_relaxed);
+    stats.handle = handle;
+    stats.location = CpuTopology::getInstance()->locationOf(info.lastCpu.load(std::memory_order_relaxed));
+    
+    // 读取期间线程被注销（槽位可能已被清零复用），丢弃这份副本
+    return generationOf(info.state.load(std::memory_order_acquire)) == handle.generation;
+}
+
+// 获取所有已注册线程的统计快照
+std::vector<ThreadStats> ThreadManager::snapshotStats() {
+    std::vector<ThreadStats> result;
+    
+    // 逐个分片加读锁遍历：持有读锁期间注册表条目不会被移除，槽位不会被归还复用，线程名和线程ID可以安全读取
+    // 只阻塞同一分片上的注册和注销，不影响Sleep()和Wakeup()
+    for (size_t i = 0; i < kRegistryShardCount; ++i) {
+        IdShard& shard = idShards[i];
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        for (auto it = shard.threads.begin(); it != shard.threads.end(); ++it) {
+            ThreadInfo* info = slotAt(it->second.index);
+            ThreadStats stats;
+            stats.name = info->name;
+            stats.threadId = info->threadId;
+            if (readStats(*info, it->second, stats)) {
+                result.push_back(stats);
+            }
+        }
+    }
+    return result;
+}
+
+// 获取指定线程的统计快照
+bool ThreadManager::snapshotStats(ParkHandle handle, ThreadStats& stats) {
+    ThreadInfo* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        return false;
+    }
     
-    // 检查线程是否在睡眠
-    if (it->second.sleeping) {
-        it->second.sleeping = false;
-        it->second.cond->notify_one(); // 通知等待的线程
-        std::cout << "Waking up thread: " << threadName << std::endl;
+    // 槽位的归还和分配都持有slotMutex：持锁期间代数仍然匹配，说明槽位还没有被归还，线程名和线程ID可以安全读取
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        if (generationOf(info->state.load(std::memory_order_acquire)) != handle.generation) {
+            return false;
+        }
+        stats.name = info->name;
+        stats.threadId = info->threadId;
     }
-    // std::lock_guard会自动解锁
+    return readStats(*info, handle, stats);
 }
 
 // 全局Sleep函数
@@ -177,6 +1408,16 @@ void Sleep() {
     ThreadManager::getInstance()->Sleep();
 }
 
+// 全局限时睡眠函数（相对时长）
+WakeReason SleepFor(std::chrono::nanoseconds timeout) {
+    return ThreadManager::getInstance()->SleepFor(timeout);
+}
+
+// 全局限时睡眠函数（截止时间）
+WakeReason SleepUntil(std::chrono::steady_clock::time_point deadline) {
+    return ThreadManager::getInstance()->SleepUntil(deadline);
+}
+
 // 全局Wakeup函数（线程名）
 void Wakeup(const std::string& threadName) {
     ThreadManager::getInstance()->Wakeup(threadName);
@@ -186,3 +1427,65 @@ void Wakeup(const std::string& threadName) {
 void Wakeup(std::thread::id threadId) {
     ThreadManager::getInstance()->Wakeup(threadId);
 }
+
+// 全局Wakeup函数（注册句柄）
+void Wakeup(ParkHandle handle) {
+    ThreadManager::getInstance()->Wakeup(handle);
+}
+
+#ifdef __linux__
+// 全局异步信号安全的唤醒函数
+bool WakeupFromSignal(ParkHandle handle) {
+    return ThreadManager::getInstance()->WakeupFromSignal(handle);
+}
+#endif
+
+// 全局投递消息函数（线程名）
+bool Post(const std::string& threadName, const ThreadMessage& message) {
+    return ThreadManager::getInstance()->Post(threadName, message);
+}
+
+// 全局投递消息函数（注册句柄）
+bool Post(ParkHandle handle, const ThreadMessage& message) {
+    return ThreadManager::getInstance()->Post(handle, message);
+}
+
+// 全局取出消息函数
+size_t Receive(ThreadMessage* messages, size_t maxCount) {
+    return ThreadManager::getInstance()->Receive(messages, maxCount);
+}
+
+// 全局睡眠并取出消息函数
+size_t Sleep(ThreadMessage* messages, size_t maxCount) {
+    return ThreadManager::getInstance()->Sleep(messages, maxCount);
+}
+
+// 全局批量唤醒函数（线程名）
+size_t WakeupMany(const std::vector<std::string>& threadNames) {
+    return ThreadManager::getInstance()->WakeupMany(threadNames);
+}
+
+// 全局批量唤醒函数（注册句柄）
+size_t WakeupMany(const std::vector<ParkHandle>& handles) {
+    return ThreadManager::getInstance()->WakeupMany(handles);
+}
+
+// 全局唤醒所有线程函数
+size_t WakeupAll() {
+    return ThreadManager::getInstance()->WakeupAll();
+}
+
+// 全局按组唤醒函数
+size_t WakeupGroup(const std::string& group) {
+    return ThreadManager::getInstance()->WakeupGroup(group);
+}
+
+// 全局唤醒组内一个线程函数
+bool WakeupOneOfGroup(const std::string& group) {
+    return ThreadManager::getInstance()->WakeupOneOfGroup(group);
+}
+
+// 全局WakeupNearestOfGroup函数
+bool WakeupNearestOfGroup(const std::string& group) {
+    return ThreadManager::getInstance()->WakeupNearestOfGroup(group);
+}
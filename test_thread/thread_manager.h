@@ -2,25 +2,127 @@
 #define THREAD_MANAGER_H
 
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <mutex>
-#include <condition_variable>
+#include <shared_mutex>
 #include <thread>
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <chrono>
+#include "park_handle.h"
+#include "spin_policy.h"
+#include "cpu_topology.h"
 
+#if defined(_WIN32)
 #ifdef DLL_EXPORTS
 #define DLL_API __declspec(dllexport)
 #else
 #define DLL_API __declspec(dllimport)
 #endif
+#else
+#define DLL_API
+#endif
 
-// 线程信息结构体，包含所有线程相关信息
-struct ThreadInfo {
+// 线程注册选项
+struct RegisterOptions {
+    // 许可上限：0表示不启用许可（默认，线程未睡眠时收到的Wakeup被丢弃）
+    // 1表示二值许可：提前到达的Wakeup保存为一个许可，下一次Sleep()消费它并立即返回
+    // 大于1表示计数许可：最多累积permitLimit个未消费的Wakeup，超出部分被合并（上限255）
+    uint32_t permitLimit;
+    
+    // 线程所属的组（可以为空，也可以同时属于多个组），用于WakeupGroup()/WakeupOneOfGroup()
+    std::vector<std::string> groups;
+    
+    // 为线程创建eventfd唤醒通道（仅Linux）：线程可以把getWakeFd()返回的描述符加入自己的epoll/poll集合，
+    // Wakeup()在线程未睡眠时保存许可并写入eventfd，描述符可读后调用consumeWakeups()取走唤醒；
+    // 线程仍然可以调用Sleep()。启用时许可上限至少为1，否则线程在epoll中等待时收到的唤醒会被丢弃
+    bool wakeFd;
+    
+    // 邮箱容量（条消息，向上取整到2的幂，上限65536）：0表示不创建邮箱（默认）
+    // 启用后其他线程可以通过Post()向本线程投递定长消息，本线程通过Receive()或Sleep(messages, maxCount)取出
+    uint32_t mailboxCapacity;
+    
+    // 把线程绑定到这些CPU上（仅Linux，只能在线程自己注册时设置）：空表示不绑定（默认）
+    // 按NUMA节点绑定时可以使用CpuTopology::cpusOfNode()
+    std::vector<int> cpuAffinity;
+    
+    // 不加入线程名和线程ID注册表（只能在线程自己注册时设置），供TimerService等内部线程使用：
+    // 线程名不占用用户的命名空间（不会与同名的用户线程冲突），Wakeup(线程名/线程ID)、WakeupAll()和snapshotStats()都看不到它，
+    // 只能通过注册时返回的句柄唤醒和注销
+    bool unlisted;
+    
+    RegisterOptions() : permitLimit(0), wakeFd(false), mailboxCapacity(0), unlisted(false) {}
+};
+
+// 邮箱中的定长消息（64字节），投递和接收时按值复制，不分配内存
+struct ThreadMessage {
+    static const size_t kDataSize = 56;
+    
+    uint32_t type;                                     // 消息类型（由使用者定义）
+    uint32_t size;                                     // data中有效数据的字节数（由使用者定义）
+    unsigned char data[kDataSize];                     // 消息内容
+    
+    ThreadMessage() : type(0), size(0) {}
+};
+
+// 线程统计快照（见ThreadManager::snapshotStats()）
+struct ThreadStats {
+    // 唤醒延迟直方图的桶数：第k个桶统计[2^k, 2^(k+1))纳秒的样本（第0个桶包含0），最后一个桶包含所有更长的样本
+    static const size_t kWakeLatencyBuckets = 32;
+    
     std::string name;                                  // 线程名
-    std::shared_ptr<std::mutex> mutex;                // 互斥锁
-    std::shared_ptr<std::condition_variable> cond;    // 条件变量
-    bool sleeping{false};                              // 睡眠状态
+    std::thread::id threadId;                          // 线程ID
+    ParkHandle handle;                                 // 注册句柄
+    uint64_t sleeps;                                   // Sleep()次数（包括消费许可后立即返回的次数）
+    uint64_t parks;                                    // 其中真正等待唤醒的次数
+    uint64_t spinWakeups;                              // 其中在阻塞之前（自旋阶段）等到通知、没有进入内核的次数
+    uint64_t parkedNanos;                              // 等待唤醒的累计时间（纳秒）
+    uint64_t timeouts;                                 // 其中因到达截止时间而返回的次数
+    uint64_t wakeupsReceived;                          // 投递成功的Wakeup()次数（通知或许可）
+    uint64_t redundantWakeups;                         // 没有任何效果的Wakeup()次数（线程未睡眠且许可已满或未启用许可）
+    uint64_t wakeLatency[kWakeLatencyBuckets];         // 从Wakeup()投递通知到本线程恢复运行的延迟直方图
+    CpuLocation location;                              // 最近一次睡眠（或注册）时所在CPU的位置
+};
+
+// 每个线程的统计计数器
+// 本线程在Sleep()中写入的字段（sleeps/parks/spinWakeups/parkedNanos/timeouts/wakeLatency）由sequence保护（seqlock）：
+// 只有一个写入者，写入时不加锁也不使用原子读-改-写，快照方读取前后序号一致时得到一致的副本
+// 唤醒方写入的计数器（wakeupsReceived/redundantWakeups）有多个写入者，使用relaxed原子加法
+struct ThreadStatsCounters {
+    std::atomic<uint32_t> sequence{0};                 // seqlock序号，奇数表示本线程正在写入
+    std::atomic<uint64_t> sleeps{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> spinWakeups{0};
+    std::atomic<uint64_t> parkedNanos{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> wakeLatency[ThreadStats::kWakeLatencyBuckets]{};
+    std::atomic<uint64_t> wakeupsReceived{0};
+    std::atomic<uint64_t> redundantWakeups{0};
+    std::atomic<uint64_t> notifyNanos{0};              // 最近一次投递通知的时间戳（由唤醒方写入，用于计算唤醒延迟）
+};
+
+// 有界无锁多生产者单消费者邮箱（定义见thread_manager.cpp）
+struct ThreadMailbox;
+
+// 线程信息结构体，包含所有线程相关信息
+// 线程信息存放在管理器的槽位表中，地址在管理器生命周期内保持不变，注销后槽位被复用
+// 每个槽位按缓存行对齐并填充：唤醒方对状态字的CAS不会与相邻线程的槽位发生伪共享
+struct alignas(64) ThreadInfo {
+    std::string name;                                  // 线程名（只在本线程内或持有注册表锁时读取）
+    std::thread::id threadId;                          // 线程ID
+    std::atomic<uint32_t> state{0};                    // 状态字：高22位为槽位代数，中间8位为未消费的许可数，低2位为RUNNING/PARKING/PARKED/NOTIFIED（Linux下直接作为futex等待地址）
+    std::atomic<uint32_t> permitLimit{0};              // 许可上限（注册时写入）
+    std::atomic<int> lastCpu{-1};                      // 最近一次睡眠（或注册）时所在的CPU（由本线程写入，-1表示未知）
+    AdaptiveSpinState spinState;                       // 自适应自旋状态（本线程在Sleep()中读写，注册时复位）
+    ThreadStatsCounters stats;                         // 睡眠/唤醒统计
+    std::vector<std::string> groups;                   // 所属的组（注册时写入，注销时读取）
+    std::atomic<int> wakeFd{-1};                       // eventfd唤醒通道（随槽位创建一次，槽位复用时继续使用，不关闭）
+    std::atomic<bool> wakeFdEnabled{false};            // 本次注册是否启用eventfd唤醒通道
+    std::atomic<ThreadMailbox*> mailbox{nullptr};      // 本次注册的邮箱（未启用时为空）
+    ThreadMailbox* mailboxStorage{nullptr};            // 槽位持有的邮箱内存（随槽位复用，只在注册时读写）
 };
 
 class DLL_API ThreadManager {
@@ -30,13 +132,81 @@ public:
     // 用户线程调用的Sleep函数，不需要参数
     void Sleep();
     
+    // 限时睡眠：被唤醒、到达截止时间或被注销时返回，返回值说明醒来原因
+    // 截止时间基于单调时钟（std::chrono::steady_clock，Linux下即CLOCK_MONOTONIC），不受系统时间调整影响；
+    // 截止时间已过时仍会消费已到达的通知或许可，相当于一次不阻塞的检查
+    WakeReason SleepFor(std::chrono::nanoseconds timeout);
+    WakeReason SleepUntil(std::chrono::steady_clock::time_point deadline);
+    
     // 用户线程调用的Wakeup函数，可以传入线程名或线程id
     void Wakeup(const std::string& threadName);
     void Wakeup(std::thread::id threadId);
     
+    // 通过注册句柄唤醒线程，不查找注册表；句柄已失效时安全地忽略
+    void Wakeup(ParkHandle handle);
+
+#ifdef __linux__
+    // 异步信号安全的唤醒，可以在信号处理函数中调用（仅Linux）
+    // 只执行无锁的槽位访问、一次CAS，以及必要时一次FUTEX_WAKE或eventfd写入；不加锁、不分配内存、不记录日志，
+    // 并保存/恢复errno。句柄必须在安装信号处理函数之前取得（例如registerThread()的返回值）
+    // 返回是否投递了唤醒
+    bool WakeupFromSignal(ParkHandle handle);
+#endif
+
+    // 向线程的邮箱投递一条消息：无锁入队，只有目标正在睡眠时才唤醒它（目标在运行时会在下一次睡眠前看到消息）
+    // 目标未启用邮箱、邮箱已满或句柄已失效时返回false，消息被丢弃
+    bool Post(const std::string& threadName, const ThreadMessage& message);
+    bool Post(ParkHandle handle, const ThreadMessage& message);
+    
+    // 从当前线程的邮箱取出最多maxCount条消息（不阻塞），返回取出的条数
+    size_t Receive(ThreadMessage* messages, size_t maxCount);
+    
+    // 睡眠直到邮箱中有消息（或被Wakeup()唤醒、被注销），返回时取出最多maxCount条消息，返回取出的条数
+    // 邮箱中已有消息时不睡眠；只被Wakeup()唤醒时返回0
+    size_t Sleep(ThreadMessage* messages, size_t maxCount);
+    
+    // 批量唤醒：一次性解析全部目标（每个注册表分片只加一次读锁），释放锁之后先统一投递通知，
+    // 再集中唤醒已阻塞的线程；返回投递成功的唤醒数
+    size_t WakeupMany(const std::vector<std::string>& threadNames);
+    size_t WakeupMany(const std::vector<ParkHandle>& handles);
+    size_t WakeupAll();
+    
+    // 按组唤醒：组成员表在注册/注销时维护，唤醒时不遍历整个注册表
+    // WakeupGroup()唤醒组内全部线程，返回投递成功的唤醒数
+    // WakeupOneOfGroup()从轮转位置开始优先唤醒一个正在睡眠的成员；没有成员在睡眠时投递给轮转到的成员
+    // （启用许可时保存为许可），返回是否投递成功
+    size_t WakeupGroup(const std::string& group);
+    bool WakeupOneOfGroup(const std::string& group);
+    
+    // 同WakeupOneOfGroup()，但按与调用线程的距离选择正在睡眠的成员：优先同一物理核，其次共享最后一级缓存，
+    // 再次同一NUMA节点（成员的位置取其最近一次睡眠时所在的CPU），同等距离下从轮转位置开始选取
+    bool WakeupNearestOfGroup(const std::string& group);
+    
     // 内部使用的方法，用于注册和注销线程
-    void registerThread(const std::string& threadName, std::thread::id threadId);
+    // 注册成功返回有效句柄（失败返回无效句柄）；在本线程内注册时句柄同时缓存到线程局部变量中，供Sleep()直接使用
+    ParkHandle registerThread(const std::string& threadName, std::thread::id threadId);
+    ParkHandle registerThread(const std::string& threadName, std::thread::id threadId, const RegisterOptions& options);
     void unregisterThread(std::thread::id threadId);
+    void unregisterThread(ParkHandle handle);
+    
+    // 当前线程的eventfd唤醒通道，注册时未启用（或不是Linux）时返回-1
+    // 描述符在管理器生命周期内有效，不要关闭它
+    int getWakeFd();
+    
+    // 取走当前线程所有未消费的唤醒（清空eventfd计数并消费全部许可），返回取走的唤醒数（可能为0，即虚假唤醒）
+    // 先读eventfd再消费许可：在两者之间到达的Wakeup()会再次写入eventfd，不会丢失
+    size_t consumeWakeups();
+    
+    // 设置/获取Sleep()的自旋策略，对之后开始的Sleep()生效（默认不自旋）
+    // 自旋发生在PARKING状态：期间到达的Wakeup()只需一次CAS，双方都不进入内核
+    void setSpinPolicy(const SpinPolicy& policy);
+    SpinPolicy getSpinPolicy() const;
+    
+    // 获取所有已注册线程的统计快照；每个线程的快照是一致的副本，不会阻塞Sleep()和Wakeup()
+    std::vector<ThreadStats> snapshotStats();
+    
+    // 获取指定线程的统计快照，句柄已失效时返回false
+    bool snapshotStats(ParkHandle handle, ThreadStats& stats);
     
 private:
     ThreadManager();
@@ -44,21 +214,143 @@ private:
     ThreadManager(const ThreadManager&) = delete;
     ThreadManager& operator=(const ThreadManager&) = delete;
     
+    // 注册表分片数量（2的幂）
+    static const size_t kRegistryShardCount = 16;
+    
+    // 槽位表：按块分配（第一块在构造时预先分配），块指针原子发布，按下标访问槽位不需要加锁
+    static const uint32_t kSlotChunkSize = 64;
+    static const uint32_t kMaxSlotChunks = 1024;
+    
+    // 按线程ID分片的注册表，每个分片独立加读写锁，并按缓存行对齐避免分片之间的伪共享
+    struct alignas(64) IdShard {
+        std::shared_mutex lock;
+        std::unordered_map<std::thread::id, ParkHandle> threads;
+    };
+    
+    // 按线程名分片的注册表，线程名直接映射到注册句柄，唤醒时只需一次查找
+    struct alignas(64) NameShard {
+        std::shared_mutex lock;
+        std::unordered_map<std::string, ParkHandle> threads;
+    };
+    
+    // 组成员表：成员句柄列表和WakeupOneOfGroup()的轮转位置
+    struct Group {
+        std::vector<ParkHandle> members;
+        std::atomic<uint32_t> cursor{0};
+    };
+    
+    // 按组名分片的组注册表
+    struct alignas(64) GroupShard {
+        std::shared_mutex lock;
+        std::unordered_map<std::string, Group> groups;
+    };
+    
+    IdShard& idShardFor(std::thread::id threadId);
+    NameShard& nameShardFor(const std::string& threadName);
+    GroupShard& groupShardFor(const std::string& group);
+    
+    // 唤醒组内一个成员：nearest为true时选择离调用线程最近的正在睡眠的成员，否则选择轮转位置之后第一个正在睡眠的成员
+    bool wakeOneOfGroup(const std::string& group, bool nearest);
+    
+    // 在分片中查找注册句柄（只加分片读锁），未找到时返回无效句柄
+    ParkHandle findHandle(std::thread::id threadId);
+    ParkHandle findHandle(const std::string& threadName);
+    
+    // 当前线程的注册句柄：优先使用线程局部缓存，缓存失效时才查找注册表
+    ParkHandle currentHandle();
+    
+    // 按下标访问槽位（无锁），下标越界或所在块尚未分配时返回空指针
+    ThreadInfo* slotAt(uint32_t index);
+    
+    // 创建一个槽位块，槽位状态初始化为代数1、RUNNING
+    static ThreadInfo* createSlotChunk();
+    
+    // 分配/归还槽位
+    uint32_t allocateSlot();
+    void releaseSlot(uint32_t index);
+    
+    // 睡眠直到被唤醒、被注销或到达截止时间（单调时钟纳秒，kNoDeadline表示不限时）
+    static const uint64_t kNoDeadline = UINT64_MAX;
+    WakeReason parkUntil(uint64_t deadlineNanos);
+    
+    // 读取槽位的统计计数器（seqlock），读取期间槽位被注销时返回false
+    bool readStats(ThreadInfo& info, ParkHandle handle, ThreadStats& stats);
+    
+    // 投递结果：未投递（句柄过期或唤醒被合并）、已投递通知、已投递通知且目标已阻塞（需要FUTEX_WAKE）、
+    // 已保存为许可（目标未睡眠，启用eventfd时需要写入eventfd）
+    enum DeliverResult {
+        kNotDelivered,
+        kDelivered,
+        kDeliveredParked,
+        kDeliveredPermit
+    };
+    
+    // 投递一次唤醒（通知或许可），只做CAS，不执行系统调用
+    static DeliverResult deliverWakeup(ThreadInfo& info, uint32_t generation);
+    
+    // 只在目标正在睡眠（PARKING/PARKED）时投递通知，运行中的目标不保存许可（启用eventfd时写入eventfd）
+    static void wakeIfSleeping(ThreadInfo& info, uint32_t generation);
+    
+    // 写入线程的eventfd唤醒通道（未启用时不做任何事），失败时返回false且不记录日志（异步信号安全）
+    static bool writeWakeFd(ThreadInfo& info);
+    
+    // 同上，失败时记录日志
+    static void signalWakeFd(ThreadInfo& info);
+    
+    // 唤醒指定代数的线程：一次CAS，目标已阻塞时再加一次FUTEX_WAKE（保存为许可且启用eventfd时写入eventfd），
+    // 返回是否投递了通知
+    static bool wakeThreadInfo(ThreadInfo& info, uint32_t generation);
+    
+    // 批量唤醒已解析的句柄：先全部投递，再集中FUTEX_WAKE
+    size_t wakeHandles(const std::vector<ParkHandle>& handles);
+    
     static ThreadManager* instance;
     
-    // 线程信息映射（主键：线程ID）
-    std::map<std::thread::id, ThreadInfo> threadMap;
+    // 自旋策略，各字段分别原子读写；修改策略时正在开始的Sleep()可能混用新旧字段，不影响正确性
+    std::atomic<uint32_t> spinMode;
+    std::atomic<uint32_t> spinNanos;
+    std::atomic<uint32_t> spinYieldCount;
+    
+    // 槽位块指针
+    std::atomic<ThreadInfo*> slotChunks[kMaxSlotChunks];
     
-    // 线程名到线程ID的映射（用于快速查找）
-    std::map<std::string, std::thread::id> threadNameToId;
+    // 保护槽位分配的互斥锁（只在注册和注销时使用）
+    std::mutex slotMutex;
+    uint32_t slotCount;
+    std::vector<uint32_t> freeSlots;
     
-    // 保护映射表的互斥锁
-    std::mutex mapMutex;
+    // 因容量不足被替换的邮箱：投递方可能仍在访问，管理器销毁时才释放（由slotMutex保护）
+    std::vector<ThreadMailbox*> retiredMailboxes;
+    
+    // 线程信息注册表（主键：线程ID）
+    IdShard idShards[kRegistryShardCount];
+    
+    // 线程名注册表（主键：线程名）
+    NameShard nameShards[kRegistryShardCount];
+    
+    // 组注册表（主键：组名）
+    GroupShard groupShards[kRegistryShardCount];
 };
 
 // 方便用户使用的全局函数
 DLL_API void Sleep();
+DLL_API WakeReason SleepFor(std::chrono::nanoseconds timeout);
+DLL_API WakeReason SleepUntil(std::chrono::steady_clock::time_point deadline);
 DLL_API void Wakeup(const std::string& threadName);
 DLL_API void Wakeup(std::thread::id threadId);
+DLL_API void Wakeup(ParkHandle handle);
+#ifdef __linux__
+DLL_API bool WakeupFromSignal(ParkHandle handle);
+#endif
+DLL_API size_t WakeupMany(const std::vector<std::string>& threadNames);
+DLL_API size_t WakeupMany(const std::vector<ParkHandle>& handles);
+DLL_API size_t WakeupAll();
+DLL_API bool Post(const std::string& threadName, const ThreadMessage& message);
+DLL_API bool Post(ParkHandle handle, const ThreadMessage& message);
+DLL_API size_t Receive(ThreadMessage* messages, size_t maxCount);
+DLL_API size_t Sleep(ThreadMessage* messages, size_t maxCount);
+DLL_API size_t WakeupGroup(const std::string& group);
+DLL_API bool WakeupOneOfGroup(const std::string& group);
+DLL_API bool WakeupNearestOfGroup(const std::string& group);
 
 #endif // THREAD_MANAGER_H
\ No newline at end of file
@@ -1,48 +1,142 @@
 #define DLL_EXPORTS
 #include "thread_manager_pthread.h"
+#include "thread_log.h"
 #include <unistd.h>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <ctime>
+
+namespace {
+
+// 将散列值再次打散后取分片下标（shardCount为2的幂）
+// pthread_t通常是对齐的地址，低位几乎恒定，直接取模会让分片严重不均
+size_t shardIndex(size_t hash, size_t shardCount) {
+    uint64_t h = hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h) & (shardCount - 1);
+}
+
+// 无效槽位下标
+const uint32_t kInvalidSlot = 0xFFFFFFFFu;
+
+// 下一个代数，跳过0（0表示无效句柄）
+inline uint32_t nextGeneration(uint32_t generation) {
+    uint32_t next = generation + 1;
+    return next == 0 ? 1 : next;
+}
+
+// 当前线程的注册句柄缓存
+thread_local ParkHandle currentThreadHandle;
+
+// 当前线程的线程名（与注册句柄缓存一起设置），睡眠日志只使用这份副本，不读取可能被复用的槽位
+thread_local std::string currentThreadName;
+
+// 初始化使用CLOCK_MONOTONIC的条件变量：pthread_cond_timedwait()的截止时间不受系统时间调整影响
+int initMonotonicCond(pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+    int ret = pthread_condattr_init(&attr);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (ret == 0) {
+        ret = pthread_cond_init(cond, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+    return ret;
+}
+
+} // namespace
 
 // 静态实例初始化
 ThreadManagerPthread* ThreadManagerPthread::instance = new ThreadManagerPthread();
 
 // 构造函数
-ThreadManagerPthread::ThreadManagerPthread() : mapMutexInitialized(false) {
-    // 互斥锁将在第一次使用时懒加载初始化
-}
-
-// 初始化映射表互斥锁
-void ThreadManagerPthread::initMapMutex() {
-    if (!mapMutexInitialized) {
-        int ret = pthread_mutex_init(&mapMutex, NULL);
+ThreadManagerPthread::ThreadManagerPthread()
+    : spinMode(SpinPolicy::kNoSpin), spinNanos(0), spinYieldCount(0), slotCount(0), shardLocksInitialized(false) {
+    int ret;
+    
+    for (uint32_t i = 0; i < kMaxSlotChunks; ++i) {
+        slotChunks[i].store(NULL, std::memory_order_relaxed);
+    }
+    
+    // 预先分配第一个槽位块，常见规模的注册不需要再分配槽位内存和初始化条件变量（失败时推迟到第一次注册）
+    slotChunks[0].store(createSlotChunk(0), std::memory_order_relaxed);
+    freeSlots.reserve(kSlotChunkSize);
+    
+    // 初始化所有分片的读写锁和槽位分配互斥锁
+    // 任何一个失败时销毁已初始化的锁，之后的注册、注销和查找都返回失败，不会使用未初始化的锁
+    size_t initializedShards = 0;
+    for (; initializedShards < kRegistryShardCount; ++initializedShards) {
+        ret = pthread_rwlock_init(&idShards[initializedShards].lock, NULL);
         if (ret != 0) {
-            std::cerr << "Error: pthread_mutex_init failed for mapMutex: " << ret << std::endl;
-            return;
+            THREAD_LOG_ERROR("Error: pthread_rwlock_init failed for id shard " << initializedShards << ": " << ret);
+            break;
+        }
+        ret = pthread_rwlock_init(&nameShards[initializedShards].lock, NULL);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_rwlock_init failed for name shard " << initializedShards << ": " << ret);
+            pthread_rwlock_destroy(&idShards[initializedShards].lock);
+            break;
         }
-        mapMutexInitialized = true;
     }
+    if (initializedShards == kRegistryShardCount) {
+        ret = pthread_mutex_init(&slotMutex, NULL);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_mutex_init failed for slotMutex: " << ret);
+        }
+    }
+    if (ret != 0) {
+        for (size_t i = 0; i < initializedShards; ++i) {
+            pthread_rwlock_destroy(&idShards[i].lock);
+            pthread_rwlock_destroy(&nameShards[i].lock);
+        }
+        return;
+    }
+    shardLocksInitialized = true;
 }
 
 // 析构函数
 ThreadManagerPthread::~ThreadManagerPthread() {
     int ret;
     
-    // 清理所有线程的条件变量和互斥锁
-    for (auto& pair : threadMap) {
-        ret = pthread_cond_destroy(&pair.second.cond);
-        if (ret != 0) {
-            std::cerr << "Error: pthread_cond_destroy failed for thread " << pair.second.name << ": " << ret << std::endl;
+    // 清理所有已分配槽位的条件变量和互斥锁，并释放槽位块
+    for (uint32_t i = 0; i < kMaxSlotChunks; ++i) {
+        ThreadInfoPthread* chunk = slotChunks[i].load(std::memory_order_relaxed);
+        if (chunk == NULL) {
+            continue;
         }
-        ret = pthread_mutex_destroy(&pair.second.mutex);
-        if (ret != 0) {
-            std::cerr << "Error: pthread_mutex_destroy failed for thread " << pair.second.name << ": " << ret << std::endl;
+        for (uint32_t j = 0; j < kSlotChunkSize; ++j) {
+            ret = pthread_cond_destroy(&chunk[j].cond);
+            if (ret != 0) {
+                THREAD_LOG_ERROR("Error: pthread_cond_destroy failed for slot " << (i * kSlotChunkSize + j) << ": " << ret);
+            }
+            ret = pthread_mutex_destroy(&chunk[j].mutex);
+            if (ret != 0) {
+                THREAD_LOG_ERROR("Error: pthread_mutex_destroy failed for slot " << (i * kSlotChunkSize + j) << ": " << ret);
+            }
         }
+        delete[] chunk;
     }
     
-    // 只有当互斥锁初始化后才销毁它
-    if (mapMutexInitialized) {
-        ret = pthread_mutex_destroy(&mapMutex);
+    // 只有当锁初始化后才销毁它们
+    if (shardLocksInitialized) {
+        for (size_t i = 0; i < kRegistryShardCount; ++i) {
+            ret = pthread_rwlock_destroy(&idShards[i].lock);
+            if (ret != 0) {
+                THREAD_LOG_ERROR("Error: pthread_rwlock_destroy failed for id shard " << i << ": " << ret);
+            }
+            ret = pthread_rwlock_destroy(&nameShards[i].lock);
+            if (ret != 0) {
+                THREAD_LOG_ERROR("Error: pthread_rwlock_destroy failed for name shard " << i << ": " << ret);
+            }
+        }
+        ret = pthread_mutex_destroy(&slotMutex);
         if (ret != 0) {
-            std::cerr << "Error: pthread_mutex_destroy failed for mapMutex: " << ret << std::endl;
+            THREAD_LOG_ERROR("Error: pthread_mutex_destroy failed for slotMutex: " << ret);
         }
     }
 }
@@ -52,311 +146,740 @@ ThreadManagerPthread* ThreadManagerPthread::getInstance() {
     return instance;
 }
 
-// 注册线程
-void ThreadManagerPthread::registerThread(const std::string& threadName, pthread_t threadId) {
+// 构造时注册表锁是否初始化成功（失败时记录错误）
+bool ThreadManagerPthread::checkInitialized() const {
+    if (!shardLocksInitialized) {
+        THREAD_LOG_ERROR("Error: ThreadManagerPthread is not initialized");
+        return false;
+    }
+    return true;
+}
+
+// 根据线程ID选择注册表分片
+ThreadManagerPthread::IdShard& ThreadManagerPthread::idShardFor(pthread_t threadId) {
+    return idShards[shardIndex(std::hash<pthread_t>()(threadId), kRegistryShardCount)];
+}
+
+// 根据线程名选择注册表分片
+ThreadManagerPthread::NameShard& ThreadManagerPthread::nameShardFor(const std::string& threadName) {
+    return nameShards[shardIndex(std::hash<std::string>()(threadName), kRegistryShardCount)];
+}
+
+// 按线程ID查找注册句柄
+ParkHandle ThreadManagerPthread::findHandle(pthread_t threadId) {
+    if (!checkInitialized()) {
+        return ParkHandle();
+    }
+    
     int ret;
+    IdShard& shard = idShardFor(threadId);
     
-    // 懒加载初始化互斥锁
-    initMapMutex();
+    ret = pthread_rwlock_rdlock(&shard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_rdlock failed for id shard: " << ret);
+        return ParkHandle();
+    }
+    
+    ParkHandle handle;
+    auto it = shard.threads.find(threadId);
+    if (it != shard.threads.end()) {
+        handle = it->second;
+    }
     
-    // 加锁保护映射表
-    ret = pthread_mutex_lock(&mapMutex);
+    ret = pthread_rwlock_unlock(&shard.lock);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
-        return;
+        THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for id shard: " << ret);
+    }
+    return handle;
+}
+
+// 按线程名查找注册句柄
+ParkHandle ThreadManagerPthread::findHandle(const std::string& threadName) {
+    if (!checkInitialized()) {
+        return ParkHandle();
     }
     
-    // 检查线程是否已存在（通过线程ID）
-    if (threadMap.find(threadId) != threadMap.end()) {
-        std::cerr << "Error: Thread already registered: ID " << threadId << std::endl;
-        pthread_mutex_unlock(&mapMutex);
-        return;
+    int ret;
+    NameShard& shard = nameShardFor(threadName);
+    
+    ret = pthread_rwlock_rdlock(&shard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_rdlock failed for name shard: " << ret);
+        return ParkHandle();
     }
     
-    // 检查线程名是否已存在
-    if (threadNameToId.find(threadName) != threadNameToId.end()) {
-        std::cerr << "Error: Thread name already exists: " << threadName << std::endl;
-        pthread_mutex_unlock(&mapMutex);
-        return;
+    ParkHandle handle;
+    auto it = shard.threads.find(threadName);
+    if (it != shard.threads.end()) {
+        handle = it->second;
+    }
+    
+    ret = pthread_rwlock_unlock(&shard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for name shard: " << ret);
+    }
+    return handle;
+}
+
+// 按下标访问槽位
+ThreadInfoPthread* ThreadManagerPthread::slotAt(uint32_t index) {
+    if (index >= kMaxSlotChunks * kSlotChunkSize) {
+        return NULL;
+    }
+    ThreadInfoPthread* chunk = slotChunks[index / kSlotChunkSize].load(std::memory_order_acquire);
+    return chunk == NULL ? NULL : &chunk[index % kSlotChunkSize];
+}
+
+// 创建槽位块（按缓存行对齐）并初始化其中的条件变量和互斥锁
+ThreadInfoPthread* ThreadManagerPthread::createSlotChunk(uint32_t firstIndex) {
+    int ret;
+    ThreadInfoPthread* chunk = new ThreadInfoPthread[kSlotChunkSize];
+    uint32_t initialized = 0;
+    for (; initialized < kSlotChunkSize; ++initialized) {
+        ret = initMonotonicCond(&chunk[initialized].cond);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_cond_init failed for slot " << (firstIndex + initialized) << ": " << ret);
+            break;
+        }
+        ret = pthread_mutex_init(&chunk[initialized].mutex, NULL);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_mutex_init failed for slot " << (firstIndex + initialized) << ": " << ret);
+            pthread_cond_destroy(&chunk[initialized].cond); // 清理已初始化的条件变量
+            break;
+        }
+    }
+    if (initialized < kSlotChunkSize) {
+        // 清理已初始化的槽位
+        for (uint32_t i = 0; i < initialized; ++i) {
+            pthread_cond_destroy(&chunk[i].cond);
+            pthread_mutex_destroy(&chunk[i].mutex);
+        }
+        delete[] chunk;
+        return NULL;
     }
+    return chunk;
+}
+
+// 分配槽位：优先复用已注销的槽位，否则顺序分配，必要时分配新的槽位块
+uint32_t ThreadManagerPthread::allocateSlot() {
+    int ret;
+    uint32_t index = kInvalidSlot;
     
-    // 创建并初始化线程信息结构体
-    ThreadInfoPthread info;
-    info.name = threadName;
+    ret = pthread_mutex_lock(&slotMutex);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for slotMutex: " << ret);
+        return kInvalidSlot;
+    }
     
-    // 初始化条件变量
-    ret = pthread_cond_init(&info.cond, NULL);
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else if (slotCount < kMaxSlotChunks * kSlotChunkSize) {
+        bool ready = true;
+        if (slotChunks[slotCount / kSlotChunkSize].load(std::memory_order_relaxed) == NULL) {
+            ThreadInfoPthread* chunk = createSlotChunk(slotCount);
+            if (chunk == NULL) {
+                ready = false;
+            } else {
+                // 发布块指针，之后无锁读取的一方能看到初始化完成的槽位
+                slotChunks[slotCount / kSlotChunkSize].store(chunk, std::memory_order_release);
+            }
+        }
+        if (ready) {
+            index = slotCount++;
+        }
+    }
+    
+    ret = pthread_mutex_unlock(&slotMutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_cond_init failed for thread " << threadName << ": " << ret << std::endl;
-        pthread_mutex_unlock(&mapMutex);
-        return;
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for slotMutex: " << ret);
     }
+    return index;
+}
+
+// 归还槽位（槽位代数已在注销时递增）
+void ThreadManagerPthread::releaseSlot(uint32_t index) {
+    int ret;
     
-    // 初始化互斥锁
-    ret = pthread_mutex_init(&info.mutex, NULL);
+    ret = pthread_mutex_lock(&slotMutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_init failed for thread " << threadName << ": " << ret << std::endl;
-        pthread_cond_destroy(&info.cond); // 清理已初始化的条件变量
-        pthread_mutex_unlock(&mapMutex);
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for slotMutex: " << ret);
         return;
     }
     
-    // 添加到映射表
-    threadMap[threadId] = info;
-    threadNameToId[threadName] = threadId;
+    freeSlots.push_back(index);
+    
+    ret = pthread_mutex_unlock(&slotMutex);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for slotMutex: " << ret);
+    }
+}
+
+// 当前线程的注册句柄
+// 缓存的句柄在线程互斥锁内与槽位代数比较，线程被注销（或槽位被复用）后不再返回旧句柄
+ParkHandle ThreadManagerPthread::currentHandle() {
+    ParkHandle handle = currentThreadHandle;
+    ThreadInfoPthread* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info != NULL) {
+        int ret = pthread_mutex_lock(&info->mutex);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread handle check: " << ret);
+        } else {
+            bool current = info->generation == handle.generation;
+            pthread_mutex_unlock(&info->mutex);
+            if (current) {
+                return handle;
+            }
+        }
+    }
+    
+    // 缓存为空或已失效（例如由其他线程代为注册），查找注册表并刷新缓存
+    // 注销时先移除线程ID条目再归还槽位，持有分片读锁期间槽位中的线程名不会被改写
+    if (!checkInitialized()) {
+        return ParkHandle();
+    }
+    IdShard& shard = idShardFor(pthread_self());
+    int ret = pthread_rwlock_rdlock(&shard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_rdlock failed for id shard: " << ret);
+        return ParkHandle();
+    }
+    auto it = shard.threads.find(pthread_self());
+    handle = it == shard.threads.end() ? ParkHandle() : it->second;
+    currentThreadHandle = handle;
+    currentThreadName = handle.valid() ? slotAt(handle.index)->name : std::string();
+    ret = pthread_rwlock_unlock(&shard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for id shard: " << ret);
+    }
+    return handle;
+}
+
+// 设置自旋策略
+void ThreadManagerPthread::setSpinPolicy(const SpinPolicy& policy) {
+    spinNanos.store(policy.spinNanos, std::memory_order_relaxed);
+    spinYieldCount.store(policy.yieldCount, std::memory_order_relaxed);
+    spinMode.store(policy.mode, std::memory_order_relaxed);
+}
+
+// 获取自旋策略
+SpinPolicy ThreadManagerPthread::getSpinPolicy() const {
+    return SpinPolicy(static_cast<SpinPolicy::Mode>(spinMode.load(std::memory_order_relaxed)),
+                      spinNanos.load(std::memory_order_relaxed),
+                      spinYieldCount.load(std::memory_order_relaxed));
+}
+
+// 唤醒指定代数的线程：只加目标线程自己的互斥锁，不涉及注册表
+bool ThreadManagerPthread::wakeThreadInfo(ThreadInfoPthread& info, uint32_t generation) {
+    int ret;
+    bool woken = false;
     
-    std::cout << "Thread registered: " << threadName << " (ID: " << threadId << ")" << std::endl;
+    ret = pthread_mutex_lock(&info.mutex);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread wakeup: " << ret);
+        return false;
+    }
     
-    // 解锁
-    ret = pthread_mutex_unlock(&mapMutex);
+    // 检查句柄是否过期以及线程是否在睡眠
+    if (info.generation == generation && info.sleeping) {
+        info.sleeping = false;
+        ret = pthread_cond_signal(&info.cond);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_cond_signal failed for thread wakeup: " << ret);
+        } else {
+            woken = true;
+        }
+    }
+    
+    ret = pthread_mutex_unlock(&info.mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for thread wakeup: " << ret);
     }
+    return woken;
 }
 
-// 注销线程
-void ThreadManagerPthread::unregisterThread(pthread_t threadId) {
+// 注册线程
+ParkHandle ThreadManagerPthread::registerThread(const std::string& threadName, pthread_t threadId) {
+    if (!checkInitialized()) {
+        return ParkHandle();
+    }
+    
     int ret;
+    ParkHandle handle;
+    NameShard& nameShard = nameShardFor(threadName);
+    IdShard& idShard = idShardFor(threadId);
     
-    // 懒加载初始化互斥锁
-    initMapMutex();
+    // 固定按“线程名分片 -> 线程ID分片”的顺序加写锁，保证重复检查和插入是原子的
+    // 注册是唯一同时持有两个分片锁的地方，因此不会死锁
+    ret = pthread_rwlock_wrlock(&nameShard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_wrlock failed for name shard: " << ret);
+        return handle;
+    }
     
-    // 加锁保护映射表
-    ret = pthread_mutex_lock(&mapMutex);
+    ret = pthread_rwlock_wrlock(&idShard.lock);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
-        return;
+        THREAD_LOG_ERROR("Error: pthread_rwlock_wrlock failed for id shard: " << ret);
+        pthread_rwlock_unlock(&nameShard.lock);
+        return handle;
     }
     
-    auto it = threadMap.find(threadId);
-    if (it != threadMap.end()) {
-        std::string threadName = it->second.name;
+    do {
+        // 检查线程是否已存在（通过线程ID）
+        if (idShard.threads.find(threadId) != idShard.threads.end()) {
+            THREAD_LOG_ERROR("Error: Thread already registered: ID " << threadId);
+            break;
+        }
         
-        // 清理条件变量和互斥锁
-        ret = pthread_cond_destroy(&it->second.cond);
-        if (ret != 0) {
-            std::cerr << "Error: pthread_cond_destroy failed for thread " << threadName << ": " << ret << std::endl;
+        // 检查线程名是否已存在
+        if (nameShard.threads.find(threadName) != nameShard.threads.end()) {
+            THREAD_LOG_ERROR("Error: Thread name already exists: " << threadName);
+            break;
+        }
+        
+        // 分配槽位并初始化线程信息
+        uint32_t index = allocateSlot();
+        if (index == kInvalidSlot) {
+            THREAD_LOG_ERROR("Error: Too many registered threads: " << threadName);
+            break;
         }
         
-        ret = pthread_mutex_destroy(&it->second.mutex);
+        ThreadInfoPthread* info = slotAt(index);
+        
+        // 线程名、线程ID和自旋状态在线程互斥锁内写入，槽位被复用时新线程从不自旋的初始状态开始
+        ret = pthread_mutex_lock(&info->mutex);
         if (ret != 0) {
-            std::cerr << "Error: pthread_mutex_destroy failed for thread " << threadName << ": " << ret << std::endl;
+            THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread " << threadName << ": " << ret);
+            releaseSlot(index);
+            break;
         }
+        info->name = threadName;
+        info->threadId = threadId;
+        info->sleeping = false;
+        info->spinState.reset();
+        handle = ParkHandle(index, info->generation);
+        pthread_mutex_unlock(&info->mutex);
         
-        // 清理映射表
-        threadNameToId.erase(threadName);
-        threadMap.erase(it);
+        // 添加到注册表
+        idShard.threads[threadId] = handle;
+        nameShard.threads[threadName] = handle;
         
-        std::cout << "Thread unregistered: " << threadName << " (ID: " << threadId << ")" << std::endl;
-    } else {
-        std::cerr << "Error: Thread not found for unregistration: ID " << threadId << std::endl;
-    }
+        // 在本线程内注册时直接缓存句柄
+        if (pthread_equal(threadId, pthread_self())) {
+            currentThreadHandle = handle;
+            currentThreadName = threadName;
+        }
+        
+        THREAD_LOG_INFO("Thread registered: " << threadName << " (ID: " << threadId << ")");
+    } while (false);
     
-    // 解锁
-    ret = pthread_mutex_unlock(&mapMutex);
+    // 解锁（与加锁顺序相反）
+    ret = pthread_rwlock_unlock(&idShard.lock);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for id shard: " << ret);
     }
+    ret = pthread_rwlock_unlock(&nameShard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for name shard: " << ret);
+    }
+    return handle;
 }
 
-// Sleep函数实现，不需要参数
-void ThreadManagerPthread::Sleep() {
-    int ret;
-    pthread_t currentThreadId = pthread_self();
+// 注销线程（线程ID）
+void ThreadManagerPthread::unregisterThread(pthread_t threadId) {
+    ParkHandle handle = findHandle(threadId);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found for unregistration: ID " << threadId);
+        return;
+    }
+    unregisterThread(handle);
+}
+
+// 注销线程（注册句柄）
+void ThreadManagerPthread::unregisterThread(ParkHandle handle) {
+    if (!checkInitialized()) {
+        return;
+    }
     
-    // 懒加载初始化互斥锁
-    initMapMutex();
+    int ret;
+    ThreadInfoPthread* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Thread not found for unregistration");
+        return;
+    }
     
-    // 加锁保护映射表，获取信息并设置睡眠状态
-    ret = pthread_mutex_lock(&mapMutex);
+    // 在线程互斥锁内递增槽位代数：成功的一方独占这次注销，旧句柄从此失效
+    ret = pthread_mutex_lock(&info->mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread unregistration: " << ret);
         return;
     }
     
-    // 检查线程是否已注册
-    auto it = threadMap.find(currentThreadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not registered!" << std::endl;
-        pthread_mutex_unlock(&mapMutex);
+    if (info->generation != handle.generation) {
+        pthread_mutex_unlock(&info->mutex);
+        THREAD_LOG_ERROR("Error: Thread not found for unregistration");
         return;
     }
     
-    std::string threadName = it->second.name;
-    pthread_mutex_t& mutex = it->second.mutex;
-    pthread_cond_t& cond = it->second.cond;
-    it->second.sleeping = true;
+    info->generation = nextGeneration(info->generation);
     
-    // 解锁映射表
-    ret = pthread_mutex_unlock(&mapMutex);
-    if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
-        return;
+    // 如果线程仍在睡眠，唤醒它，使其退出等待
+    if (info->sleeping) {
+        info->sleeping = false;
+        ret = pthread_cond_broadcast(&info->cond);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_cond_broadcast failed for thread unregistration: " << ret);
+        }
     }
     
-    // 加锁线程互斥锁
-    ret = pthread_mutex_lock(&mutex);
+    ret = pthread_mutex_unlock(&info->mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for thread " << threadName << ": " << ret << std::endl;
-        return;
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for thread unregistration: " << ret);
     }
     
-    std::cout << threadName << " is going to sleep..." << std::endl;
+    // 槽位归还之前不会被复用，此时读取线程名和线程ID是安全的
+    std::string threadName = info->name;
+    pthread_t threadId = info->threadId;
     
-    // 等待条件变量
-    while (true) {
-        ret = pthread_mutex_lock(&mapMutex);
-        if (ret != 0) {
-            std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
-            pthread_mutex_unlock(&mutex);
-            return;
+    // 从线程ID分片中移除（只移除仍指向本句柄的条目）
+    IdShard& idShard = idShardFor(threadId);
+    ret = pthread_rwlock_wrlock(&idShard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_wrlock failed for id shard: " << ret);
+    } else {
+        auto it = idShard.threads.find(threadId);
+        if (it != idShard.threads.end() && it->second == handle) {
+            idShard.threads.erase(it);
         }
         
-        bool shouldWait = true;
-        auto it = threadMap.find(currentThreadId);
-        if (it != threadMap.end()) {
-            shouldWait = it->second.sleeping;
-        } else {
-            shouldWait = false; // 线程已注销，退出等待
+        ret = pthread_rwlock_unlock(&idShard.lock);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for id shard: " << ret);
+        }
+    }
+    
+    // 从线程名分片中移除（只移除仍指向本句柄的条目）
+    NameShard& nameShard = nameShardFor(threadName);
+    ret = pthread_rwlock_wrlock(&nameShard.lock);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_rwlock_wrlock failed for name shard: " << ret);
+    } else {
+        auto it = nameShard.threads.find(threadName);
+        if (it != nameShard.threads.end() && it->second == handle) {
+            nameShard.threads.erase(it);
         }
         
-        ret = pthread_mutex_unlock(&mapMutex);
+        ret = pthread_rwlock_unlock(&nameShard.lock);
         if (ret != 0) {
-            std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
-            pthread_mutex_unlock(&mutex);
-            return;
+            THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for name shard: " << ret);
         }
-        
-        if (!shouldWait) {
-            break;
+    }
+    
+    if (currentThreadHandle == handle) {
+        currentThreadHandle = ParkHandle();
+        currentThreadName.clear();
+    }
+    releaseSlot(handle.index);
+    
+    THREAD_LOG_INFO("Thread unregistered: " << threadName << " (ID: " << threadId << ")");
+}
+
+// Sleep函数实现，不需要参数
+void ThreadManagerPthread::Sleep() {
+    parkUntil(kNoDeadline);
+}
+
+// 限时睡眠（相对时长）
+WakeReason ThreadManagerPthread::SleepFor(std::chrono::nanoseconds timeout) {
+    uint64_t now = spinClockNanos();
+    uint64_t nanos = timeout.count() > 0 ? static_cast<uint64_t>(timeout.count()) : 0;
+    return parkUntil(nanos < kNoDeadline - now ? now + nanos : kNoDeadline - 1);
+}
+
+// 限时睡眠（单调时钟上的截止时间）
+WakeReason ThreadManagerPthread::SleepUntil(std::chrono::steady_clock::time_point deadline) {
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    return parkUntil(nanos > 0 ? static_cast<uint64_t>(nanos) : 0);
+}
+
+// 睡眠直到被唤醒、被注销或到达截止时间
+WakeReason ThreadManagerPthread::parkUntil(uint64_t deadlineNanos) {
+    int ret;
+    
+    // 直接使用缓存的注册句柄，不查找注册表
+    ParkHandle handle = currentHandle();
+    ThreadInfoPthread* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Thread not registered!");
+        return kWakeUnregistered;
+    }
+    
+    // 加锁线程互斥锁，睡眠状态和代数都由该锁保护，不再涉及注册表
+    ret = pthread_mutex_lock(&info->mutex);
+    if (ret != 0) {
+        THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread sleep: " << ret);
+        return kWakeUnregistered;
+    }
+    
+    // 代数不匹配说明缓存的句柄已失效（线程已被注销）
+    if (info->generation != handle.generation) {
+        pthread_mutex_unlock(&info->mutex);
+        currentThreadHandle = ParkHandle();
+        THREAD_LOG_ERROR("Error: Thread not registered!");
+        return kWakeUnregistered;
+    }
+    
+    // 等待条件变量期间槽位可能被注销并复用（线程名被改写），日志使用注册时缓存的线程名（currentThreadName）
+    
+    info->sleeping = true;
+    THREAD_LOG_INFO(currentThreadName << " is going to sleep...");
+    
+    // 阻塞之前先按自旋策略自旋：自旋期间释放线程互斥锁，只读取sleeping
+    // 唤醒间隔很短时，Wakeup()在自旋期间把sleeping置为false，双方都不需要进入内核
+    // 限时睡眠的自旋时长不超过剩余时间
+    const SpinPolicy policy = getSpinPolicy();
+    const uint64_t sleepStart = spinClockNanos();
+    uint64_t budget = info->spinState.spinNanos(policy);
+    if (deadlineNanos != kNoDeadline) {
+        budget = std::min<uint64_t>(budget, deadlineNanos > sleepStart ? deadlineNanos - sleepStart : 0);
+    }
+    if (budget > 0 || policy.yieldCount > 0) {
+        ret = pthread_mutex_unlock(&info->mutex);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for thread sleep: " << ret);
+            return kWakeUnregistered;
         }
         
-        ret = pthread_cond_wait(&cond, &mutex);
+        spinThenYield([&]() { return !info->sleeping.load(std::memory_order_acquire); },
+                      static_cast<uint32_t>(budget), policy.yieldCount);
+        
+        ret = pthread_mutex_lock(&info->mutex);
         if (ret != 0) {
-            // 在Linux上，EINTR表示被信号中断
-            // 在QNX上，被信号中断会返回EOK，不会进入此分支
-            std::cerr << "Error: pthread_cond_wait failed for thread " << threadName << ": " << ret << std::endl;
-            {
-                ret = pthread_mutex_lock(&mapMutex);
-                if (ret != 0) {
-                    std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
-                    pthread_mutex_unlock(&mutex);
-                    return;
-                }
-                auto it = threadMap.find(currentThreadId);
-                if (it != threadMap.end()) {
-                    it->second.sleeping = false;
-                }
-                ret = pthread_mutex_unlock(&mapMutex);
-                if (ret != 0) {
-                    std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
-                    pthread_mutex_unlock(&mutex);
-                    return;
-                }
+            THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread sleep: " << ret);
+            return kWakeUnregistered;
+        }
+    }
+    
+    // 截止时间：条件变量使用CLOCK_MONOTONIC，steady_clock的纳秒数可以直接作为绝对时间
+    struct timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadlineNanos / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadlineNanos % 1000000000ULL);
+    
+    // 等待条件变量，通过while循环检查sleeping和代数，防止虚假唤醒
+    // Wakeup和注销都会在线程互斥锁内将sleeping置为false；槽位被注销后复用时代数也会改变
+    bool timedOut = false;
+    while (info->sleeping && info->generation == handle.generation) {
+        if (deadlineNanos == kNoDeadline) {
+            ret = pthread_cond_wait(&info->cond, &info->mutex);
+        } else {
+            ret = pthread_cond_timedwait(&info->cond, &info->mutex, &deadline);
+        }
+        if (ret == ETIMEDOUT) {
+            // 超时与Wakeup()都在线程互斥锁内修改sleeping，此时sleeping仍为true说明唤醒没有到达
+            if (info->sleeping && info->generation == handle.generation) {
+                info->sleeping = false;
+                timedOut = true;
             }
             break;
         }
+        if (ret != 0) {
+            // POSIX规定pthread_cond_wait()/pthread_cond_timedwait()不会返回EINTR：被信号中断时在内部继续等待，
+            // 或者表现为一次虚假唤醒（由外层while循环重新检查），因此这里只可能是EINVAL/EPERM等使用错误
+            THREAD_LOG_ERROR("Error: pthread_cond_wait failed for thread slot " << handle.index << ": " << ret);
+            info->sleeping = false;  // 设置为false，确保状态一致
+            break;
+        }
         // 无论在Linux还是QNX上，都会执行到这里
-        // 通过while循环再次检查条件，防止虚假唤醒
     }
     
-    std::cout << threadName << " is woken up!" << std::endl;
+    // 自适应模式：用本次实际等待时长更新下一次的自旋预算
+    if (policy.mode == SpinPolicy::kAdaptiveSpin) {
+        info->spinState.record(policy, spinClockNanos() - sleepStart);
+    }
+    
+    WakeReason reason = kWakeNotified;
+    if (info->generation != handle.generation) {
+        reason = kWakeUnregistered;
+        THREAD_LOG_INFO(currentThreadName << " is unregistered while sleeping");
+    } else if (timedOut) {
+        reason = kWakeTimeout;
+        THREAD_LOG_INFO(currentThreadName << " sleep timed out");
+    } else {
+        THREAD_LOG_INFO(currentThreadName << " is woken up!");
+    }
     
     // 解锁线程互斥锁
-    ret = pthread_mutex_unlock(&mutex);
+    ret = pthread_mutex_unlock(&info->mutex);
     if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for thread " << threadName << ": " << ret << std::endl;
+        THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for thread sleep: " << ret);
     }
+    return reason;
 }
 
 // 根据线程名唤醒线程
 void ThreadManagerPthread::Wakeup(const std::string& threadName) {
-    int ret;
-    
-    // 懒加载初始化互斥锁
-    initMapMutex();
-    
-    // 加锁保护映射表
-    ret = pthread_mutex_lock(&mapMutex);
-    if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
+    // 在线程名分片中查找（只加所在分片的读锁，一次查找）
+    ParkHandle handle = findHandle(threadName);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found: " << threadName);
         return;
     }
     
-    // 查找线程ID
-    auto nameIt = threadNameToId.find(threadName);
-    if (nameIt == threadNameToId.end()) {
-        std::cerr << "Error: Thread not found: " << threadName << std::endl;
-        pthread_mutex_unlock(&mapMutex);
+    // 检查线程是否在睡眠，是则唤醒
+    if (wakeThreadInfo(*slotAt(handle.index), handle.generation)) {
+        THREAD_LOG_INFO("Waking up thread: " << threadName);
+    }
+}
+
+// 根据线程ID唤醒线程
+void ThreadManagerPthread::Wakeup(pthread_t threadId) {
+    // 检查线程是否已注册（只加所在分片的读锁）
+    ParkHandle handle = findHandle(threadId);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Thread not found: ID " << threadId);
         return;
     }
     
-    pthread_t threadId = nameIt->second;
-    auto it = threadMap.find(threadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not found: ID " << threadId << std::endl;
-        pthread_mutex_unlock(&mapMutex);
+    // 检查线程是否在睡眠，是则唤醒
+    if (wakeThreadInfo(*slotAt(handle.index), handle.generation)) {
+        THREAD_LOG_INFO("Waking up thread: ID " << threadId);
+    }
+}
+
+// 根据注册句柄唤醒线程
+void ThreadManagerPthread::Wakeup(ParkHandle handle) {
+    ThreadInfoPthread* info = handle.valid() ? slotAt(handle.index) : NULL;
+    if (info == NULL) {
+        THREAD_LOG_ERROR("Error: Invalid park handle");
         return;
     }
     
-    // 检查线程是否在睡眠
-    if (it->second.sleeping) {
-        it->second.sleeping = false;
-        ret = pthread_cond_signal(&it->second.cond);
+    // 句柄过期时代数不匹配，不会误唤醒复用该槽位的其他线程
+    if (wakeThreadInfo(*info, handle.generation)) {
+        THREAD_LOG_INFO("Waking up thread: slot " << handle.index);
+    }
+}
+
+// 批量唤醒已解析的句柄
+// 第一遍在各自的互斥锁内清除睡眠标志，第二遍在锁外发送信号：被唤醒的线程不会因为唤醒方仍持有互斥锁而再次阻塞
+// 槽位的条件变量在管理器生命周期内一直有效，即使期间线程被注销，多发的信号也只会被忽略
+size_t ThreadManagerPthread::wakeHandles(const std::vector<ParkHandle>& handles) {
+    int ret;
+    std::vector<ThreadInfoPthread*> woken;
+    
+    for (size_t i = 0; i < handles.size(); ++i) {
+        ThreadInfoPthread* info = handles[i].valid() ? slotAt(handles[i].index) : NULL;
+        if (info == NULL) {
+            continue;
+        }
+        
+        ret = pthread_mutex_lock(&info->mutex);
         if (ret != 0) {
-            std::cerr << "Error: pthread_cond_signal failed for thread " << threadName << ": " << ret << std::endl;
-        } else {
-            std::cout << "Waking up thread: " << threadName << " (ID: " << threadId << ")" << std::endl;
+            THREAD_LOG_ERROR("Error: pthread_mutex_lock failed for thread wakeup: " << ret);
+            continue;
+        }
+        if (info->generation == handles[i].generation && info->sleeping) {
+            info->sleeping = false;
+            woken.push_back(info);
+        }
+        ret = pthread_mutex_unlock(&info->mutex);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_mutex_unlock failed for thread wakeup: " << ret);
         }
     }
     
-    // 解锁
-    ret = pthread_mutex_unlock(&mapMutex);
-    if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
+    for (size_t i = 0; i < woken.size(); ++i) {
+        ret = pthread_cond_signal(&woken[i]->cond);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_cond_signal failed for thread wakeup: " << ret);
+        }
     }
+    return woken.size();
 }
 
-// 根据线程ID唤醒线程
-void ThreadManagerPthread::Wakeup(pthread_t threadId) {
+// 批量唤醒（线程名）
+size_t ThreadManagerPthread::WakeupMany(const std::vector<std::string>& threadNames) {
+    if (!checkInitialized()) {
+        return 0;
+    }
+    
     int ret;
     
-    // 懒加载初始化互斥锁
-    initMapMutex();
+    // 按分片归类，每个分片只加一次读锁，一次性解析其中的全部线程名
+    std::vector<size_t> byShard[kRegistryShardCount];
+    for (size_t i = 0; i < threadNames.size(); ++i) {
+        byShard[shardIndex(std::hash<std::string>()(threadNames[i]), kRegistryShardCount)].push_back(i);
+    }
     
-    // 加锁保护映射表
-    ret = pthread_mutex_lock(&mapMutex);
-    if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_lock failed for mapMutex: " << ret << std::endl;
-        return;
+    std::vector<ParkHandle> handles;
+    handles.reserve(threadNames.size());
+    for (size_t s = 0; s < kRegistryShardCount; ++s) {
+        if (byShard[s].empty()) {
+            continue;
+        }
+        NameShard& shard = nameShards[s];
+        ret = pthread_rwlock_rdlock(&shard.lock);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_rwlock_rdlock failed for name shard: " << ret);
+            continue;
+        }
+        for (size_t k = 0; k < byShard[s].size(); ++k) {
+            const std::string& threadName = threadNames[byShard[s][k]];
+            auto it = shard.threads.find(threadName);
+            if (it == shard.threads.end()) {
+                THREAD_LOG_ERROR("Error: Thread not found: " << threadName);
+                continue;
+            }
+            handles.push_back(it->second);
+        }
+        ret = pthread_rwlock_unlock(&shard.lock);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for name shard: " << ret);
+        }
     }
     
-    // 检查线程是否已注册
-    auto it = threadMap.find(threadId);
-    if (it == threadMap.end()) {
-        std::cerr << "Error: Thread not found: ID " << threadId << std::endl;
-        pthread_mutex_unlock(&mapMutex);
-        return;
+    // 解锁后再唤醒，唤醒本身不持有注册表锁
+    size_t woken = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up threads: " << woken << " of " << threadNames.size());
+    return woken;
+}
+
+// 批量唤醒（注册句柄）
+size_t ThreadManagerPthread::WakeupMany(const std::vector<ParkHandle>& handles) {
+    size_t woken = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up threads: " << woken << " of " << handles.size());
+    return woken;
+}
+
+// 唤醒所有已注册线程
+size_t ThreadManagerPthread::WakeupAll() {
+    if (!checkInitialized()) {
+        return 0;
     }
     
-    std::string threadName = it->second.name;
+    int ret;
     
-    // 检查线程是否在睡眠
-    if (it->second.sleeping) {
-        it->second.sleeping = false;
-        ret = pthread_cond_signal(&it->second.cond);
+    // 逐个分片加读锁收集句柄
+    std::vector<ParkHandle> handles;
+    for (size_t s = 0; s < kRegistryShardCount; ++s) {
+        IdShard& shard = idShards[s];
+        ret = pthread_rwlock_rdlock(&shard.lock);
         if (ret != 0) {
-            std::cerr << "Error: pthread_cond_signal failed for thread " << threadName << ": " << ret << std::endl;
-        } else {
-            std::cout << "Waking up thread: " << threadName << " (ID: " << threadId << ")" << std::endl;
+            THREAD_LOG_ERROR("Error: pthread_rwlock_rdlock failed for id shard: " << ret);
+            continue;
+        }
+        for (auto it = shard.threads.begin(); it != shard.threads.end(); ++it) {
+            handles.push_back(it->second);
+        }
+        ret = pthread_rwlock_unlock(&shard.lock);
+        if (ret != 0) {
+            THREAD_LOG_ERROR("Error: pthread_rwlock_unlock failed for id shard: " << ret);
         }
     }
     
-    // 解锁
-    ret = pthread_mutex_unlock(&mapMutex);
-    if (ret != 0) {
-        std::cerr << "Error: pthread_mutex_unlock failed for mapMutex: " << ret << std::endl;
-    }
+    size_t woken = wakeHandles(handles);
+    THREAD_LOG_INFO("Waking up all threads: " << woken << " of " << handles.size());
+    return woken;
 }
 
 // 全局Sleep函数
@@ -364,6 +887,16 @@ void SleepPthread() {
     ThreadManagerPthread::getInstance()->Sleep();
 }
 
+// 全局限时睡眠函数（相对时长）
+WakeReason SleepForPthread(std::chrono::nanoseconds timeout) {
+    return ThreadManagerPthread::getInstance()->SleepFor(timeout);
+}
+
+// 全局限时睡眠函数（截止时间）
+WakeReason SleepUntilPthread(std::chrono::steady_clock::time_point deadline) {
+    return ThreadManagerPthread::getInstance()->SleepUntil(deadline);
+}
+
 // 全局Wakeup函数（线程名）
 void WakeupPthread(const std::string& threadName) {
     ThreadManagerPthread::getInstance()->Wakeup(threadName);
@@ -373,3 +906,23 @@ void WakeupPthread(const std::string& threadName) {
 void WakeupPthread(pthread_t threadId) {
     ThreadManagerPthread::getInstance()->Wakeup(threadId);
 }
+
+// 全局Wakeup函数（注册句柄）
+void WakeupPthread(ParkHandle handle) {
+    ThreadManagerPthread::getInstance()->Wakeup(handle);
+}
+
+// 全局批量唤醒函数（线程名）
+size_t WakeupManyPthread(const std::vector<std::string>& threadNames) {
+    return ThreadManagerPthread::getInstance()->WakeupMany(threadNames);
+}
+
+// 全局批量唤醒函数（注册句柄）
+size_t WakeupManyPthread(const std::vector<ParkHandle>& handles) {
+    return ThreadManagerPthread::getInstance()->WakeupMany(handles);
+}
+
+// 全局唤醒所有线程函数
+size_t WakeupAllPthread() {
+    return ThreadManagerPthread::getInstance()->WakeupAll();
+}
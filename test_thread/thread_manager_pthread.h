@@ -2,21 +2,36 @@
 #define THREAD_MANAGER_PTHREAD_H
 
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
+#include <atomic>
+#include <cstdint>
 #include <pthread.h>
 #include <iostream>
 #include <cerrno>
+#include <chrono>
+#include "park_handle.h"
+#include "spin_policy.h"
 
+#if defined(_WIN32)
 #ifdef DLL_EXPORTS
 #define DLL_API __declspec(dllexport)
 #else
 #define DLL_API __declspec(dllimport)
 #endif
+#else
+#define DLL_API
+#endif
 
 // 线程信息结构体，包含所有线程相关信息
-struct ThreadInfoPthread {
-    std::string name;        // 线程名
-    bool sleeping{false};    // 睡眠状态
+// 线程信息存放在管理器的槽位表中，条件变量和互斥锁随槽位初始化一次，注销后槽位被复用
+// 每个槽位按缓存行对齐并填充，相邻线程的互斥锁和睡眠标志不会共享缓存行
+struct alignas(64) ThreadInfoPthread {
+    std::string name;        // 线程名（只在本线程内或持有注册表锁时读取）
+    pthread_t threadId;      // 线程ID
+    uint32_t generation{1};  // 槽位代数（由本线程的互斥锁保护），注销时递增
+    std::atomic<bool> sleeping{false};  // 睡眠状态（在本线程的互斥锁内修改，自旋阶段无锁读取）
+    AdaptiveSpinState spinState;        // 自适应自旋状态（本线程在Sleep()中读写，注册时复位）
     pthread_cond_t cond;     // 条件变量
     pthread_mutex_t mutex;   // 互斥锁
 };
@@ -28,13 +43,34 @@ public:
     // 用户线程调用的Sleep函数，不需要参数
     void Sleep();
     
+    // 限时睡眠：被唤醒、到达截止时间或被注销时返回，返回值说明醒来原因
+    // 条件变量使用CLOCK_MONOTONIC（pthread_condattr_setclock），截止时间不受系统时间调整影响
+    WakeReason SleepFor(std::chrono::nanoseconds timeout);
+    WakeReason SleepUntil(std::chrono::steady_clock::time_point deadline);
+    
     // 用户线程调用的Wakeup函数，可以传入线程名或线程id
     void Wakeup(const std::string& threadName);
     void Wakeup(pthread_t threadId);
     
+    // 通过注册句柄唤醒线程，不查找注册表；句柄已失效时安全地忽略
+    void Wakeup(ParkHandle handle);
+    
+    // 批量唤醒：一次性解析全部目标（每个注册表分片只加一次读锁），释放锁之后先逐个清除睡眠标志，
+    // 再集中发送条件变量信号；返回被唤醒的线程数
+    size_t WakeupMany(const std::vector<std::string>& threadNames);
+    size_t WakeupMany(const std::vector<ParkHandle>& handles);
+    size_t WakeupAll();
+    
     // 内部使用的方法，用于注册和注销线程
-    void registerThread(const std::string& threadName, pthread_t threadId);
+    // 注册成功返回有效句柄（失败返回无效句柄）；在本线程内注册时句柄同时缓存到线程局部变量中，供Sleep()直接使用
+    ParkHandle registerThread(const std::string& threadName, pthread_t threadId);
     void unregisterThread(pthread_t threadId);
+    void unregisterThread(ParkHandle handle);
+    
+    // 设置/获取Sleep()的自旋策略，对之后开始的Sleep()生效（默认不自旋）
+    // 自旋期间不持有线程互斥锁，Wakeup()加锁不会发生竞争，条件变量上也没有等待者，不需要系统调用
+    void setSpinPolicy(const SpinPolicy& policy);
+    SpinPolicy getSpinPolicy() const;
     
 private:
     ThreadManagerPthread();
@@ -42,27 +78,92 @@ private:
     ThreadManagerPthread(const ThreadManagerPthread&) = delete;
     ThreadManagerPthread& operator=(const ThreadManagerPthread&) = delete;
     
-    // 初始化映射表互斥锁
-    void initMapMutex();
+    // 注册表分片数量（2的幂）
+    static const size_t kRegistryShardCount = 16;
+    
+    // 槽位表：按块分配（第一块在构造时预先分配），块指针原子发布，按下标访问槽位不需要加锁
+    static const uint32_t kSlotChunkSize = 64;
+    static const uint32_t kMaxSlotChunks = 1024;
+    
+    // 按线程ID分片的注册表，每个分片独立加读写锁，并按缓存行对齐避免分片之间的伪共享
+    struct alignas(64) IdShard {
+        pthread_rwlock_t lock;
+        std::unordered_map<pthread_t, ParkHandle> threads;
+    };
+    
+    // 按线程名分片的注册表，线程名直接映射到注册句柄，唤醒时只需一次查找
+    struct alignas(64) NameShard {
+        pthread_rwlock_t lock;
+        std::unordered_map<std::string, ParkHandle> threads;
+    };
+    
+    IdShard& idShardFor(pthread_t threadId);
+    NameShard& nameShardFor(const std::string& threadName);
+    
+    // 在分片中查找注册句柄（只加分片读锁），未找到时返回无效句柄
+    ParkHandle findHandle(pthread_t threadId);
+    ParkHandle findHandle(const std::string& threadName);
+    
+    // 当前线程的注册句柄：优先使用线程局部缓存，缓存失效时才查找注册表
+    ParkHandle currentHandle();
+    
+    // 按下标访问槽位（无锁），下标越界或所在块尚未分配时返回空指针
+    ThreadInfoPthread* slotAt(uint32_t index);
+    
+    // 创建一个槽位块并初始化其中的条件变量和互斥锁，失败时返回空指针
+    ThreadInfoPthread* createSlotChunk(uint32_t firstIndex);
+    
+    // 分配/归还槽位
+    uint32_t allocateSlot();
+    void releaseSlot(uint32_t index);
+    
+    // 睡眠直到被唤醒、被注销或到达截止时间（单调时钟纳秒，kNoDeadline表示不限时）
+    static const uint64_t kNoDeadline = UINT64_MAX;
+    WakeReason parkUntil(uint64_t deadlineNanos);
+    
+    // 唤醒指定代数的线程，返回线程此前是否在睡眠
+    static bool wakeThreadInfo(ThreadInfoPthread& info, uint32_t generation);
+    
+    // 批量唤醒已解析的句柄
+    size_t wakeHandles(const std::vector<ParkHandle>& handles);
     
     static ThreadManagerPthread* instance;
     
-    // 线程信息映射（主键：线程ID）
-    std::map<pthread_t, ThreadInfoPthread> threadMap;
+    // 自旋策略，各字段分别原子读写；修改策略时正在开始的Sleep()可能混用新旧字段，不影响正确性
+    std::atomic<uint32_t> spinMode;
+    std::atomic<uint32_t> spinNanos;
+    std::atomic<uint32_t> spinYieldCount;
+    
+    // 槽位块指针
+    std::atomic<ThreadInfoPthread*> slotChunks[kMaxSlotChunks];
+    
+    // 保护槽位分配的互斥锁（只在注册和注销时使用）
+    pthread_mutex_t slotMutex;
+    uint32_t slotCount;
+    std::vector<uint32_t> freeSlots;
+    
+    // 线程信息注册表（主键：线程ID）
+    IdShard idShards[kRegistryShardCount];
     
-    // 线程名到线程ID的映射（用于快速查找）
-    std::map<std::string, pthread_t> threadNameToId;
+    // 线程名注册表（主键：线程名）
+    NameShard nameShards[kRegistryShardCount];
     
-    // 保护映射表的互斥锁
-    pthread_mutex_t mapMutex;
+    // 分片读写锁和槽位互斥锁初始化标志（全部初始化成功才为true）
+    bool shardLocksInitialized;
     
-    // 互斥锁初始化标志
-    bool mapMutexInitialized;
+    // 初始化失败时记录错误并返回false，注册、注销和查找注册表之前调用
+    bool checkInitialized() const;
 };
 
 // 方便用户使用的全局函数
 DLL_API void SleepPthread();
+DLL_API WakeReason SleepForPthread(std::chrono::nanoseconds timeout);
+DLL_API WakeReason SleepUntilPthread(std::chrono::steady_clock::time_point deadline);
 DLL_API void WakeupPthread(const std::string& threadName);
 DLL_API void WakeupPthread(pthread_t threadId);
+DLL_API void WakeupPthread(ParkHandle handle);
+DLL_API size_t WakeupManyPthread(const std::vector<std::string>& threadNames);
+DLL_API size_t WakeupManyPthread(const std::vector<ParkHandle>& handles);
+DLL_API size_t WakeupAllPthread();
 
 #endif // THREAD_MANAGER_PTHREAD_H
@@ -0,0 +1,379 @@
+#define DLL_EXPORTS
+#include "timer_service.h"
+#include "thread_log.h"
+#include "spin_policy.h"
+#include <algorithm>
+
+namespace {
+
+// 循环右移
+inline uint64_t rotateRight(uint64_t value, uint32_t shift) {
+    shift &= 63;
+    return shift == 0 ? value : (value >> shift) | (value << (64 - shift));
+}
+
+// 最低位1的位置（value不为0）
+inline uint32_t lowestBit(uint64_t value) {
+    uint32_t bit = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++bit;
+    }
+    return bit;
+}
+
+} // namespace
+
+// 静态实例初始化（内部线程在第一次添加定时器时才启动）
+TimerService* TimerService::instance = new TimerService();
+
+// 构造函数
+TimerService::TimerService() : pending(0), startNanos(spinClockNanos()), currentTick(0), wakeTick(UINT64_MAX),
+                               started(false) {
+    for (uint32_t level = 0; level < kWheelLevels; ++level) {
+        for (uint32_t slot = 0; slot < kWheelSlots; ++slot) {
+            heads[level][slot] = kNullEntry;
+        }
+        occupied[level] = 0;
+    }
+}
+
+// 析构函数（单例不会被销毁）
+TimerService::~TimerService() {
+}
+
+// 获取单例实例
+TimerService* TimerService::getInstance() {
+    return instance;
+}
+
+// 在delay之后唤醒一次目标
+TimerId TimerService::scheduleWakeup(const WakeTarget& target, std::chrono::nanoseconds delay) {
+    uint64_t now = spinClockNanos();
+    uint64_t nanos = delay.count() > 0 ? static_cast<uint64_t>(delay.count()) : 0;
+    
+    ParkHandle kick;
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = addTimer(target, now + nanos, 0, kick);
+    }
+    if (kick.valid()) {
+        ThreadManager::getInstance()->Wakeup(kick);
+    }
+    return id;
+}
+
+// 在指定时刻唤醒一次目标
+TimerId TimerService::scheduleWakeupAt(const WakeTarget& target, std::chrono::steady_clock::time_point when) {
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+    
+    ParkHandle kick;
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = addTimer(target, nanos > 0 ? static_cast<uint64_t>(nanos) : 0, 0, kick);
+    }
+    if (kick.valid()) {
+        ThreadManager::getInstance()->Wakeup(kick);
+    }
+    return id;
+}
+
+// 从现在起每隔period唤醒一次目标
+TimerId TimerService::schedulePeriodicWakeup(const WakeTarget& target, std::chrono::nanoseconds period) {
+    if (period.count() <= 0) {
+        THREAD_LOG_ERROR("Error: Timer period must be positive");
+        return TimerId();
+    }
+    uint64_t now = spinClockNanos();
+    uint64_t periodNanos = static_cast<uint64_t>(period.count());
+    
+    ParkHandle kick;
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = addTimer(target, now + periodNanos, periodNanos, kick);
+    }
+    if (kick.valid()) {
+        ThreadManager::getInstance()->Wakeup(kick);
+    }
+    return id;
+}
+
+// 取消定时器
+bool TimerService::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!id.valid() || id.index >= entries.size()) {
+        return false;
+    }
+    TimerEntry& entry = entries[id.index];
+    if (entry.generation != id.generation || !entry.active) {
+        return false;
+    }
+    unlink(id.index);
+    releaseEntry(id.index);
+    --pending;
+    return true;
+}
+
+// 尚未到期的定时器数量
+size_t TimerService::pendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending;
+}
+
+// 添加定时器
+TimerId TimerService::addTimer(const WakeTarget& target, uint64_t deadlineNanos, uint64_t periodNanos,
+                               ParkHandle& kick) {
+    if (!started) {
+        startThread();
+    }
+    
+    uint32_t index;
+    if (!freeEntries.empty()) {
+        index = freeEntries.back();
+        freeEntries.pop_back();
+    } else {
+        index = static_cast<uint32_t>(entries.size());
+        entries.push_back(TimerEntry());
+    }
+    
+    TimerEntry& entry = entries[index];
+    entry.target = target;
+    entry.deadlineNanos = deadlineNanos;
+    entry.periodNanos = periodNanos;
+    entry.expiryTick = tickOf(deadlineNanos);
+    link(index);
+    ++pending;
+    
+    // 新定时器早于内部线程的睡眠截止时间时提前唤醒它；内部线程正在运行时（wakeTick为0）会自行看到新定时器
+    if (serviceHandle.valid() && entry.expiryTick < wakeTick) {
+        wakeTick = entry.expiryTick;
+        kick = serviceHandle;
+    }
+    return TimerId(index, entry.generation);
+}
+
+// 截止时间对应的粒度序号（向上取整，定时器不会提前到期）
+uint64_t TimerService::tickOf(uint64_t deadlineNanos) const {
+    if (deadlineNanos <= startNanos) {
+        return 0;
+    }
+    return (deadlineNanos - startNanos + kTickNanos - 1) / kTickNanos;
+}
+
+// 把条目挂到时间轮上
+// 距离currentTick不足kWheelSlots^(L+1)个粒度的定时器放在第L层，槽位由到期粒度的第L组6位决定；
+// 这样每个槽位的级联时刻都在currentTick之后的64个块以内，nextEventTick()可以直接从位图找到
+void TimerService::link(uint32_t index) {
+    TimerEntry& entry = entries[index];
+    uint64_t tick = std::max(entry.expiryTick, currentTick);
+    uint64_t distance = tick - currentTick;
+    
+    uint32_t level = 0;
+    while (level + 1 < kWheelLevels && distance >= (1ULL << (kWheelBits * (level + 1)))) {
+        ++level;
+    }
+    // 超出时间轮范围：先放在最高层能容纳的最远位置，级联时按真实截止时间重新计算
+    const uint64_t range = 1ULL << (kWheelBits * kWheelLevels);
+    if (distance >= range) {
+        tick = currentTick + range - 1;
+    }
+    
+    uint32_t slot = static_cast<uint32_t>(tick >> (kWheelBits * level)) & (kWheelSlots - 1);
+    entry.level = static_cast<uint8_t>(level);
+    entry.slot = static_cast<uint8_t>(slot);
+    entry.prev = kNullEntry;
+    entry.next = heads[level][slot];
+    if (entry.next != kNullEntry) {
+        entries[entry.next].prev = index;
+    }
+    heads[level][slot] = index;
+    occupied[level] |= 1ULL << slot;
+    entry.active = true;
+}
+
+// 把条目从时间轮上摘下
+void TimerService::unlink(uint32_t index) {
+    TimerEntry& entry = entries[index];
+    if (entry.prev != kNullEntry) {
+        entries[entry.prev].next = entry.next;
+    } else {
+        heads[entry.level][entry.slot] = entry.next;
+    }
+    if (entry.next != kNullEntry) {
+        entries[entry.next].prev = entry.prev;
+    }
+    if (heads[entry.level][entry.slot] == kNullEntry) {
+        occupied[entry.level] &= ~(1ULL << entry.slot);
+    }
+    entry.prev = kNullEntry;
+    entry.next = kNullEntry;
+    entry.active = false;
+}
+
+// 下一个需要处理的粒度
+// 第0层：从currentTick所在槽位起循环查找第一个非空槽位，即最早的到期粒度
+// 第L层：从currentTick之后第一个块边界起循环查找第一个非空槽位，即最早需要级联的粒度
+uint64_t TimerService::nextEventTick() const {
+    uint64_t next = UINT64_MAX;
+    for (uint32_t level = 0; level < kWheelLevels; ++level) {
+        if (occupied[level] == 0) {
+            continue;
+        }
+        const uint32_t shift = kWheelBits * level;
+        uint64_t block = (currentTick + (1ULL << shift) - 1) >> shift;
+        uint64_t rotated = rotateRight(occupied[level], static_cast<uint32_t>(block & (kWheelSlots - 1)));
+        next = std::min(next, (block + lowestBit(rotated)) << shift);
+    }
+    return next;
+}
+
+// 处理到nowTick为止的全部粒度：直接跳到下一个有事件的粒度，空闲的粒度不逐个处理
+void TimerService::advance(uint64_t nowTick, std::vector<WakeTarget>& fired) {
+    for (;;) {
+        uint64_t tick = nextEventTick();
+        if (tick > nowTick) {
+            break;
+        }
+        currentTick = tick;
+        processTick(tick, fired);
+        currentTick = tick + 1;
+    }
+    if (currentTick <= nowTick) {
+        currentTick = nowTick + 1;
+    }
+}
+
+// 处理一个粒度
+void TimerService::processTick(uint64_t tick, std::vector<WakeTarget>& fired) {
+    // 级联：从高层到低层，到达块边界的层把当前块对应槽位中的条目按真实到期粒度重新挂到较低的层
+    for (uint32_t level = kWheelLevels - 1; level > 0; --level) {
+        const uint32_t shift = kWheelBits * level;
+        if ((tick & ((1ULL << shift) - 1)) != 0) {
+            continue;
+        }
+        uint32_t slot = static_cast<uint32_t>(tick >> shift) & (kWheelSlots - 1);
+        uint32_t index = heads[level][slot];
+        heads[level][slot] = kNullEntry;
+        occupied[level] &= ~(1ULL << slot);
+        while (index != kNullEntry) {
+            uint32_t next = entries[index].next;
+            link(index);
+            index = next;
+        }
+    }
+    
+    // 触发第0层对应槽位中的全部定时器（它们的到期粒度都等于tick）
+    uint32_t slot = static_cast<uint32_t>(tick) & (kWheelSlots - 1);
+    uint32_t index = heads[0][slot];
+    heads[0][slot] = kNullEntry;
+    occupied[0] &= ~(1ULL << slot);
+    
+    // 周期定时器：下一次截止时间 = 本次截止时间 + 周期，不受处理延迟影响；
+    // 已经落后超过一个周期时跳过错过的周期，保持相位不变
+    const uint64_t tickNanos = startNanos + tick * kTickNanos;
+    while (index != kNullEntry) {
+        TimerEntry& entry = entries[index];
+        uint32_t next = entry.next;
+        entry.active = false;
+        fired.push_back(entry.target);
+        
+        if (entry.periodNanos > 0) {
+            entry.deadlineNanos += entry.periodNanos;
+            if (entry.deadlineNanos <= tickNanos) {
+                entry.deadlineNanos += ((tickNanos - entry.deadlineNanos) / entry.periodNanos + 1) * entry.periodNanos;
+            }
+            entry.expiryTick = tickOf(entry.deadlineNanos);
+            link(index);
+        } else {
+            releaseEntry(index);
+            --pending;
+        }
+        index = next;
+    }
+}
+
+// 释放单次定时器的条目：代数递增，旧句柄失效
+void TimerService::releaseEntry(uint32_t index) {
+    TimerEntry& entry = entries[index];
+    entry.generation = entry.generation + 1 == 0 ? 1 : entry.generation + 1;
+    entry.active = false;
+    entry.target = WakeTarget(ParkHandle());
+    freeEntries.push_back(index);
+}
+
+// 启动内部线程
+void TimerService::startThread() {
+    started = true;
+    std::thread(&TimerService::run, this).detach();
+}
+
+// 内部线程：处理到期的定时器，然后用SleepUntil()睡眠到下一个事件
+void TimerService::run() {
+    RegisterOptions options;
+    options.permitLimit = 1;    // 睡眠之前到达的提前唤醒保存为许可，不会丢失
+    options.unlisted = true;    // 不占用用户的线程名，也不会被WakeupAll()唤醒，只通过serviceHandle唤醒
+    ParkHandle handle = ThreadManager::getInstance()->registerThread("timer_service", std::this_thread::get_id(),
+                                                                     options);
+    if (!handle.valid()) {
+        THREAD_LOG_ERROR("Error: Failed to register timer service thread");
+        return;
+    }
+    THREAD_LOG_INFO("Timer service started");
+    
+    std::vector<WakeTarget> fired;
+    std::unique_lock<std::mutex> lock(mutex);
+    serviceHandle = handle;
+    for (;;) {
+        wakeTick = 0;
+        uint64_t now = spinClockNanos();
+        advance(now > startNanos ? (now - startNanos) / kTickNanos : 0, fired);
+        
+        // 解锁后再唤醒目标，唤醒期间添加和取消定时器不会被阻塞
+        if (!fired.empty()) {
+            lock.unlock();
+            deliver(fired);
+            fired.clear();
+            lock.lock();
+            continue;
+        }
+        
+        uint64_t next = nextEventTick();
+        wakeTick = next;
+        lock.unlock();
+        if (next == UINT64_MAX) {
+            ThreadManager::getInstance()->Sleep();
+        } else {
+            ThreadManager::getInstance()->SleepUntil(std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(startNanos + next * kTickNanos)));
+        }
+        lock.lock();
+    }
+}
+
+// 唤醒到期的目标：线程名和注册句柄分别合并为一次批量唤醒
+void TimerService::deliver(const std::vector<WakeTarget>& fired) {
+    std::vector<std::string> names;
+    std::vector<ParkHandle> handles;
+    for (size_t i = 0; i < fired.size(); ++i) {
+        switch (fired[i].kind) {
+        case WakeTarget::kByName:
+            names.push_back(fired[i].name);
+            break;
+        case WakeTarget::kById:
+            ThreadManager::getInstance()->Wakeup(fired[i].threadId);
+            break;
+        case WakeTarget::kByHandle:
+            handles.push_back(fired[i].handle);
+            break;
+        }
+    }
+    if (!names.empty()) {
+        ThreadManager::getInstance()->WakeupMany(names);
+    }
+    if (!handles.empty()) {
+        ThreadManager::getInstance()->WakeupMany(handles);
+    }
+}
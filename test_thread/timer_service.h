@@ -0,0 +1,159 @@
+#ifndef TIMER_SERVICE_H
+#define TIMER_SERVICE_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "park_handle.h"
+#include "thread_manager.h"
+
+// 定时唤醒的目标：线程名、线程ID或注册句柄，到期时分别走ThreadManager对应的唤醒路径
+struct WakeTarget {
+    enum Kind {
+        kByName,
+        kById,
+        kByHandle
+    };
+    
+    Kind kind;
+    std::string name;
+    std::thread::id threadId;
+    ParkHandle handle;
+    
+    WakeTarget(const std::string& threadName) : kind(kByName), name(threadName) {}
+    WakeTarget(const char* threadName) : kind(kByName), name(threadName) {}
+    WakeTarget(std::thread::id id) : kind(kById), threadId(id) {}
+    WakeTarget(ParkHandle parkHandle) : kind(kByHandle), handle(parkHandle) {}
+};
+
+// 定时器句柄：条目下标 + 代数，定时器到期（单次）或被取消后代数递增，旧句柄失效
+struct TimerId {
+    uint32_t index;
+    uint32_t generation;    // 0表示无效句柄
+    
+    TimerId() : index(0), generation(0) {}
+    TimerId(uint32_t index, uint32_t generation) : index(index), generation(generation) {}
+    
+    bool valid() const { return generation != 0; }
+    
+    bool operator==(const TimerId& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const TimerId& other) const {
+        return !(*this == other);
+    }
+};
+
+// 定时唤醒服务：所有定时器由一个内部线程通过分层时间轮统一管理，到期时调用ThreadManager的Wakeup
+// 内部线程本身也注册到ThreadManager（不加入注册表，不占用用户的线程名），用SleepUntil()等待下一个到期时间，新定时器更早到期时被Wakeup()提前唤醒
+// 周期定时器按“上次截止时间 + 周期”计算下一次截止时间，不会因处理延迟而累积漂移；
+// 落后超过一个周期时跳过错过的周期，保持原有相位，不会集中补发
+class DLL_API TimerService {
+public:
+    static TimerService* getInstance();
+    
+    // 时间轮精度：截止时间向上取整到该粒度，定时器不会提前到期，最多延迟一个粒度
+    static const uint64_t kTickNanos = 100 * 1000;
+    
+    // 在delay之后唤醒一次目标
+    TimerId scheduleWakeup(const WakeTarget& target, std::chrono::nanoseconds delay);
+    
+    // 在指定时刻（单调时钟）唤醒一次目标
+    TimerId scheduleWakeupAt(const WakeTarget& target, std::chrono::steady_clock::time_point when);
+    
+    // 从现在起每隔period唤醒一次目标，直到被取消
+    TimerId schedulePeriodicWakeup(const WakeTarget& target, std::chrono::nanoseconds period);
+    
+    // 取消定时器，定时器已到期（单次）或已被取消时返回false
+    bool cancel(TimerId id);
+    
+    // 尚未到期的定时器数量
+    size_t pendingCount();
+    
+private:
+    TimerService();
+    ~TimerService();
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+    
+    // 时间轮：kWheelLevels层，每层kWheelSlots个槽，第L层每个槽覆盖kWheelSlots^L个粒度
+    // 5层 x 64槽、100微秒粒度可以直接容纳约29.8小时以内的定时器，更远的先放在最高层，级联时重新计算位置
+    static const uint32_t kWheelBits = 6;
+    static const uint32_t kWheelSlots = 1u << kWheelBits;
+    static const uint32_t kWheelLevels = 5;
+    
+    // 空链表/空闲条目的下标
+    static const uint32_t kNullEntry = 0xFFFFFFFFu;
+    
+    // 定时器条目，通过prev/next挂在时间轮的槽位链表上，取消时O(1)摘除
+    struct TimerEntry {
+        WakeTarget target;
+        uint64_t deadlineNanos;     // 截止时间（单调时钟纳秒）
+        uint64_t periodNanos;       // 周期，0表示单次定时器
+        uint64_t expiryTick;        // 截止时间对应的粒度序号（向上取整）
+        uint32_t generation;
+        uint32_t prev;
+        uint32_t next;
+        uint8_t level;
+        uint8_t slot;
+        bool active;                // 是否挂在时间轮上
+        
+        TimerEntry() : target(ParkHandle()), deadlineNanos(0), periodNanos(0), expiryTick(0), generation(1),
+                       prev(kNullEntry), next(kNullEntry), level(0), slot(0), active(false) {}
+    };
+    
+    // 添加定时器（持有mutex时调用），返回定时器句柄；需要提前唤醒内部线程时kick被设为它的注册句柄
+    TimerId addTimer(const WakeTarget& target, uint64_t deadlineNanos, uint64_t periodNanos, ParkHandle& kick);
+    
+    // 截止时间对应的粒度序号
+    uint64_t tickOf(uint64_t deadlineNanos) const;
+    
+    // 把条目挂到/摘下时间轮的槽位
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    
+    // 从currentTick起下一个需要处理的粒度（到期或级联），时间轮为空时返回UINT64_MAX
+    uint64_t nextEventTick() const;
+    
+    // 处理到nowTick为止的全部粒度，到期的目标追加到fired
+    void advance(uint64_t nowTick, std::vector<WakeTarget>& fired);
+    
+    // 处理一个粒度：级联上层到期的槽位，再触发第0层对应槽位中的全部定时器
+    void processTick(uint64_t tick, std::vector<WakeTarget>& fired);
+    
+    // 释放单次定时器的条目
+    void releaseEntry(uint32_t index);
+    
+    // 启动内部线程（持有mutex时调用）
+    void startThread();
+    
+    // 内部线程
+    void run();
+    
+    // 唤醒到期的目标（不持有mutex）
+    static void deliver(const std::vector<WakeTarget>& fired);
+    
+    static TimerService* instance;
+    
+    // 保护以下全部字段
+    std::mutex mutex;
+    
+    std::vector<TimerEntry> entries;
+    std::vector<uint32_t> freeEntries;
+    size_t pending;
+    
+    uint32_t heads[kWheelLevels][kWheelSlots];     // 各槽位链表头
+    uint64_t occupied[kWheelLevels];               // 各层非空槽位的位图
+    
+    uint64_t startNanos;        // 粒度0对应的时刻
+    uint64_t currentTick;       // 下一个待处理的粒度，之前的粒度都已处理
+    uint64_t wakeTick;          // 内部线程睡眠到哪个粒度（UINT64_MAX表示无限期睡眠，0表示正在运行）
+    
+    bool started;
+    ParkHandle serviceHandle;   // 内部线程的注册句柄
+};
+
+#endif // TIMER_SERVICE_H